@@ -0,0 +1,79 @@
+// Heap allocations per request on the HttpClient path, against a running
+// S3 endpoint (the MinIO container of the tests will do)
+//
+//     ./http_bench [url] [requests]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <s3cpp/auth.h>
+#include <s3cpp/httpclient.h>
+#include <string>
+
+// Only the allocations made through operator new, the ones libcurl makes on
+// its own go through malloc and are left out
+std::atomic<size_t> allocations = 0;
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    allocations++;
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+std::string hostOf(const std::string& url) {
+    size_t start = url.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    return url.substr(start, url.find('/', start) - start);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string url = argc > 1 ? argv[1] : "http://127.0.0.1:9000/";
+    const int requests = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const std::string host = hostOf(url);
+
+    HttpClient client;
+    AWSSigV4Signer signer("minio_access", "minio_secret");
+
+    // Warm up the connection, the signing key and the handle pool
+    HttpRequest warmup = client.get(url).header("Host", host);
+    signer.sign(warmup);
+    warmup.execute();
+
+    size_t build = 0;
+    size_t execute = 0;
+    size_t responseHeaders = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; i++) {
+        size_t before = allocations;
+        HttpRequest request = client.get(url).header("Host", host);
+        signer.sign(request);
+        build += allocations - before;
+
+        before = allocations;
+        HttpResponse response = request.execute();
+        execute += allocations - before;
+        responseHeaders += response.headers().size();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("%-32s %8.1f allocations/request\n", "build + sign", static_cast<double>(build) / requests);
+    std::printf("%-32s %8.1f allocations/request (%.1f response headers)\n", "execute", static_cast<double>(execute) / requests,
+        static_cast<double>(responseHeaders) / requests);
+    std::printf("%-32s %8.3f ms/request\n", "round trip", elapsed.count() * 1000 / requests);
+}
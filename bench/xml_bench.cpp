@@ -0,0 +1,145 @@
+// Parsing throughput on listing pages of about 1 MB, as S3 sends them
+//
+//     ./xml_bench [iterations]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <malloc.h>
+#include <new>
+#include <s3cpp/s3.h>
+#include <s3cpp/xml.hpp>
+#include <string>
+#include <string_view>
+
+// Heap use of the results, counted on every allocation
+std::atomic<size_t> allocations = 0;
+std::atomic<size_t> liveBytes = 0;
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    allocations++;
+    liveBytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p)
+        liveBytes -= malloc_usable_size(p);
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+namespace {
+
+constexpr size_t PageSize = 1 << 20;
+
+std::string listObjectsPage() {
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<ListBucketResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+                      "<Name>my-bucket</Name><Prefix>logs/</Prefix><KeyCount>1000</KeyCount><MaxKeys>1000</MaxKeys>"
+                      "<IsTruncated>true</IsTruncated><NextContinuationToken>1ueGcxLPRx1Tr/XYExHnhbYLgveDs2J/wm36Hy4vbOwM=</NextContinuationToken>";
+    for (size_t i = 0; xml.size() < PageSize; i++) {
+        xml += std::format("\n  <Contents>\n    <Key>logs/2024/{:02}/{:02}/app-{:06}.json.gz</Key>\n"
+                           "    <LastModified>2024-{:02}-{:02}T{:02}:{:02}:{:02}.000Z</LastModified>\n"
+                           "    <ETag>&quot;{:032x}&quot;</ETag>\n    <ChecksumAlgorithm>CRC64NVME</ChecksumAlgorithm>\n"
+                           "    <ChecksumType>FULL_OBJECT</ChecksumType>\n    <Size>{}</Size>\n"
+                           "    <Owner>\n      <ID>75aa57f09aa0c8caeab4f8c24e99d10f8e7faeebf76c078efc7c6caea54ba06a</ID>\n    </Owner>\n"
+                           "    <StorageClass>STANDARD</StorageClass>\n  </Contents>",
+            i % 12 + 1, i % 28 + 1, i, i % 12 + 1, i % 28 + 1, i % 24, i % 60, i % 60, i * 2654435761u, 1024 + i * 37);
+    }
+    return xml + "\n</ListBucketResult>";
+}
+
+std::string listBucketsPage() {
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<ListAllMyBucketsResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\"><Buckets>";
+    for (size_t i = 0; xml.size() < PageSize; i++) {
+        xml += std::format("<Bucket><BucketArn>arn:aws:s3:::analytics-team-bucket-{:06}</BucketArn>"
+                           "<BucketRegion>us-east-2</BucketRegion><CreationDate>2023-{:02}-{:02}T10:11:12.000Z</CreationDate>"
+                           "<Name>analytics-team-bucket-{:06}</Name></Bucket>",
+            i, i % 12 + 1, i % 28 + 1, i);
+    }
+    return xml + "</Buckets><Owner><DisplayName>owner</DisplayName><ID>75aa57f09aa0c8caeab4f8c2</ID></Owner></ListAllMyBucketsResult>";
+}
+
+// Only counts, so that what is measured is the scanning
+struct Counter {
+    size_t elements = 0;
+    size_t bytes = 0;
+
+    void startElement(std::string_view) { elements++; }
+    void text(std::string_view value) { bytes += value.size(); }
+    void endElement(std::string_view) { }
+};
+
+void run(const char* name, size_t size, int iterations, const std::function<void()>& body) {
+    body(); // warm-up
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        body();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double mb = static_cast<double>(size) * iterations / (1 << 20);
+    std::printf("%-32s %8.1f MB/s %10.3f ms/page\n", name, mb / elapsed.count(), elapsed.count() * 1000 / iterations);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    const std::string objects = listObjectsPage();
+    const std::string buckets = listBucketsPage();
+    S3Client client("access", "secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    for (const auto& [name, page] : { std::pair { "ListObjects", &objects }, std::pair { "ListBuckets", &buckets } }) {
+        run(std::format("{} events", name).c_str(), page->size(), iterations, [page] {
+            Counter counter;
+            XMLEventParser<Counter> parser(counter);
+            parser.feed(*page);
+            parser.finish();
+        });
+        // cURL hands the body over in pieces of up to 16 KiB
+        run(std::format("{} events, 16 KiB chunks", name).c_str(), page->size(), iterations, [page] {
+            Counter counter;
+            XMLEventParser<Counter> parser(counter);
+            for (size_t i = 0; i < page->size(); i += 16 * 1024)
+                parser.feed(std::string_view(*page).substr(i, 16 * 1024));
+            parser.finish();
+        });
+    }
+    run("ListObjects result", objects.size(), iterations, [&] {
+        if (!client.deserializeListObjectsResult(objects, 1000))
+            std::abort();
+    });
+    run("ListObjects compact", objects.size(), iterations, [&] {
+        if (!client.deserializeCompactListObjectsResult(objects, 1000))
+            std::abort();
+    });
+    run("ListBuckets result", buckets.size(), iterations, [&] {
+        if (!client.deserializeListBucketsResult(buckets, std::nullopt))
+            std::abort();
+    });
+
+    // What a page costs to keep around, per object
+    auto footprint = [](const char* name, size_t objects, auto parse) {
+        const size_t allocationsBefore = allocations;
+        const size_t bytesBefore = liveBytes;
+        {
+            auto result = parse();
+            std::printf("%-32s %8zu allocations %7.1f bytes/object\n", name, allocations - allocationsBefore,
+                static_cast<double>(liveBytes - bytesBefore) / objects);
+        }
+    };
+    auto full = client.deserializeListObjectsResult(objects, 1000);
+    footprint("ListObjects result", full->Contents.size(), [&] { return client.deserializeListObjectsResult(objects, 1000); });
+    footprint("ListObjects compact", full->Contents.size(), [&] { return client.deserializeCompactListObjectsResult(objects, 1000); });
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include <cstring>
+#include <s3cpp/arena.h>
+
+std::string_view StringArena::store(std::string_view value) {
+    if (value.empty())
+        return {};
+    if (value.size() > left_) {
+        // Big values get a block of their own, the current one keeps its space
+        if (value.size() > block_size_ / 4) {
+            blocks_.push_back(std::make_unique_for_overwrite<char[]>(value.size()));
+            capacity_ += value.size();
+            std::memcpy(blocks_.back().get(), value.data(), value.size());
+            return { blocks_.back().get(), value.size() };
+        }
+        blocks_.push_back(std::make_unique_for_overwrite<char[]>(block_size_));
+        capacity_ += block_size_;
+        cursor_ = blocks_.back().get();
+        left_ = block_size_;
+    }
+    std::memcpy(cursor_, value.data(), value.size());
+    const std::string_view stored(cursor_, value.size());
+    cursor_ += value.size();
+    left_ -= value.size();
+    return stored;
+}
+
+std::string_view StringArena::intern(std::string_view value) {
+    if (auto it = interned_.find(value); it != interned_.end())
+        return *it;
+    const std::string_view stored = store(value);
+    interned_.insert(stored);
+    return stored;
+}
@@ -0,0 +1,70 @@
+#ifndef S3CPP_ARENA
+#define S3CPP_ARENA
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Append-only storage for the strings of a parsed response
+//
+// Strings are copied into large blocks and handed out as views, which stay
+// valid for as long as the arena does, moves included. One allocation per
+// block instead of one per string, and no per-string header
+class StringArena {
+public:
+    StringArena()
+        : StringArena(DefaultBlockSize) { }
+    explicit StringArena(size_t blockSize)
+        : block_size_(blockSize) { }
+
+    // The moved-from arena is left empty, not writing into the blocks it gave away
+    StringArena(StringArena&& other) noexcept
+        : block_size_(other.block_size_)
+        , blocks_(std::move(other.blocks_))
+        , cursor_(std::exchange(other.cursor_, nullptr))
+        , left_(std::exchange(other.left_, 0))
+        , capacity_(std::exchange(other.capacity_, 0))
+        , interned_(std::move(other.interned_)) {
+        other.blocks_.clear();
+        other.interned_.clear();
+    }
+    StringArena& operator=(StringArena&& other) noexcept {
+        if (this != &other) {
+            block_size_ = other.block_size_;
+            blocks_ = std::move(other.blocks_);
+            cursor_ = std::exchange(other.cursor_, nullptr);
+            left_ = std::exchange(other.left_, 0);
+            capacity_ = std::exchange(other.capacity_, 0);
+            interned_ = std::move(other.interned_);
+            other.blocks_.clear();
+            other.interned_.clear();
+        }
+        return *this;
+    }
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    // A copy of `value` owned by the arena
+    std::string_view store(std::string_view value);
+    // Same, but equal values share a single copy. For the few values that
+    // repeat all over a response, i.e. storage classes or owners
+    std::string_view intern(std::string_view value);
+
+    // Bytes held by the blocks, used or not
+    size_t capacity() const { return capacity_; }
+
+    static constexpr size_t DefaultBlockSize = 16 * 1024;
+
+private:
+    size_t block_size_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_ = nullptr;
+    size_t left_ = 0;
+    size_t capacity_ = 0;
+    std::unordered_set<std::string_view> interned_;
+};
+
+#endif
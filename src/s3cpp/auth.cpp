@@ -4,12 +4,88 @@
 #include <chrono>
 #include <cstring>
 #include <format>
-#include <iomanip>
-#include <map>
+#include <iterator>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
 #include <openssl/hmac.h>
+#include <openssl/params.h>
 #include <openssl/sha.h>
-#include <sstream>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Fetched once, algorithm lookups are not cheap in OpenSSL 3
+EVP_MAC* hmacAlgorithm() {
+    static EVP_MAC* mac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+    return mac;
+}
+
+std::atomic<uint64_t> next_generation { 1 };
+
+constexpr std::string_view StreamingPayload = "STREAMING-AWS4-HMAC-SHA256-PAYLOAD";
+constexpr std::string_view StreamingPayloadTrailer = "STREAMING-AWS4-HMAC-SHA256-PAYLOAD-TRAILER";
+constexpr std::string_view StreamingUnsignedPayloadTrailer = "STREAMING-UNSIGNED-PAYLOAD-TRAILER";
+constexpr std::string_view EmptyPayloadHash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+constexpr char LowerHexDigits[] = "0123456789abcdef";
+constexpr char UpperHexDigits[] = "0123456789ABCDEF";
+
+// RFC 3986 unreserved characters, left as they are by URL encoding
+constexpr std::array<bool, 256> Unreserved = [] {
+    std::array<bool, 256> table {};
+    for (int c = 'A'; c <= 'Z'; c++)
+        table[c] = true;
+    for (int c = 'a'; c <= 'z'; c++)
+        table[c] = true;
+    for (int c = '0'; c <= '9'; c++)
+        table[c] = true;
+    table['-'] = table['_'] = table['.'] = table['~'] = true;
+    return table;
+}();
+
+void appendUrlEncoded(std::string& out, std::string_view value) {
+    for (unsigned char c : value) {
+        if (Unreserved[c]) {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += UpperHexDigits[c >> 4];
+            out += UpperHexDigits[c & 0xF];
+        }
+    }
+}
+
+// Path (and query) of `url`, the part that goes in the canonical request
+std::string_view requestPath(std::string_view url) {
+    if (size_t bpos = url.find("amazonaws.com"); bpos != std::string_view::npos)
+        return url.substr(bpos + 13);
+    // Assume localhost:XXXX (dirty, sorry :( i know)
+    size_t scheme_end = url.find("://");
+    size_t path_start = url.find('/', scheme_end == std::string_view::npos ? 0 : scheme_end + 3);
+    return path_start != std::string_view::npos ? url.substr(path_start) : "/";
+}
+
+// Unencoded query parameters, alphabetically-sorted and URL-encoded
+void appendCanonicalQuery(std::string& out, std::vector<std::pair<std::string_view, std::string_view>>& query_params) {
+    std::sort(query_params.begin(), query_params.end());
+    for (size_t i = 0; i < query_params.size(); i++) {
+        if (i > 0)
+            out += '&';
+        appendUrlEncoded(out, query_params[i].first);
+        out += '=';
+        appendUrlEncoded(out, query_params[i].second);
+    }
+}
+
+void appendLowerCase(std::string& out, std::string_view value) {
+    for (char c : value)
+        out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // namespace
 
 template <typename T>
 void AWSSigV4Signer::sign(HttpRequestBase<T>& request) {
@@ -18,9 +94,40 @@ void AWSSigV4Signer::sign(HttpRequestBase<T>& request) {
 
     // Compute payload hash and set header ONLY for body requests
     std::string payload_hash;
+    bool chunked = false;
+    std::optional<ChecksumAlgorithm> trailing_checksum;
     if constexpr (std::is_same_v<T, HttpBodyRequest>) {
-        const std::string& body = static_cast<HttpBodyRequest&>(request).getBody();
-        payload_hash = hex(sha256(body));
+        const HttpBodyRequest& body_request = static_cast<HttpBodyRequest&>(request);
+        if (body_request.getBodySource()) {
+            // A streamed body is not around to be hashed, keep the hash the
+            // caller may have computed upfront, sign it chunk by chunk or
+            // leave the payload unsigned
+            auto trailer = request.getHeaders().find("x-amz-trailer");
+            if (trailer != request.getHeaders().end())
+                trailing_checksum = checksumAlgorithmFromHeader(trailer->second);
+
+            auto it = request.getHeaders().find("x-amz-content-sha256");
+            if (it != request.getHeaders().end())
+                payload_hash = it->second;
+            else if (trailing_checksum)
+                payload_hash = payload_signing == PayloadSigning::Streaming ? StreamingPayloadTrailer : StreamingUnsignedPayloadTrailer;
+            else if (payload_signing == PayloadSigning::Streaming)
+                payload_hash = StreamingPayload;
+            else
+                payload_hash = "UNSIGNED-PAYLOAD";
+
+            chunked = payload_hash == StreamingPayload || payload_hash == StreamingPayloadTrailer || payload_hash == StreamingUnsignedPayloadTrailer;
+            if (chunked) {
+                // Signed along with the rest of the headers
+                auto encoding = request.getHeaders().find("Content-Encoding");
+                request.header("Content-Encoding", encoding != request.getHeaders().end() ? std::format("aws-chunked,{}", encoding->second) : "aws-chunked");
+                request.header("x-amz-decoded-content-length", std::to_string(body_request.getBodySourceLength()));
+            }
+        } else if (payload_signing == PayloadSigning::Unsigned) {
+            payload_hash = "UNSIGNED-PAYLOAD";
+        } else {
+            payload_hash = hex(sha256(body_request.getBody()));
+        }
         request.header("x-amz-content-sha256", payload_hash);
     } else {
         payload_hash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
@@ -32,140 +139,322 @@ void AWSSigV4Signer::sign(HttpRequestBase<T>& request) {
     const std::string request_date = timestamp.substr(0, 8);
 
     // Credential
+    const std::shared_ptr<const SigningKey> key = getSigningKey(request_date);
     const std::string credential_scope = std::format("{}/{}/s3/aws4_request", request_date, aws_region);
 
-    // Signed headers
-    std::string signed_headers = "";
-    uint_fast16_t i = 0;
-    for (const auto& header : request.getHeaders()) {
-        std::string kHeader = header.first;
-        std::transform(kHeader.begin(), kHeader.end(), kHeader.begin(),
-            ::tolower);
-        if (i > 0)
-            signed_headers += ";";
-        signed_headers += kHeader;
-        i++;
-    }
-
-    // Cannonical request
-    std::string hex_cannonical_request = hex(sha256(createCannonicalRequest(request, payload_hash)));
+    // Cannonical request + signed headers, built in per-thread buffers that
+    // keep their capacity from one request to the next
+    static thread_local std::string cannonical_request;
+    static thread_local std::string signed_headers;
+    buildCannonicalRequest(request, payload_hash, cannonical_request, signed_headers);
 
     // To sign
-    std::string string_to_sign = std::format("{}\n{}\n{}\n{}", hash_algo, timestamp, credential_scope, hex_cannonical_request);
-    std::string signature = hex(HMAC_SHA256(deriveSigningKey(request_date), SHA256_DIGEST_LENGTH, string_to_sign));
+    std::string string_to_sign = std::format("{}\n{}\n{}\n{}", hash_algo, timestamp, credential_scope, hex(sha256(cannonical_request)));
+    std::string signature = hex(HMAC_SHA256(*key, string_to_sign));
 
     // Build the final auth header value
-    request.header("Authorization", std::format("{} Credential={}/{}, SignedHeaders={}, Signature={}", hash_algo, access_key, credential_scope, signed_headers, signature));
+    request.header("Authorization", std::format("{} Credential={}/{}, SignedHeaders={}, Signature={}", hash_algo, key->access_key, credential_scope, signed_headers, signature));
+
+    if constexpr (std::is_same_v<T, HttpBodyRequest>) {
+        if (chunked)
+            streamChunked(static_cast<HttpBodyRequest&>(request), key, timestamp, credential_scope, signature, payload_hash != StreamingUnsignedPayloadTrailer, payload_hash == StreamingPayload ? std::nullopt : trailing_checksum);
+    }
 }
 
 template <typename T>
 std::string AWSSigV4Signer::createCannonicalRequest(HttpRequestBase<T>& request, const std::string& payload_hash) {
+    std::string canonical_request;
+    std::string signed_headers;
+    buildCannonicalRequest(request, payload_hash, canonical_request, signed_headers);
+    return canonical_request;
+}
+
+template <typename T>
+void AWSSigV4Signer::buildCannonicalRequest(HttpRequestBase<T>& request, const std::string& payload_hash, std::string& out, std::string& signed_headers) {
+    out.clear();
+    signed_headers.clear();
+
     const std::string http_verb = request.getHttpMethodStr(request.getHttpMethod());
-    std::string url = request.getURL();
+    const std::string_view url = request.getURL();
 
     // URI
-    std::string uri {};
-    if (size_t bpos = url.find("amazonaws.com"); bpos != std::string::npos) {
-        uri = url.erase(0, bpos + 13);
-    } else {
-        // Assume localhost:XXXX (dirty, sorry :( i know)
-        size_t path_start = url.find('/', 7);
-        if (path_start != std::string::npos) {
-            uri = url.substr(path_start);
-        } else {
-            uri = "/";
-        }
-    }
-    size_t begin_q = uri.find("?");
-    const std::string cannonical_uri = (begin_q != std::string::npos) ? uri.substr(0, begin_q) : uri;
+    std::string_view uri = requestPath(url);
+    size_t begin_q = uri.find('?');
+    const std::string_view cannonical_uri = uri.substr(0, begin_q);
+
+    out += http_verb;
+    out += '\n';
+    out += cannonical_uri;
+    out += '\n';
 
     // URI Query-string
-    std::map<std::string, std::string> query_params;
-    while (begin_q != std::string::npos) {
-        uri = uri.substr(begin_q + 1);
-        begin_q = uri.find("&");
-        const std::string query_param = uri.substr(0, begin_q);
+    if (begin_q != std::string_view::npos) {
         // Split query params by '=' character
         // Key=Value -> [Key, Value]
-        const int equalPos = query_param.find('=');
-        auto q = std::pair<std::string, std::string>(query_param.substr(0, equalPos), query_param.substr(equalPos + 1));
-        query_params[q.first] = q.second;
-    }
-
-    // Insert alphabetically-sorted query params on the Cannonical Request
-    std::string query_str = "";
-    for (const auto& [key, value] : query_params) {
-        if (query_str.size() > 0) {
-            query_str += "&";
+        // Subresources such as `?uploads` have no value: Key -> [Key, ""]
+        std::vector<std::pair<std::string_view, std::string_view>> query_params;
+        std::string_view query = uri.substr(begin_q + 1);
+        while (true) {
+            const size_t end = query.find('&');
+            const std::string_view query_param = query.substr(0, end);
+            const size_t equalPos = query_param.find('=');
+            if (equalPos != std::string_view::npos)
+                query_params.emplace_back(query_param.substr(0, equalPos), query_param.substr(equalPos + 1));
+            else
+                query_params.emplace_back(query_param, std::string_view {});
+            if (end == std::string_view::npos)
+                break;
+            query = query.substr(end + 1);
         }
-        query_str += std::format("{}={}", url_encode(key), url_encode(value));
+        appendCanonicalQuery(out, query_params);
     }
+    out += '\n';
 
     // Canonical Headers + SignedHeaders
-    const std::map<std::string, std::string, LowerCaseCompare> headers = request.getHeaders();
-    std::string cheaders = "";
-    std::string signed_headers = "";
-    uint_fast16_t i = 0;
-    for (const auto& header : headers) {
-        std::string kHeader = header.first;
-        std::transform(kHeader.begin(), kHeader.end(), kHeader.begin(), ::tolower);
-        if (i > 0)
-            signed_headers += ";";
-        signed_headers += kHeader;
-        cheaders += kHeader + ":" + header.second + "\n";
-        i++;
+    for (const auto& [name, value] : request.getHeaders()) {
+        if (!signed_headers.empty())
+            signed_headers += ';';
+        appendLowerCase(signed_headers, name);
+        appendLowerCase(out, name);
+        out += ':';
+        out += value;
+        out += '\n';
     }
+    out += '\n';
+    out += signed_headers;
+    out += '\n';
+    out += payload_hash;
+}
+
+std::string AWSSigV4Signer::presign(std::string_view method, std::string_view url, std::string_view host, std::chrono::seconds expires, std::span<const std::pair<std::string, std::string>> query) {
+    return presign(method, url, host, expires, query, getTimestamp());
+}
 
-    std::string canonical_request = std::format("{}\n{}\n{}\n{}\n{}\n{}",
-        http_verb,
-        cannonical_uri,
-        query_str,
-        cheaders,
-        signed_headers,
-        payload_hash);
+std::string AWSSigV4Signer::presign(std::string_view method, std::string_view url, std::string_view host, std::chrono::seconds expires, std::span<const std::pair<std::string, std::string>> query, const std::string& timestamp) {
+    std::string out;
+    appendPresignedURL(out, *getSigningKey(timestamp.substr(0, 8)), timestamp, method, url, host, expires, query);
+    return out;
+}
 
-    return canonical_request;
+std::vector<std::string> AWSSigV4Signer::presign(std::string_view method, std::span<const std::string> urls, std::string_view host, std::chrono::seconds expires) {
+    const std::string timestamp = getTimestamp();
+    const std::shared_ptr<const SigningKey> key = getSigningKey(timestamp.substr(0, 8));
+    std::vector<std::string> out(urls.size());
+    for (size_t i = 0; i < urls.size(); i++)
+        appendPresignedURL(out[i], *key, timestamp, method, urls[i], host, expires, {});
+    return out;
+}
+
+void AWSSigV4Signer::appendPresignedURL(std::string& out, const SigningKey& key, const std::string& timestamp, std::string_view method, std::string_view url, std::string_view host, std::chrono::seconds expires, std::span<const std::pair<std::string, std::string>> query) {
+    const std::string_view request_date = std::string_view(timestamp).substr(0, 8);
+    const std::string credential_scope = std::format("{}/{}/s3/aws4_request", request_date, aws_region);
+    const std::string credential = std::format("{}/{}", key.access_key, credential_scope);
+    const std::string expires_str = std::to_string(expires.count());
+
+    // The auth parameters are part of the canonical query string
+    std::vector<std::pair<std::string_view, std::string_view>> query_params;
+    query_params.reserve(query.size() + 5);
+    for (const auto& [name, value] : query)
+        query_params.emplace_back(name, value);
+    query_params.emplace_back("X-Amz-Algorithm", "AWS4-HMAC-SHA256");
+    query_params.emplace_back("X-Amz-Credential", credential);
+    query_params.emplace_back("X-Amz-Date", timestamp);
+    query_params.emplace_back("X-Amz-Expires", expires_str);
+    query_params.emplace_back("X-Amz-SignedHeaders", "host");
+
+    // The URL carries the same query string the canonical request has
+    out += url;
+    out += '?';
+    const size_t query_start = out.size();
+    appendCanonicalQuery(out, query_params);
+    const std::string_view canonical_query = std::string_view(out).substr(query_start);
+
+    static thread_local std::string cannonical_request;
+    cannonical_request.clear();
+    cannonical_request += method;
+    cannonical_request += '\n';
+    cannonical_request += requestPath(url);
+    cannonical_request += '\n';
+    cannonical_request += canonical_query;
+    cannonical_request += "\nhost:";
+    cannonical_request += host;
+    cannonical_request += "\n\nhost\nUNSIGNED-PAYLOAD";
+
+    const std::string string_to_sign = std::format("AWS4-HMAC-SHA256\n{}\n{}\n{}", timestamp, credential_scope, hex(sha256(cannonical_request)));
+    out += "&X-Amz-Signature=";
+    out += hex(HMAC_SHA256(key, string_to_sign));
 }
 
-const unsigned char* AWSSigV4Signer::sha256(const std::string& str) {
-    static unsigned char digest[SHA256_DIGEST_LENGTH];
-    const auto in_str = reinterpret_cast<const unsigned char*>(str.c_str());
-    SHA256(in_str, str.size(), digest);
+Sha256Digest AWSSigV4Signer::sha256(std::string_view str) {
+    Sha256Digest digest;
+    SHA256(reinterpret_cast<const unsigned char*>(str.data()), str.size(), digest.data());
     return digest;
 }
 
-const unsigned char* AWSSigV4Signer::HMAC_SHA256(const unsigned char* key,
+Sha256Digest AWSSigV4Signer::HMAC_SHA256(const unsigned char* key,
     size_t key_len,
-    const std::string& data) {
-    static unsigned char digest[SHA256_DIGEST_LENGTH];
+    std::string_view data) {
+    Sha256Digest digest;
     HMAC(EVP_sha256(), key, key_len,
-        reinterpret_cast<const unsigned char*>(data.c_str()),
-        data.size(), digest, NULL);
+        reinterpret_cast<const unsigned char*>(data.data()),
+        data.size(), digest.data(), NULL);
     return digest;
 }
 
-std::string AWSSigV4Signer::hex(const unsigned char* hash) {
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0')
-           << static_cast<int>(hash[i]);
+std::string AWSSigV4Signer::hex(const Sha256Digest& hash) {
+    std::string out(hash.size() * 2, '\0');
+    for (size_t i = 0; i < hash.size(); i++) {
+        out[2 * i] = LowerHexDigits[hash[i] >> 4];
+        out[2 * i + 1] = LowerHexDigits[hash[i] & 0xF];
     }
-    return ss.str();
+    return out;
 }
 
-std::string AWSSigV4Signer::url_encode(const std::string& value) {
+std::string AWSSigV4Signer::url_encode(std::string_view value) {
     std::string encoded;
     encoded.reserve(value.size() * 3);
+    appendUrlEncoded(encoded, value);
+    return encoded;
+}
 
-    for (unsigned char c : value) {
-        // RFC 3986
-        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
-            encoded += c;
-        } else {
-            encoded += std::format("%{:02X}", c);
+uint64_t AWSSigV4Signer::chunkedLength(uint64_t payload_length, bool signed_chunks, std::optional<ChecksumAlgorithm> trailing_checksum) {
+    // <size in hex>[;chunk-signature=<64 hex chars>]\r\n<payload>\r\n
+    const uint64_t signature_length = signed_chunks ? std::string_view(";chunk-signature=").size() + 2 * SHA256_DIGEST_LENGTH : 0;
+    auto framed = [signature_length](uint64_t size) {
+        return std::formatted_size("{:x}", size) + signature_length + 2 + size + 2;
+    };
+    const uint64_t full_chunks = payload_length / StreamingChunkSize;
+    const uint64_t last_chunk = payload_length % StreamingChunkSize;
+    // the body always ends with an empty chunk
+    uint64_t length = full_chunks * framed(StreamingChunkSize) + (last_chunk > 0 ? framed(last_chunk) : 0) + framed(0);
+    if (trailing_checksum) {
+        // <header>:<base64>\r\n[x-amz-trailer-signature:<64 hex chars>\r\n], before the final \r\n
+        const size_t base64_length = *trailing_checksum == ChecksumAlgorithm::CRC32C ? 8 : 12;
+        length += checksumHeader(*trailing_checksum).size() + 1 + base64_length + 2;
+        if (signed_chunks)
+            length += std::string_view("x-amz-trailer-signature:").size() + 2 * SHA256_DIGEST_LENGTH + 2;
+    }
+    return length;
+}
+
+void AWSSigV4Signer::streamChunked(HttpBodyRequest& request, std::shared_ptr<const SigningKey> key, const std::string& timestamp, const std::string& credential_scope, const std::string& seed_signature, bool signed_chunks, std::optional<ChecksumAlgorithm> trailing_checksum) {
+    struct ChunkedBody {
+        HttpBodySource source;
+        HttpBodyRewind rewind;
+        std::shared_ptr<const SigningKey> key;
+        // The part of the string to sign shared by every chunk
+        std::string scope;
+        std::string trailer_scope;
+        std::string seed_signature;
+        uint64_t payload_length;
+        bool signed_chunks;
+        std::optional<Checksum> checksum;
+
+        std::string previous_signature;
+        uint64_t remaining;
+        bool done = false;
+        std::string chunk;
+        // Framed chunk not handed out yet
+        std::string framed;
+        size_t framed_offset = 0;
+
+        void reset() {
+            previous_signature = seed_signature;
+            remaining = payload_length;
+            done = false;
+            framed.clear();
+            framed_offset = 0;
+            if (checksum)
+                checksum->reset();
         }
+    };
+
+    auto body = std::make_shared<ChunkedBody>();
+    body->source = request.getBodySource();
+    body->rewind = request.getBodyRewind();
+    body->key = std::move(key);
+    body->scope = std::format("AWS4-HMAC-SHA256-PAYLOAD\n{}\n{}\n", timestamp, credential_scope);
+    body->trailer_scope = std::format("AWS4-HMAC-SHA256-TRAILER\n{}\n{}\n", timestamp, credential_scope);
+    body->seed_signature = seed_signature;
+    body->payload_length = request.getBodySourceLength();
+    body->signed_chunks = signed_chunks;
+    if (trailing_checksum)
+        body->checksum.emplace(*trailing_checksum);
+    body->reset();
+
+    HttpBodySource source = [this, body](char* buffer, size_t size) -> std::ptrdiff_t {
+        while (body->framed_offset == body->framed.size()) {
+            if (body->done)
+                return 0;
+
+            // Chunks have to be complete, the length was announced upfront
+            const size_t chunk_size = std::min<uint64_t>(StreamingChunkSize, body->remaining);
+            body->chunk.resize(chunk_size);
+            size_t filled = 0;
+            while (filled < chunk_size) {
+                std::ptrdiff_t read = body->source(body->chunk.data() + filled, chunk_size - filled);
+                // a source ending early would send a body shorter than announced
+                if (read <= 0)
+                    return -1;
+                filled += read;
+            }
+            body->remaining -= chunk_size;
+            body->done = chunk_size == 0;
+
+            body->framed.clear();
+            if (body->signed_chunks) {
+                std::string string_to_sign = body->scope;
+                string_to_sign += body->previous_signature;
+                string_to_sign += '\n';
+                string_to_sign += EmptyPayloadHash;
+                string_to_sign += '\n';
+                string_to_sign += hex(sha256(body->chunk));
+                body->previous_signature = hex(HMAC_SHA256(*body->key, string_to_sign));
+                std::format_to(std::back_inserter(body->framed), "{:x};chunk-signature={}\r\n", chunk_size, body->previous_signature);
+            } else {
+                std::format_to(std::back_inserter(body->framed), "{:x}\r\n", chunk_size);
+            }
+            body->framed += body->chunk;
+
+            if (body->checksum) {
+                body->checksum->update(body->chunk);
+                if (body->done) {
+                    // The trailer goes between the empty chunk and the final CRLF
+                    const std::string trailer = std::format("{}:{}", checksumHeader(body->checksum->algorithm()), body->checksum->base64());
+                    body->framed += trailer;
+                    body->framed += "\r\n";
+                    if (body->signed_chunks) {
+                        std::string string_to_sign = body->trailer_scope;
+                        string_to_sign += body->previous_signature;
+                        string_to_sign += '\n';
+                        string_to_sign += hex(sha256(trailer + "\n"));
+                        std::format_to(std::back_inserter(body->framed), "x-amz-trailer-signature:{}\r\n", hex(HMAC_SHA256(*body->key, string_to_sign)));
+                    }
+                }
+            }
+            body->framed += "\r\n";
+            body->framed_offset = 0;
+        }
+
+        const size_t n = std::min(size, body->framed.size() - body->framed_offset);
+        std::memcpy(buffer, body->framed.data() + body->framed_offset, n);
+        body->framed_offset += n;
+        return n;
+    };
+
+    // Resending starts over from the seed signature
+    HttpBodyRewind rewind;
+    if (body->rewind) {
+        rewind = [body] {
+            if (!body->rewind())
+                return false;
+            body->reset();
+            return true;
+        };
     }
-    return encoded;
+
+    const uint64_t length = chunkedLength(body->payload_length, signed_chunks, trailing_checksum);
+    request.body(std::move(source), length, std::move(rewind));
 }
 
 // Required by AWS SigV4 to be in ISO8601 format
@@ -176,23 +465,78 @@ std::string AWSSigV4Signer::getTimestamp() {
         std::chrono::floor<std::chrono::seconds>(now));
 }
 
-const unsigned char* AWSSigV4Signer::deriveSigningKey(const std::string request_date) {
-    const std::string initial_candidate = "AWS4" + secret_key;
-    const unsigned char* keyCandidate = reinterpret_cast<const unsigned char*>(initial_candidate.c_str());
+void AWSSigV4Signer::setCredentials(const std::string& access, const std::string& secret) {
+    signing_key.store(deriveSigningKey(access, secret, getTimestamp().substr(0, 8)));
+}
+
+std::shared_ptr<const AWSSigV4Signer::SigningKey> AWSSigV4Signer::getSigningKey(const std::string& request_date) {
+    std::shared_ptr<const SigningKey> current = signing_key.load();
+    if (current->date == request_date)
+        return current;
+    // i.e. presigning as of an earlier date, keep today's key cached
+    if (request_date < current->date)
+        return deriveSigningKey(current->access_key, current->secret_key, request_date);
 
-    unsigned char DateKey[SHA256_DIGEST_LENGTH];
-    const unsigned char* temp = HMAC_SHA256(keyCandidate, initial_candidate.size(), request_date);
-    std::memcpy(DateKey, temp, SHA256_DIGEST_LENGTH);
+    // The date rolled over. If another thread got here first, or the
+    // credentials were rotated meanwhile, the exchange fails and theirs stays
+    std::shared_ptr<const SigningKey> fresh = deriveSigningKey(current->access_key, current->secret_key, request_date);
+    signing_key.compare_exchange_strong(current, fresh);
+    return fresh;
+}
 
-    unsigned char DateRegionKey[SHA256_DIGEST_LENGTH];
-    temp = HMAC_SHA256(DateKey, SHA256_DIGEST_LENGTH, aws_region);
-    std::memcpy(DateRegionKey, temp, SHA256_DIGEST_LENGTH);
+std::shared_ptr<const AWSSigV4Signer::SigningKey> AWSSigV4Signer::deriveSigningKey(const std::string& access, const std::string& secret, const std::string& request_date) {
+    const std::string initial_candidate = "AWS4" + secret;
+    const Sha256Digest DateKey = HMAC_SHA256(reinterpret_cast<const unsigned char*>(initial_candidate.c_str()), initial_candidate.size(), request_date);
+    const Sha256Digest DateRegionKey = HMAC_SHA256(DateKey.data(), DateKey.size(), aws_region);
+    const Sha256Digest DateRegionServiceKey = HMAC_SHA256(DateRegionKey.data(), DateRegionKey.size(), "s3");
+    return std::make_shared<const SigningKey>(access, secret, request_date, HMAC_SHA256(DateRegionServiceKey.data(), DateRegionServiceKey.size(), "aws4_request"));
+}
 
-    unsigned char DateRegionServiceKey[SHA256_DIGEST_LENGTH];
-    temp = HMAC_SHA256(DateRegionKey, SHA256_DIGEST_LENGTH, "s3");
-    std::memcpy(DateRegionServiceKey, temp, SHA256_DIGEST_LENGTH);
+AWSSigV4Signer::SigningKey::SigningKey(const std::string& access, const std::string& secret, const std::string& date, const Sha256Digest& key)
+    : access_key(access)
+    , secret_key(secret)
+    , date(date)
+    , generation(next_generation++)
+    , mac(EVP_MAC_CTX_new(hmacAlgorithm())) {
+    char digest[] = "SHA256";
+    const OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end(),
+    };
+    if (!mac || !EVP_MAC_init(mac, key.data(), key.size(), params)) {
+        EVP_MAC_CTX_free(mac);
+        throw std::runtime_error("OpenSSL error: could not set up HMAC-SHA256");
+    }
+}
 
-    return HMAC_SHA256(DateRegionServiceKey, SHA256_DIGEST_LENGTH, "aws4_request");
+AWSSigV4Signer::SigningKey::~SigningKey() {
+    EVP_MAC_CTX_free(mac);
+}
+
+// HMAC keyed with the signing key. Every thread works on its own copy of the
+// prepared context, re-initialized (not re-keyed) for every signature
+Sha256Digest AWSSigV4Signer::HMAC_SHA256(const SigningKey& key, std::string_view data) {
+    struct ThreadMac {
+        uint64_t generation = 0;
+        EVP_MAC_CTX* ctx = nullptr;
+        ~ThreadMac() { EVP_MAC_CTX_free(ctx); }
+    };
+    static thread_local ThreadMac local;
+
+    if (local.generation != key.generation) {
+        EVP_MAC_CTX_free(local.ctx);
+        local.ctx = EVP_MAC_CTX_dup(key.mac);
+        local.generation = key.generation;
+    }
+    Sha256Digest digest;
+    size_t len = 0;
+    if (!local.ctx || !EVP_MAC_init(local.ctx, nullptr, 0, nullptr)
+        || !EVP_MAC_update(local.ctx, reinterpret_cast<const unsigned char*>(data.data()), data.size())
+        || !EVP_MAC_final(local.ctx, digest.data(), &len, digest.size())) {
+        local.generation = 0;
+        throw std::runtime_error("OpenSSL error: could not compute HMAC-SHA256");
+    }
+    return digest;
 }
 
 // Why are we still here? Just to suffer?
@@ -200,3 +544,5 @@ template void AWSSigV4Signer::sign<HttpRequest>(HttpRequestBase<HttpRequest>&);
 template void AWSSigV4Signer::sign<HttpBodyRequest>(HttpRequestBase<HttpBodyRequest>&);
 template std::string AWSSigV4Signer::createCannonicalRequest<HttpRequest>(HttpRequestBase<HttpRequest>&, const std::string&);
 template std::string AWSSigV4Signer::createCannonicalRequest<HttpBodyRequest>(HttpRequestBase<HttpBodyRequest>&, const std::string&);
+template void AWSSigV4Signer::buildCannonicalRequest<HttpRequest>(HttpRequestBase<HttpRequest>&, const std::string&, std::string&, std::string&);
+template void AWSSigV4Signer::buildCannonicalRequest<HttpBodyRequest>(HttpRequestBase<HttpBodyRequest>&, const std::string&, std::string&, std::string&);
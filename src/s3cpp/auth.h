@@ -1,20 +1,64 @@
 #ifndef S3CPP_AUTH
 #define S3CPP_AUTH
 
+#include "s3cpp/checksum.h"
 #include "s3cpp/httpclient.h"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <openssl/sha.h>
+#include <optional>
+#include <openssl/types.h>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Digests are returned by value, so the signer holds no shared scratch
+// buffers and can be used from any number of threads at once
+using Sha256Digest = std::array<unsigned char, SHA256_DIGEST_LENGTH>;
+
+// How request bodies are covered by the signature
+//
+// Streamed bodies with an `x-amz-trailer` header naming a checksum (see
+// `checksumHeader()`) are sent aws-chunked in every mode, the checksum is
+// computed while sending and appended as a trailer. Chunks are signed in
+// `Streaming` mode and left unsigned otherwise
+enum class PayloadSigning {
+    // In-memory bodies are hashed upfront, streamed bodies go as UNSIGNED-PAYLOAD
+    Signed,
+    // No body is hashed, saves a full pass over the data. Only over TLS
+    Unsigned,
+    // Streamed bodies are sent aws-chunked, each chunk signed as it is read
+    // (STREAMING-AWS4-HMAC-SHA256-PAYLOAD). In-memory bodies are hashed upfront
+    Streaming,
+};
 
 class AWSSigV4Signer {
 public:
     AWSSigV4Signer(const std::string& access, const std::string& secret)
-        : access_key(std::move(access))
-        , secret_key(std::move(secret))
-        , aws_region("us-east-2") { }
+        : aws_region("us-east-2") {
+        setCredentials(access, secret);
+    }
     AWSSigV4Signer(const std::string& access, const std::string& secret, const std::string& region)
-        : access_key(std::move(access))
-        , aws_region(std::move(region))
-        , secret_key(std::move(secret)) { }
+        : aws_region(std::move(region)) {
+        setCredentials(access, secret);
+    }
+
+    // Rotates the credentials, requests signed from now on use the new ones.
+    // Safe to call while other threads are signing
+    void setCredentials(const std::string& access, const std::string& secret);
+    // Set it before signing any request, by default `PayloadSigning::Signed`
+    void setPayloadSigning(PayloadSigning mode) { payload_signing = mode; }
+
+    // Payload bytes per aws-chunked chunk, S3 wants at least 8 KiB
+    static constexpr size_t StreamingChunkSize = 64 * 1024;
+    // Size of `payload_length` bytes once framed in aws-chunked chunks, signed
+    // or not, followed by the trailer of `trailing_checksum` if any
+    static uint64_t chunkedLength(uint64_t payload_length, bool signed_chunks = true, std::optional<ChecksumAlgorithm> trailing_checksum = std::nullopt);
 
     template <typename T>
     void sign(HttpRequestBase<T>& request);
@@ -22,18 +66,59 @@ public:
     template <typename T>
     std::string createCannonicalRequest(HttpRequestBase<T>& request, const std::string& payload_hash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
 
-    const unsigned char* sha256(const std::string& str);
-    const unsigned char* HMAC_SHA256(const unsigned char* key, size_t key_len, const std::string& data);
-    std::string hex(const unsigned char* hash);
-    std::string url_encode(const std::string& value);
+    // Query-string authentication: a presigned URL for `method` on `url` (with
+    // no query string), valid for `expires`. Only the Host header is signed and
+    // the payload is left unsigned. `query` holds extra parameters, unencoded
+    std::string presign(std::string_view method, std::string_view url, std::string_view host, std::chrono::seconds expires, std::span<const std::pair<std::string, std::string>> query = {});
+    // Same, signed as of `timestamp` (see getTimestamp()) instead of now. Equal
+    // inputs give equal URLs, i.e. to hand out one link per time window
+    std::string presign(std::string_view method, std::string_view url, std::string_view host, std::chrono::seconds expires, std::span<const std::pair<std::string, std::string>> query, const std::string& timestamp);
+    // Many URLs at once, sharing the timestamp and the signing key
+    std::vector<std::string> presign(std::string_view method, std::span<const std::string> urls, std::string_view host, std::chrono::seconds expires);
+
+    Sha256Digest sha256(std::string_view str);
+    Sha256Digest HMAC_SHA256(const unsigned char* key, size_t key_len, std::string_view data);
+    std::string hex(const Sha256Digest& hash);
+    std::string url_encode(std::string_view value);
     std::string getTimestamp();
 
 private:
-    std::string access_key;
-    std::string secret_key;
+    // The key a signature is made with only depends on the secret, the date
+    // and the region, so it is derived once per day instead of on every request
+    struct SigningKey {
+        std::string access_key;
+        std::string secret_key;
+        std::string date;
+        // Tells apart the keys each thread has a copy of `mac` for
+        uint64_t generation;
+        // HMAC-SHA256 already keyed with the signing key
+        EVP_MAC_CTX* mac;
+
+        SigningKey(const std::string& access, const std::string& secret, const std::string& date, const Sha256Digest& key);
+        ~SigningKey();
+        SigningKey(const SigningKey&) = delete;
+        SigningKey& operator=(const SigningKey&) = delete;
+    };
+
     std::string aws_region;
+    PayloadSigning payload_signing = PayloadSigning::Signed;
+    // Swapped as a whole on date roll-over or credential rotation
+    std::atomic<std::shared_ptr<const SigningKey>> signing_key;
+
+    std::shared_ptr<const SigningKey> getSigningKey(const std::string& request_date);
+    std::shared_ptr<const SigningKey> deriveSigningKey(const std::string& access, const std::string& secret, const std::string& request_date);
+    Sha256Digest HMAC_SHA256(const SigningKey& key, std::string_view data);
+    // Replaces the body source of `request` with one that frames (and signs)
+    // every chunk, chaining the signatures from the one of the request. The
+    // checksum of the payload is sent as a trailer when `trailing_checksum` is set
+    void streamChunked(HttpBodyRequest& request, std::shared_ptr<const SigningKey> key, const std::string& timestamp, const std::string& credential_scope, const std::string& seed_signature, bool signed_chunks, std::optional<ChecksumAlgorithm> trailing_checksum);
 
-    const unsigned char* deriveSigningKey(const std::string request_date);
+    void appendPresignedURL(std::string& out, const SigningKey& key, const std::string& timestamp, std::string_view method, std::string_view url, std::string_view host, std::chrono::seconds expires, std::span<const std::pair<std::string, std::string>> query);
+
+    // Writes the canonical request into `out` and the signed header list into
+    // `signed_headers`, both are cleared first so buffers can be reused
+    template <typename T>
+    void buildCannonicalRequest(HttpRequestBase<T>& request, const std::string& payload_hash, std::string& out, std::string& signed_headers);
 };
 
 #endif
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <openssl/evp.h>
+#include <s3cpp/checksum.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define S3CPP_CHECKSUM_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define S3CPP_CHECKSUM_ARM_CRC 1
+#endif
+
+namespace {
+
+// Both CRCs are bit-reflected, the polynomials are given reflected as well
+constexpr uint32_t Crc32cPolynomial = 0x82F63B78;
+constexpr uint64_t Crc64NvmePolynomial = 0x9A6C9329AC4BC9B5;
+
+constexpr uint64_t reverseBits(uint64_t value) {
+    uint64_t reversed = 0;
+    for (int i = 0; i < 64; i++) {
+        reversed = (reversed << 1) | (value & 1);
+        value >>= 1;
+    }
+    return reversed;
+}
+
+// Slicing-by-8 tables, `Tables[k][b]` is the CRC of byte `b` followed by `k` zero bytes
+template <typename T, T Polynomial>
+constexpr std::array<std::array<T, 256>, 8> makeTables() {
+    std::array<std::array<T, 256>, 8> tables {};
+    for (uint32_t b = 0; b < 256; b++) {
+        T crc = b;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ ((crc & 1) ? Polynomial : 0);
+        tables[0][b] = crc;
+    }
+    for (size_t k = 1; k < 8; k++) {
+        for (size_t b = 0; b < 256; b++)
+            tables[k][b] = (tables[k - 1][b] >> 8) ^ tables[0][tables[k - 1][b] & 0xFF];
+    }
+    return tables;
+}
+
+constexpr auto Crc32cTables = makeTables<uint32_t, Crc32cPolynomial>();
+constexpr auto Crc64NvmeTables = makeTables<uint64_t, Crc64NvmePolynomial>();
+
+// Table-driven CRC over the (already inverted) state `crc`, 8 bytes at a time
+template <typename T>
+T crcTables(const std::array<std::array<T, 256>, 8>& tables, T crc, const unsigned char* data, size_t size) {
+    if constexpr (std::endian::native == std::endian::little) {
+        while (size >= 8) {
+            uint64_t word;
+            std::memcpy(&word, data, 8);
+            word ^= crc;
+            crc = tables[7][word & 0xFF] ^ tables[6][(word >> 8) & 0xFF] ^ tables[5][(word >> 16) & 0xFF] ^ tables[4][(word >> 24) & 0xFF]
+                ^ tables[3][(word >> 32) & 0xFF] ^ tables[2][(word >> 40) & 0xFF] ^ tables[1][(word >> 48) & 0xFF] ^ tables[0][word >> 56];
+            data += 8;
+            size -= 8;
+        }
+    }
+    while (size--)
+        crc = tables[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+uint32_t crc32cTables(uint32_t crc, const unsigned char* data, size_t size) {
+    return crcTables(Crc32cTables, crc, data, size);
+}
+
+uint64_t crc64NvmeTables(uint64_t crc, const unsigned char* data, size_t size) {
+    return crcTables(Crc64NvmeTables, crc, data, size);
+}
+
+#if defined(S3CPP_CHECKSUM_X86)
+
+__attribute__((target("sse4.2"))) uint32_t crc32cHardware(uint32_t crc, const unsigned char* data, size_t size) {
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (size--)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+
+// x^n mod P, bit-reflected, as the folding constants below want them
+constexpr uint64_t xPowMod(unsigned n) {
+    // worked out on the non-reflected polynomial, then reflected
+    constexpr uint64_t polynomial = reverseBits(Crc64NvmePolynomial);
+    uint64_t value = 1;
+    for (unsigned i = 0; i < n; i++)
+        value = (value << 1) ^ ((value >> 63) ? polynomial : 0);
+    return reverseBits(value);
+}
+
+// Carry-less multiplication folding, as in Intel's "Fast CRC Computation for
+// Generic Polynomials Using PCLMULQDQ". Folding a 128-bit block forward by
+// `d` bits multiplies its high-degree half by x^(d+63) and the other half by
+// x^(d-1) mod P (one less than the distance, as reflected products come out
+// shifted by one bit)
+struct FoldConstants {
+    uint64_t low;
+    uint64_t high;
+};
+
+constexpr FoldConstants foldBy(unsigned bits) {
+    return { xPowMod(bits + 63), xPowMod(bits - 1) };
+}
+
+constexpr FoldConstants Fold128 = foldBy(128);
+constexpr FoldConstants Fold256 = foldBy(256);
+constexpr FoldConstants Fold384 = foldBy(384);
+constexpr FoldConstants Fold512 = foldBy(512);
+
+__attribute__((target("pclmul,sse4.1"))) inline __m128i fold(__m128i block, FoldConstants constants) {
+    const __m128i k = _mm_set_epi64x(static_cast<int64_t>(constants.high), static_cast<int64_t>(constants.low));
+    return _mm_xor_si128(_mm_clmulepi64_si128(block, k, 0x00), _mm_clmulepi64_si128(block, k, 0x11));
+}
+
+__attribute__((target("pclmul,sse4.1"))) inline __m128i load(const unsigned char* data) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+__attribute__((target("pclmul,sse4.1"))) uint64_t crc64NvmeHardware(uint64_t crc, const unsigned char* data, size_t size) {
+    if (size < 32)
+        return crc64NvmeTables(crc, data, size);
+
+    // The state goes into the first 8 bytes, as in the table-driven loop
+    __m128i acc = _mm_xor_si128(load(data), _mm_cvtsi64_si128(static_cast<int64_t>(crc)));
+    data += 16;
+    size -= 16;
+
+    // Four independent lanes 64 bytes apart hide the multiplication latency
+    if (size >= 112) {
+        __m128i lanes[4] = { acc, load(data), load(data + 16), load(data + 32) };
+        data += 48;
+        size -= 48;
+        while (size >= 64) {
+            for (int i = 0; i < 4; i++)
+                lanes[i] = _mm_xor_si128(fold(lanes[i], Fold512), load(data + 16 * i));
+            data += 64;
+            size -= 64;
+        }
+        acc = _mm_xor_si128(_mm_xor_si128(fold(lanes[0], Fold384), fold(lanes[1], Fold256)), _mm_xor_si128(fold(lanes[2], Fold128), lanes[3]));
+    }
+
+    while (size >= 16) {
+        acc = _mm_xor_si128(fold(acc, Fold128), load(data));
+        data += 16;
+        size -= 16;
+    }
+
+    // The remaining 128 bits (and the tail) are reduced with the tables
+    unsigned char remainder[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(remainder), acc);
+    crc = crc64NvmeTables(0, remainder, sizeof(remainder));
+    return crc64NvmeTables(crc, data, size);
+}
+
+#elif defined(S3CPP_CHECKSUM_ARM_CRC)
+
+uint32_t crc32cHardware(uint32_t crc, const unsigned char* data, size_t size) {
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc = __crc32cd(crc, word);
+        data += 8;
+        size -= 8;
+    }
+    while (size--)
+        crc = __crc32cb(crc, *data++);
+    return crc;
+}
+
+#endif
+
+using Crc32cFunction = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+using Crc64Function = uint64_t (*)(uint64_t, const unsigned char*, size_t);
+
+// Picked once, on first use
+Crc32cFunction crc32cImplementation() {
+#if defined(S3CPP_CHECKSUM_X86)
+    return __builtin_cpu_supports("sse4.2") ? crc32cHardware : crc32cTables;
+#elif defined(S3CPP_CHECKSUM_ARM_CRC)
+    return crc32cHardware;
+#else
+    return crc32cTables;
+#endif
+}
+
+Crc64Function crc64NvmeImplementation() {
+#if defined(S3CPP_CHECKSUM_X86)
+    return (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) ? crc64NvmeHardware : crc64NvmeTables;
+#else
+    return crc64NvmeTables;
+#endif
+}
+
+} // namespace
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t size) {
+    static const Crc32cFunction implementation = crc32cImplementation();
+    return ~implementation(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+uint64_t crc64nvme(uint64_t crc, const void* data, size_t size) {
+    static const Crc64Function implementation = crc64NvmeImplementation();
+    return ~implementation(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+std::optional<ChecksumAlgorithm> checksumAlgorithmFromName(std::string_view name) {
+    if (name == "CRC32C")
+        return ChecksumAlgorithm::CRC32C;
+    if (name == "CRC64NVME")
+        return ChecksumAlgorithm::CRC64NVME;
+    return std::nullopt;
+}
+
+std::string_view checksumHeader(ChecksumAlgorithm algorithm) {
+    switch (algorithm) {
+    case ChecksumAlgorithm::CRC32C:
+        return "x-amz-checksum-crc32c";
+    case ChecksumAlgorithm::CRC64NVME:
+        return "x-amz-checksum-crc64nvme";
+    }
+    return {};
+}
+
+std::optional<ChecksumAlgorithm> checksumAlgorithmFromHeader(std::string_view header) {
+    for (ChecksumAlgorithm algorithm : { ChecksumAlgorithm::CRC32C, ChecksumAlgorithm::CRC64NVME }) {
+        const std::string_view name = checksumHeader(algorithm);
+        if (header.size() == name.size() && std::equal(header.begin(), header.end(), name.begin(), [](char a, char b) { return (a | 0x20) == b; }))
+            return algorithm;
+    }
+    return std::nullopt;
+}
+
+void Checksum::update(const void* data, size_t size) {
+    if (algorithm_ == ChecksumAlgorithm::CRC32C)
+        value_ = crc32c(static_cast<uint32_t>(value_), data, size);
+    else
+        value_ = crc64nvme(value_, data, size);
+}
+
+std::string Checksum::base64() const {
+    const size_t size = algorithm_ == ChecksumAlgorithm::CRC32C ? 4 : 8;
+    unsigned char bytes[8];
+    for (size_t i = 0; i < size; i++)
+        bytes[i] = static_cast<unsigned char>(value_ >> (8 * (size - 1 - i)));
+
+    unsigned char encoded[16];
+    const int length = EVP_EncodeBlock(encoded, bytes, static_cast<int>(size));
+    return std::string(reinterpret_cast<const char*>(encoded), length);
+}
@@ -0,0 +1,49 @@
+#ifndef S3CPP_CHECKSUM
+#define S3CPP_CHECKSUM
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Checksums the client computes itself, the ones S3 calls "full object"
+// checksums and the cheapest to compute
+enum class ChecksumAlgorithm {
+    CRC32C,
+    CRC64NVME,
+};
+
+// Running CRCs, start with 0 and pass the previous result to continue.
+// Hardware accelerated when the CPU supports it (SSE4.2 / ARMv8 CRC for
+// CRC32C, PCLMULQDQ for CRC64NVME), table-driven otherwise
+uint32_t crc32c(uint32_t crc, const void* data, size_t size);
+uint64_t crc64nvme(uint64_t crc, const void* data, size_t size);
+
+// "CRC32C" as in x-amz-checksum-algorithm, std::nullopt for the ones not computed here
+std::optional<ChecksumAlgorithm> checksumAlgorithmFromName(std::string_view name);
+// "x-amz-checksum-crc32c"
+std::string_view checksumHeader(ChecksumAlgorithm algorithm);
+std::optional<ChecksumAlgorithm> checksumAlgorithmFromHeader(std::string_view header);
+
+// Checksum of data seen in pieces, i.e. while it is streamed
+class Checksum {
+public:
+    explicit Checksum(ChecksumAlgorithm algorithm)
+        : algorithm_(algorithm) { }
+
+    void update(const void* data, size_t size);
+    void update(std::string_view data) { update(data.data(), data.size()); }
+    void reset() { value_ = 0; }
+
+    ChecksumAlgorithm algorithm() const { return algorithm_; }
+    uint64_t value() const { return value_; }
+    // As S3 sends it in x-amz-checksum-* headers, base64 of the big-endian value
+    std::string base64() const;
+
+private:
+    ChecksumAlgorithm algorithm_;
+    uint64_t value_ = 0;
+};
+
+#endif
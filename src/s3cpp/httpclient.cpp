@@ -1,12 +1,182 @@
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <curl/curl.h>
 #include <curl/easy.h>
 #include <format>
+#include <optional>
 #include <s3cpp/httpclient.h>
 #include <stdexcept>
 #include <string>
 
+namespace {
+
+HttpTransportError cancelledError() {
+    return HttpTransportError(CURLE_ABORTED_BY_CALLBACK, 0, "libcurl error: transfer cancelled");
+}
+
+// Hands the outcome to the callback of the transfer. Callbacks mostly run on
+// the loop thread, a throwing callback must not take the whole loop down
+// with it
+void complete(HttpTransfer& transfer, std::expected<HttpResponse, HttpTransportError> result) {
+    try {
+        if (transfer.callback)
+            transfer.callback(std::move(result));
+    } catch (...) {
+    }
+}
+
+// Bandwidth limits. On the event loop a transfer that finds its limit in debt
+// is paused, `HttpEventLoop::throttle()` resumes it once the debt is paid
+bool pause(HttpTransfer& transfer, const RateLimiter& limit, int direction) {
+    if (!transfer.on_loop || limit.waitTime() == std::chrono::nanoseconds::zero())
+        return false;
+    transfer.paused |= direction;
+    return true;
+}
+
+// Synchronous transfers wait right here instead
+void charge(const HttpTransfer& transfer, RateLimiter& limit, size_t bytes) {
+    if (transfer.on_loop)
+        limit.reserve(bytes);
+    else
+        limit.acquire(bytes);
+}
+
+} // namespace
+
+HttpHeaders::HttpHeaders(std::initializer_list<value_type> fields) {
+    for (const auto& [name, value] : fields)
+        set(name, value);
+}
+
+std::vector<HttpHeaders::Entry>::const_iterator HttpHeaders::lower_bound(std::string_view name) const {
+    return std::lower_bound(entries_.begin(), entries_.end(), name, [this](const Entry& entry, std::string_view name) {
+        return LowerCaseCompare {}(this->name(entry), name);
+    });
+}
+
+HttpHeaders::const_iterator HttpHeaders::find(std::string_view name) const {
+    auto it = lower_bound(name);
+    if (it == entries_.end() || !LowerCaseCompare::equal(this->name(*it), name))
+        return end();
+    return { buffer_.data(), &*it };
+}
+
+std::string_view HttpHeaders::at(std::string_view name) const {
+    auto it = find(name);
+    if (it == end())
+        throw std::out_of_range(std::format("No header {}", name));
+    return it->second;
+}
+
+void HttpHeaders::set(std::string_view name, std::string_view value) {
+    // Views of these same headers would dangle once the buffer grows
+    auto aliases = [this](std::string_view s) {
+        return std::less_equal<> {}(buffer_.data(), s.data()) && std::less<> {}(s.data(), buffer_.data() + buffer_.size());
+    };
+    if (aliases(name) || aliases(value))
+        return set(std::string(name), std::string(value));
+
+    auto it = lower_bound(name);
+    const size_t index = it - entries_.begin();
+    const bool replace = it != entries_.end() && LowerCaseCompare::equal(this->name(*it), name);
+    const Entry entry { static_cast<uint32_t>(buffer_.size()), static_cast<uint32_t>(name.size()), static_cast<uint32_t>(value.size()) };
+    // A replaced header gets a new line at the end, keeping the spelling of
+    // its name. The old line is left unused until the next `clear()`
+    buffer_.reserve(buffer_.size() + name.size() + value.size() + 3);
+    if (replace)
+        buffer_.append(this->name(entries_[index]));
+    else
+        buffer_.append(name);
+    buffer_.append(": ");
+    buffer_.append(value);
+    buffer_.push_back('\0');
+    if (replace)
+        entries_[index] = entry;
+    else
+        entries_.insert(entries_.begin() + index, entry);
+}
+
+void HttpHeaders::reserve(size_t fields, size_t bytes) {
+    entries_.reserve(fields);
+    buffer_.reserve(bytes);
+}
+
+void HttpHeaders::clear() {
+    entries_.clear();
+    buffer_.clear();
+}
+
+bool HttpHeaders::operator==(const HttpHeaders& other) const {
+    return std::ranges::equal(*this, other);
+}
+
+namespace {
+
+// A hedge costs as many tokens as requests have to be made to earn it
+size_t hedgeCost(const HttpHedgingOptions& options) {
+    if (options.max_ratio <= 0 || options.max_ratio > 1 || options.percentile <= 0 || options.percentile > 100)
+        throw std::invalid_argument("HttpHedgingOptions: max_ratio must be in (0, 1] and percentile in (0, 100]");
+    return static_cast<size_t>(std::ceil(1 / options.max_ratio));
+}
+
+} // namespace
+
+HttpHedging::HttpHedging(const HttpHedgingOptions& options)
+    : options_(options)
+    , hedge_cost_(hedgeCost(options))
+    , budget_(hedge_cost_ * options.burst) {
+    samples_.reserve(Samples);
+}
+
+std::chrono::nanoseconds HttpHedging::delay() const {
+    std::vector<std::chrono::nanoseconds> samples;
+    {
+        std::lock_guard lock(mutex_);
+        if (samples_.size() < std::max<size_t>(options_.min_samples, 1))
+            return std::max<std::chrono::nanoseconds>(options_.initial_delay, options_.min_delay);
+        samples = samples_;
+    }
+    auto nth = samples.begin() + static_cast<size_t>(std::ceil(options_.percentile / 100 * samples.size())) - 1;
+    std::nth_element(samples.begin(), nth, samples.end());
+    return std::max<std::chrono::nanoseconds>(*nth, options_.min_delay);
+}
+
+void HttpHedging::record(std::chrono::nanoseconds time_to_first_byte) {
+    std::lock_guard lock(mutex_);
+    if (samples_.size() < Samples) {
+        samples_.push_back(time_to_first_byte);
+    } else {
+        samples_[next_sample_] = time_to_first_byte;
+        next_sample_ = (next_sample_ + 1) % Samples;
+    }
+}
+
+HttpHedgingStats HttpHedging::stats() const {
+    return HttpHedgingStats {
+        .requests = requests_.load(std::memory_order_relaxed),
+        .hedged = hedged_.load(std::memory_order_relaxed),
+        .won = won_.load(std::memory_order_relaxed),
+    };
+}
+
+void HttpHedging::admit() {
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    budget_.release(1);
+}
+
+bool HttpHedging::acquire() {
+    if (!budget_.acquire(hedge_cost_))
+        return false;
+    hedged_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
 // Route to its HttpMethod
 HttpResponse HttpRequest::execute() {
+    if (hedging_ && !sink_)
+        return client_.execute_hedged(*this, *hedging_);
     switch (this->http_method_) {
     case HttpMethod::Get:
         return client_.execute_get(*this);
@@ -30,252 +200,731 @@ HttpResponse HttpBodyRequest::execute() {
     }
 }
 
+void HttpRequest::execute_async(HttpCallback callback) {
+    client_.execute_async(*this, std::move(callback));
+}
+
+std::future<HttpResponse> HttpRequest::execute_async() {
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> future = promise->get_future();
+    execute_async([promise](std::expected<HttpResponse, std::string> result) {
+        if (result)
+            promise->set_value(std::move(result.value()));
+        else
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(result.error())));
+    });
+    return future;
+}
+
+void HttpBodyRequest::execute_async(HttpCallback callback) {
+    client_.execute_async(*this, std::move(callback));
+}
+
+std::future<HttpResponse> HttpBodyRequest::execute_async() {
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> future = promise->get_future();
+    execute_async([promise](std::expected<HttpResponse, std::string> result) {
+        if (result)
+            promise->set_value(std::move(result.value()));
+        else
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(result.error())));
+    });
+    return future;
+}
+
 HttpResponse HttpClient::execute_get(HttpRequest& request) {
-    if (!curl_handle) {
-        throw std::runtime_error(
-            // this can happen both when cURL handle is not initialized or when it
-            // is invalidated in the HTTPClient copy constructor
-            "cURL handle is invalid");
+    auto transfer = make_transfer(request, false);
+    return perform(*transfer);
+}
+
+HttpResponse HttpClient::execute_head(HttpRequest& request) {
+    auto transfer = make_transfer(request, false);
+    return perform(*transfer);
+}
+
+HttpResponse HttpClient::execute_post(HttpBodyRequest& request) {
+    auto transfer = make_transfer(request, false);
+    return perform(*transfer);
+}
+
+HttpResponse HttpClient::execute_delete(HttpBodyRequest& request) {
+    auto transfer = make_transfer(request, false);
+    return perform(*transfer);
+}
+
+namespace {
+
+HttpTransferCallback toTransferCallback(HttpCallback callback) {
+    return [callback = std::move(callback)](std::expected<HttpResponse, HttpTransportError> result) {
+        if (result)
+            callback(std::move(*result));
+        else
+            callback(std::unexpected<std::string>(result.error().what()));
+    };
+}
+
+} // namespace
+
+void HttpClient::execute_async(HttpRequest& request, HttpCallback callback) {
+    if (!loop_)
+        throw std::runtime_error("cURL handle is invalid");
+    auto transfer = make_transfer(request, true);
+    transfer->callback = toTransferCallback(std::move(callback));
+    loop_->submit(std::move(transfer));
+}
+
+void HttpClient::execute_async(HttpBodyRequest& request, HttpCallback callback) {
+    if (!loop_)
+        throw std::runtime_error("cURL handle is invalid");
+    auto transfer = make_transfer(request, true);
+    transfer->callback = toTransferCallback(std::move(callback));
+    loop_->submit(std::move(transfer));
+}
+
+HttpResponse HttpClient::execute_hedged(HttpRequest& request, HttpHedging& hedging) {
+    if (!loop_)
+        throw std::runtime_error("cURL handle is invalid");
+
+    // Both transfers complete on the event loop, whichever answers first
+    // settles the race. A failure only does once the other one failed too
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool responded = false;
+        int pending = 0;
+        bool hedge_won = false;
+        std::optional<std::expected<HttpResponse, HttpTransportError>> result;
+        std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    };
+    auto race = std::make_shared<Race>();
+    std::shared_ptr<HttpHedging> policy = request.getHedging();
+
+    auto launch = [&](bool hedge) {
+        auto transfer = make_transfer(request, true);
+        transfer->cancelled = race->cancelled;
+        transfer->on_response = [race, policy, start = std::chrono::steady_clock::now()] {
+            policy->record(std::chrono::steady_clock::now() - start);
+            {
+                std::lock_guard lock(race->mutex);
+                race->responded = true;
+            }
+            race->changed.notify_all();
+        };
+        transfer->callback = [race, hedge](std::expected<HttpResponse, HttpTransportError> result) {
+            {
+                std::lock_guard lock(race->mutex);
+                race->pending--;
+                if (!race->result && (result || race->pending == 0)) {
+                    race->result.emplace(std::move(result));
+                    race->hedge_won = hedge;
+                }
+            }
+            race->changed.notify_all();
+        };
+        {
+            std::lock_guard lock(race->mutex);
+            race->pending++;
+        }
+        loop_->submit(std::move(transfer));
+    };
+
+    hedging.admit();
+    launch(false);
+
+    std::unique_lock lock(race->mutex);
+    if (!race->changed.wait_for(lock, hedging.delay(), [&] { return race->responded || race->result; }) && hedging.acquire()) {
+        lock.unlock();
+        launch(true);
+        lock.lock();
     }
-    std::string body_buf;
-    std::map<std::string, std::string, LowerCaseCompare> headers_buf;
-    std::string error_buf;
-
-    // TODO(cristian): from libcurl docs, they state that each curl handle has
-    // "sticky" params, this is why we are resetting at each get request
-    // However, I think we should only do this when moving a new handle the only
-    // thing that will change is the URL from now
-    //
-    // curl_easy_reset(curl_handle);
-
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, NULL);
-    curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 0L);
-    curl_easy_setopt(curl_handle, CURLOPT_URL, request.getURL().c_str());
-    // body callback
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, &body_buf);
-    // headers callback
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, &headers_buf);
+    race->changed.wait(lock, [&] { return race->result.has_value(); });
+    if (race->pending > 0) {
+        // Drop the loser, it is not worth its connection anymore
+        race->cancelled->store(true);
+        loop_->sweep();
+    }
+    if (race->hedge_won)
+        hedging.won_.fetch_add(1, std::memory_order_relaxed);
 
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, request.getTimeout());
+    std::expected<HttpResponse, HttpTransportError> result = std::move(*race->result);
+    if (!result)
+        throw result.error();
+    return std::move(*result);
+}
 
-    // merge client and request headers
-    // https://stackoverflow.com/questions/34321719
-    auto headers = request.getHeaders();
-    headers.insert(this->getHeaders().begin(), this->getHeaders().end());
-    struct curl_slist* list = NULL;
-    for (const auto& [k, v] : headers) {
-        list = curl_slist_append(list, std::format("{}: {}", k, v).c_str());
+template <typename T>
+std::unique_ptr<HttpTransfer> HttpClient::make_transfer(const HttpRequestBase<T>& request, bool own_body) const {
+    auto transfer = std::make_unique<HttpTransfer>();
+    transfer->url = request.getURL();
+    transfer->method = request.getHttpMethod();
+    transfer->timeout = request.getTimeout();
+    build_header_list(*transfer, request.getHeaders(), own_body);
+    // Room for a typical response, so its headers are read without regrowing
+    transfer->headers_buf.reserve(16, 1024);
+    transfer->sink = request.getSink();
+    transfer->receive_limit = download_limit_;
+    transfer->start_at = std::chrono::steady_clock::now() + request.getStartAfter();
+    if constexpr (std::is_same_v<T, HttpBodyRequest>) {
+        const std::string& body = static_cast<const HttpBodyRequest&>(request).getBody();
+        if (own_body) {
+            transfer->body_storage = body;
+            transfer->body = transfer->body_storage;
+        } else {
+            transfer->body = body;
+        }
+        const auto& body_request = static_cast<const HttpBodyRequest&>(request);
+        transfer->source = body_request.getBodySource();
+        transfer->rewind = body_request.getBodyRewind();
+        transfer->source_length = body_request.getBodySourceLength();
+        transfer->send_limit = upload_limit_;
+        // A limited upload has to go through `read_callback`, in-memory
+        // bodies are streamed from the transfer then
+        const bool uploads = transfer->method == HttpMethod::Put || transfer->method == HttpMethod::Post;
+        if (upload_limit_ && uploads && !transfer->source && !transfer->body.empty()) {
+            HttpTransfer* self = transfer.get();
+            auto offset = std::make_shared<size_t>(0);
+            transfer->source = [self, offset](char* buffer, size_t size) -> std::ptrdiff_t {
+                const size_t n = std::min(size, self->body.size() - *offset);
+                std::memcpy(buffer, self->body.data() + *offset, n);
+                *offset += n;
+                return static_cast<std::ptrdiff_t>(n);
+            };
+            transfer->rewind = [offset] {
+                *offset = 0;
+                return true;
+            };
+            transfer->source_length = transfer->body.size();
+        }
     }
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, list);
+    return transfer;
+}
+
+HttpResponse HttpClient::perform(HttpTransfer& transfer) {
+    HttpHandlePool::Lease lease = acquire(transfer.url);
+    CURL* curl_handle = lease.get();
+
+    prepare(curl_handle, transfer);
 
     CURLcode code = curl_easy_perform(curl_handle);
-    curl_slist_free_all(list);
-    if (code != CURLE_OK) {
-        throw std::runtime_error(
-            std::format("libcurl error: {}", curl_easy_strerror(code)));
-    }
+    // a sink stopping the transfer is the caller's decision, not a failure
+    if (code != CURLE_OK && !(code == CURLE_WRITE_ERROR && transfer.sink_stopped))
+        throw HttpTransportError(code, transfer.status);
 
     // get HTTP code
     long response_code = 0;
     curl_easy_getinfo(curl_handle, CURLINFO_HTTP_CODE, &response_code);
 
-    return HttpResponse(static_cast<int>(response_code), std::move(body_buf),
-        std::move(headers_buf));
+    return HttpResponse(static_cast<int>(response_code), std::move(transfer.body_buf),
+        std::move(transfer.headers_buf));
 }
 
-HttpResponse HttpClient::execute_head(HttpRequest& request) {
-    if (!curl_handle) {
+void HttpClient::prepare(CURL* curl_handle, HttpTransfer& transfer) {
+    curl_easy_setopt(curl_handle, CURLOPT_URL, transfer.url.c_str());
+    // body callback
+    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, &transfer);
+    // headers callback
+    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, &transfer);
+
+    switch (transfer.method) {
+    case HttpMethod::Get:
+        curl_easy_setopt(curl_handle, CURLOPT_HTTPGET, 1L);
+        break;
+    case HttpMethod::Head:
+        curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 1L);
+        break;
+    case HttpMethod::Post:
+    case HttpMethod::Put:
+        // post/put body
+        if (transfer.source) {
+            // streamed body, cURL pulls it through `read_callback` as it sends
+            curl_easy_setopt(curl_handle, CURLOPT_READFUNCTION, read_callback);
+            curl_easy_setopt(curl_handle, CURLOPT_READDATA, &transfer);
+            if (transfer.rewind) {
+                curl_easy_setopt(curl_handle, CURLOPT_SEEKFUNCTION, seek_callback);
+                curl_easy_setopt(curl_handle, CURLOPT_SEEKDATA, &transfer);
+            }
+            if (transfer.method == HttpMethod::Put) {
+                curl_easy_setopt(curl_handle, CURLOPT_UPLOAD, 1L);
+                curl_easy_setopt(curl_handle, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(transfer.source_length));
+            } else {
+                curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+                curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(transfer.source_length));
+            }
+            break;
+        }
+        if (transfer.method == HttpMethod::Put) {
+            curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, "PUT");
+        } else {
+            curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+        }
+        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, transfer.body.data());
+        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(transfer.body.size()));
+        break;
+    case HttpMethod::Delete:
+        // delete may have or not have a body
+        curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, "DELETE");
+        if (!transfer.body.empty()) {
+            curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, transfer.body.data());
+            curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(transfer.body.size()));
+        }
+        break;
+    }
+
+    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, transfer.timeout);
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, transfer.header_list);
+}
+
+HttpHandlePool::Lease HttpClient::acquire(const std::string& URL) {
+    if (!pool_) {
         throw std::runtime_error(
-            // this can happen both when cURL handle is not initialized or when it
-            // is invalidated in the HTTPClient copy constructor
+            // this can happen when the pool is invalidated in the HttpClient
+            // move constructor
             "cURL handle is invalid");
     }
-    std::map<std::string, std::string, LowerCaseCompare> headers_buf;
-    std::string error_buf;
-
-    curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, NULL);
-    curl_easy_setopt(curl_handle, CURLOPT_URL, request.getURL().c_str());
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, &headers_buf);
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, request.getTimeout());
+    // scheme://host[:port]/path -> host[:port]
+    size_t host_start = URL.find("://");
+    host_start = (host_start == std::string::npos) ? 0 : host_start + 3;
+    size_t host_end = URL.find_first_of("/?", host_start);
+    return pool_->acquire(URL.substr(host_start, host_end - host_start));
+}
 
-    curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 1L);
+void HttpClient::build_client_header_list() {
+    curl_slist* list = nullptr;
+    for (auto it = headers_.begin(); it != headers_.end(); ++it) {
+        curl_slist* appended = curl_slist_append(list, it.line().data());
+        if (!appended) {
+            curl_slist_free_all(list);
+            throw std::runtime_error("Failed to build the cURL header list");
+        }
+        list = appended;
+    }
+    header_list_.reset(list);
+}
 
-    // merge client and request headers
-    // https://stackoverflow.com/questions/34321719
-    auto headers = request.getHeaders();
-    headers.insert(this->getHeaders().begin(), this->getHeaders().end());
-    struct curl_slist* list = NULL;
-    for (const auto& [k, v] : headers) {
-        list = curl_slist_append(list, std::format("{}: {}", k, v).c_str());
+void HttpClient::build_header_list(HttpTransfer& transfer, const HttpHeaders& request_headers, bool own_headers) const {
+    const HttpHeaders* headers = &request_headers;
+    if (own_headers) {
+        transfer.header_storage = request_headers;
+        headers = &transfer.header_storage;
     }
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, list);
 
-    CURLcode code = curl_easy_perform(curl_handle);
-    curl_slist_free_all(list);
-    if (code != CURLE_OK) {
-        throw std::runtime_error(
-            std::format("libcurl error for request: {}", curl_easy_strerror(code)));
+    // The request headers win over the client ones of the same name, these
+    // have to be left out of the list. Rare, so the shared list is chained
+    // as a whole otherwise
+    bool overridden = false;
+    for (const auto& [name, value] : headers_)
+        overridden = overridden || headers->contains(name);
+
+    transfer.header_nodes.reserve(headers->size() + (overridden ? headers_.size() : 0));
+    // cURL only reads the lines, they can point straight into the headers
+    for (auto it = headers->begin(); it != headers->end(); ++it)
+        transfer.header_nodes.push_back(curl_slist { const_cast<char*>(it.line().data()), nullptr });
+    curl_slist* tail = header_list_.get();
+    if (overridden) {
+        // `header_list_` follows the order of `headers_`
+        curl_slist* node = header_list_.get();
+        for (const auto& [name, value] : headers_) {
+            if (!headers->contains(name))
+                transfer.header_nodes.push_back(curl_slist { node->data, nullptr });
+            node = node->next;
+        }
+        tail = nullptr;
     }
 
-    // get HTTP code
-    long response_code = 0;
-    curl_easy_getinfo(curl_handle, CURLINFO_HTTP_CODE, &response_code);
+    for (size_t i = 0; i < transfer.header_nodes.size(); i++)
+        transfer.header_nodes[i].next = (i + 1 < transfer.header_nodes.size()) ? &transfer.header_nodes[i + 1] : tail;
+    transfer.header_list = transfer.header_nodes.empty() ? tail : transfer.header_nodes.data();
+}
 
-    return HttpResponse(static_cast<int>(response_code), std::move(headers_buf));
+HttpHandlePool::HttpHandlePool(const HttpClientOptions& options)
+    : options_(options) {
+    if (options_.max_connections == 0 || options_.max_connections_per_host == 0)
+        throw std::invalid_argument("HttpClientOptions: connection limits must be greater than 0");
+
+    share_ = curl_share_init();
+    if (!share_)
+        throw std::runtime_error("Failed to initialize cURL share handle");
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock_callback);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock_callback);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
 }
 
-HttpResponse HttpClient::execute_post(HttpBodyRequest& request) {
-    if (!curl_handle) {
-        throw std::runtime_error(
-            // this can happen both when cURL handle is not initialized or when it
-            // is invalidated in the HTTPClient copy constructor
-            "cURL handle is invalid");
+HttpHandlePool::~HttpHandlePool() {
+    // All leases must have been returned by now
+    for (const auto& idle : idle_)
+        curl_easy_cleanup(idle.handle);
+    if (share_)
+        curl_share_cleanup(share_);
+}
+
+HttpHandlePool::Lease HttpHandlePool::acquire(const std::string& host) {
+    std::unique_lock lock(mutex_);
+    available_.wait(lock, [&] {
+        auto it = in_use_per_host_.find(host);
+        size_t host_in_use = (it != in_use_per_host_.end()) ? it->second : 0;
+        return in_use_ < options_.max_connections && host_in_use < options_.max_connections_per_host;
+    });
+    in_use_++;
+    in_use_per_host_[host]++;
+
+    const auto now = std::chrono::steady_clock::now();
+    evict_idle(now);
+
+    CURL* handle = nullptr;
+    if (!idle_.empty()) {
+        // most recently used first, it is the most likely to be warm
+        handle = idle_.back().handle;
+        idle_.pop_back();
+    }
+    lock.unlock();
+
+    if (!handle) {
+        handle = curl_easy_init();
+        if (!handle) {
+            release(nullptr, host);
+            throw std::runtime_error("Failed to initialize cURL");
+        }
     }
-    std::string body_buf;
-    std::map<std::string, std::string, LowerCaseCompare> headers_buf;
-    std::string error_buf;
 
-    // TODO(cristian): from libcurl docs, they state that each curl handle has
-    // "sticky" params, this is why we are resetting at each get request
-    // However, I think we should only do this when moving a new handle the only
-    // thing that will change is the URL from now
-    //
-    // curl_easy_reset(curl_handle);
+    // Handles go back to the pool reset, so these must be set on every checkout
+    curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, static_cast<long>(options_.idle_timeout.count()));
 
-    curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 0L);
-    curl_easy_setopt(curl_handle, CURLOPT_URL, request.getURL().c_str());
-    // body callback
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, &body_buf);
-    // headers callback
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, &headers_buf);
-    // post/put body
-    if (request.getHttpMethod() == HttpMethod::Put) {
-        curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, "PUT");
-    } else {
-        curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+    return Lease(*this, handle, host);
+}
+
+void HttpHandlePool::release(CURL* handle, const std::string& host) {
+    // from libcurl docs: each handle has "sticky" params, resetting keeps the
+    // live connections, DNS cache and TLS session cache
+    if (handle)
+        curl_easy_reset(handle);
+
+    {
+        std::lock_guard lock(mutex_);
+        in_use_--;
+        if (auto it = in_use_per_host_.find(host); it != in_use_per_host_.end() && --it->second == 0)
+            in_use_per_host_.erase(it);
+        const auto now = std::chrono::steady_clock::now();
+        evict_idle(now);
+        if (handle)
+            idle_.push_back(IdleHandle { handle, now });
+    }
+    available_.notify_all();
+}
+
+void HttpHandlePool::evict_idle(std::chrono::steady_clock::time_point now) {
+    // `idle_` is sorted by release time, the oldest handles are at the front
+    auto first_alive = idle_.begin();
+    while (first_alive != idle_.end() && now - first_alive->since > options_.idle_timeout) {
+        curl_easy_cleanup(first_alive->handle);
+        first_alive++;
     }
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, request.getBody().c_str());
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, request.getBody().size());
+    idle_.erase(idle_.begin(), first_alive);
+}
 
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, request.getTimeout());
+size_t HttpHandlePool::idle() const {
+    std::lock_guard lock(mutex_);
+    return idle_.size();
+}
 
-    // merge client and request headers
-    // https://stackoverflow.com/questions/34321719
-    auto headers = request.getHeaders();
-    headers.insert(this->getHeaders().begin(), this->getHeaders().end());
-    struct curl_slist* list = NULL;
-    for (const auto& [k, v] : headers) {
-        list = curl_slist_append(list, std::format("{}: {}", k, v).c_str());
+size_t HttpHandlePool::in_use() const {
+    std::lock_guard lock(mutex_);
+    return in_use_;
+}
+
+void HttpHandlePool::lock_callback(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    auto pool = static_cast<HttpHandlePool*>(userptr);
+    pool->share_locks_[data].lock();
+}
+
+void HttpHandlePool::unlock_callback(CURL*, curl_lock_data data, void* userptr) {
+    auto pool = static_cast<HttpHandlePool*>(userptr);
+    pool->share_locks_[data].unlock();
+}
+
+HttpEventLoop::HttpEventLoop(const HttpClientOptions& options)
+    : max_free_handles_(options.max_connections) {
+    multi_handle = curl_multi_init();
+    if (!multi_handle)
+        throw std::runtime_error("Failed to initialize cURL multi handle");
+    // The multi handle keeps its own connection and DNS cache
+    curl_multi_setopt(multi_handle, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(options.max_connections));
+    curl_multi_setopt(multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options.max_connections_per_host));
+    curl_multi_setopt(multi_handle, CURLMOPT_MAXCONNECTS, static_cast<long>(options.max_connections));
+}
+
+HttpEventLoop::~HttpEventLoop() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    if (thread_.joinable()) {
+        curl_multi_wakeup(multi_handle);
+        thread_.join();
     }
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, list);
+    // the loop is gone, fail whatever was not even started
+    for (auto& transfer : submitted_)
+        complete(*transfer, std::unexpected(cancelledError()));
+    for (CURL* handle : free_handles_)
+        curl_easy_cleanup(handle);
+    curl_multi_cleanup(multi_handle);
+}
 
-    CURLcode code = curl_easy_perform(curl_handle);
-    curl_slist_free_all(list);
-    if (code != CURLE_OK) {
-        throw std::runtime_error(
-            std::format("libcurl error for request: {}", curl_easy_strerror(code)));
+void HttpEventLoop::sweep() {
+    {
+        std::lock_guard lock(mutex_);
+        sweep_ = true;
     }
+    curl_multi_wakeup(multi_handle);
+}
 
-    // get HTTP code
-    long response_code = 0;
-    curl_easy_getinfo(curl_handle, CURLINFO_HTTP_CODE, &response_code);
+void HttpEventLoop::drop_cancelled() {
+    for (auto it = delayed_.begin(); it != delayed_.end();) {
+        if (it->second->cancelled && *it->second->cancelled) {
+            complete(*it->second, std::unexpected(cancelledError()));
+            it = delayed_.erase(it);
+        } else {
+            ++it;
+        }
+    }
 
-    return HttpResponse(static_cast<int>(response_code), std::move(body_buf),
-        std::move(headers_buf));
+    std::vector<CURL*> dropped;
+    for (const auto& [handle, transfer] : running_) {
+        if (transfer->cancelled && *transfer->cancelled)
+            dropped.push_back(handle);
+    }
+    for (CURL* handle : dropped) {
+        auto node = running_.extract(handle);
+        curl_multi_remove_handle(multi_handle, handle);
+        // the connection is closed along with the transfer
+        recycle(handle, *node.mapped());
+        complete(*node.mapped(), std::unexpected(cancelledError()));
+    }
 }
 
-HttpResponse HttpClient::execute_delete(HttpBodyRequest& request) {
-    if (!curl_handle) {
-        throw std::runtime_error(
-            // this can happen both when cURL handle is not initialized or when it
-            // is invalidated in the HTTPClient copy constructor
-            "cURL handle is invalid");
+void HttpEventLoop::submit(std::unique_ptr<HttpTransfer> transfer) {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_)
+            throw std::runtime_error("cURL event loop is stopping");
+        submitted_.push_back(std::move(transfer));
+        if (!thread_.joinable())
+            thread_ = std::thread(&HttpEventLoop::run, this);
     }
-    std::string body_buf;
-    std::map<std::string, std::string, LowerCaseCompare> headers_buf;
-    std::string error_buf;
+    curl_multi_wakeup(multi_handle);
+}
 
-    // TODO(cristian): from libcurl docs, they state that each curl handle has
-    // "sticky" params, this is why we are resetting at each get request
-    // However, I think we should only do this when moving a new handle the only
-    // thing that will change is the URL from now
-    //
-    // curl_easy_reset(curl_handle);
+void HttpEventLoop::run() {
+    std::vector<std::unique_ptr<HttpTransfer>> incoming;
+    while (true) {
+        bool sweep = false;
+        {
+            std::lock_guard lock(mutex_);
+            if (stopping_)
+                break;
+            incoming.swap(submitted_);
+            std::swap(sweep, sweep_);
+        }
+        const auto now = std::chrono::steady_clock::now();
+        for (auto& transfer : incoming) {
+            if (transfer->start_at > now)
+                delayed_.emplace(transfer->start_at, std::move(transfer));
+            else
+                start(std::move(transfer));
+        }
+        incoming.clear();
+        if (sweep)
+            drop_cancelled();
+
+        int still_running = 0;
+        curl_multi_perform(multi_handle, &still_running);
+
+        int msgs_left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_handle, &msgs_left)) {
+            if (msg->msg == CURLMSG_DONE)
+                finish(msg->easy_handle, msg->data.result);
+        }
+
+        // wakes up on socket activity, timeouts, `curl_multi_wakeup()` or
+        // when a paused or delayed transfer is due to resume or start
+        const std::chrono::milliseconds timeout = std::min(throttle(), start_due());
+        curl_multi_poll(multi_handle, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    }
 
-    curl_easy_setopt(curl_handle, CURLOPT_URL, request.getURL().c_str());
-    // body callback
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, &body_buf);
-    // headers callback
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, &headers_buf);
-    // delete may have or not have a body
-    curl_easy_setopt(curl_handle, CURLOPT_CUSTOMREQUEST, "DELETE");
-    if (request.getBody() != "") // use std::optional
-        curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, request.getBody().c_str());
+    // Cancel everything still in flight
+    for (auto& [handle, transfer] : running_) {
+        curl_multi_remove_handle(multi_handle, handle);
+        curl_easy_cleanup(handle);
+        complete(*transfer, std::unexpected(cancelledError()));
+    }
+    running_.clear();
+    for (auto& [start_at, transfer] : delayed_)
+        complete(*transfer, std::unexpected(cancelledError()));
+    delayed_.clear();
+}
 
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, request.getTimeout());
+void HttpEventLoop::recycle(CURL* handle, const HttpTransfer& transfer) {
+    // a transfer may end while paused, such a handle is not worth reusing
+    if (transfer.paused != CURLPAUSE_CONT || free_handles_.size() >= max_free_handles_) {
+        curl_easy_cleanup(handle);
+        return;
+    }
+    curl_easy_reset(handle);
+    free_handles_.push_back(handle);
+}
 
-    // merge client and request headers
-    // https://stackoverflow.com/questions/34321719
-    auto headers = request.getHeaders();
-    headers.insert(this->getHeaders().begin(), this->getHeaders().end());
-    struct curl_slist* list = NULL;
-    for (const auto& [k, v] : headers) {
-        list = curl_slist_append(list, std::format("{}: {}", k, v).c_str());
+std::chrono::milliseconds HttpEventLoop::throttle() {
+    std::chrono::nanoseconds next = std::chrono::seconds(1);
+    for (auto& [handle, transfer] : running_) {
+        int paused = CURLPAUSE_CONT;
+        auto check = [&next, &paused](const std::shared_ptr<RateLimiter>& limit, int direction) {
+            if (!limit)
+                return;
+            const std::chrono::nanoseconds wait = limit->waitTime();
+            if (wait > std::chrono::nanoseconds::zero()) {
+                paused |= direction;
+                next = std::min(next, wait);
+            }
+        };
+        check(transfer->send_limit, CURLPAUSE_SEND);
+        check(transfer->receive_limit, CURLPAUSE_RECV);
+        if (paused != transfer->paused) {
+            transfer->paused = paused;
+            curl_easy_pause(handle, paused);
+        }
     }
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, list);
+    return std::max(std::chrono::ceil<std::chrono::milliseconds>(next), std::chrono::milliseconds(1));
+}
 
-    CURLcode code = curl_easy_perform(curl_handle);
-    curl_slist_free_all(list);
-    if (code != CURLE_OK) {
-        throw std::runtime_error(
-            std::format("libcurl error for request: {}", curl_easy_strerror(code)));
+std::chrono::milliseconds HttpEventLoop::start_due() {
+    const auto now = std::chrono::steady_clock::now();
+    while (!delayed_.empty() && delayed_.begin()->first <= now)
+        start(std::move(delayed_.extract(delayed_.begin()).mapped()));
+    if (delayed_.empty())
+        return std::chrono::seconds(1);
+    return std::max(std::chrono::ceil<std::chrono::milliseconds>(delayed_.begin()->first - now), std::chrono::milliseconds(1));
+}
+
+void HttpEventLoop::start(std::unique_ptr<HttpTransfer> transfer) {
+    if (transfer->cancelled && *transfer->cancelled) {
+        complete(*transfer, std::unexpected(cancelledError()));
+        return;
+    }
+    CURL* handle = nullptr;
+    if (!free_handles_.empty()) {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+    } else {
+        handle = curl_easy_init();
+    }
+    if (!handle) {
+        complete(*transfer, std::unexpected(HttpTransportError(CURLE_FAILED_INIT, 0, "Failed to initialize cURL")));
+        return;
     }
 
-    // get HTTP code
-    long response_code = 0;
-    curl_easy_getinfo(curl_handle, CURLINFO_HTTP_CODE, &response_code);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    transfer->on_loop = true;
+    HttpClient::prepare(handle, *transfer);
+    curl_multi_add_handle(multi_handle, handle);
+    running_.emplace(handle, std::move(transfer));
+}
 
-    return HttpResponse(static_cast<int>(response_code), std::move(body_buf),
-        std::move(headers_buf));
+void HttpEventLoop::finish(CURL* handle, CURLcode code) {
+    auto node = running_.extract(handle);
+    curl_multi_remove_handle(multi_handle, handle);
+    std::unique_ptr<HttpTransfer> transfer = std::move(node.mapped());
+
+    std::expected<HttpResponse, HttpTransportError> result = std::unexpected(HttpTransportError(code, transfer->status));
+    if (code == CURLE_OK || (code == CURLE_WRITE_ERROR && transfer->sink_stopped)) {
+        long response_code = 0;
+        curl_easy_getinfo(handle, CURLINFO_HTTP_CODE, &response_code);
+        result = HttpResponse(static_cast<int>(response_code), std::move(transfer->body_buf),
+            std::move(transfer->headers_buf));
+    }
+
+    recycle(handle, *transfer);
+    complete(*transfer, std::move(result));
 }
 
 size_t HttpClient::write_callback(char* ptr, size_t size, size_t nmemb,
     void* userdata) {
-    std::string* buffer = static_cast<std::string*>(userdata);
+    HttpTransfer* transfer = static_cast<HttpTransfer*>(userdata);
     size_t total_size = size * nmemb;
-    buffer->append(ptr, total_size);
+    if (transfer->receive_limit) {
+        // held by cURL and handed again once resumed
+        if (pause(*transfer, *transfer->receive_limit, CURLPAUSE_RECV))
+            return CURL_WRITEFUNC_PAUSE;
+        charge(*transfer, *transfer->receive_limit, total_size);
+    }
+    if (transfer->sink && transfer->status >= 200 && transfer->status < 300) {
+        if (!transfer->sink(std::string_view { ptr, total_size })) {
+            // returning less than `total_size` aborts with CURLE_WRITE_ERROR
+            transfer->sink_stopped = true;
+            return 0;
+        }
+        return total_size;
+    }
+    transfer->body_buf.append(ptr, total_size);
     return total_size;
 }
 
+size_t HttpClient::read_callback(char* buffer, size_t size, size_t nitems,
+    void* userdata) {
+    HttpTransfer* transfer = static_cast<HttpTransfer*>(userdata);
+    if (transfer->send_limit && pause(*transfer, *transfer->send_limit, CURLPAUSE_SEND))
+        return CURL_READFUNC_PAUSE;
+    std::ptrdiff_t read = transfer->source(buffer, size * nitems);
+    if (read < 0)
+        return CURL_READFUNC_ABORT;
+    if (transfer->send_limit)
+        charge(*transfer, *transfer->send_limit, static_cast<size_t>(read));
+    return static_cast<size_t>(read);
+}
+
+int HttpClient::seek_callback(void* userdata, curl_off_t offset, int origin) {
+    // cURL only ever seeks back to the start of the body
+    HttpTransfer* transfer = static_cast<HttpTransfer*>(userdata);
+    if (offset != 0 || origin != SEEK_SET)
+        return CURL_SEEKFUNC_CANTSEEK;
+    return transfer->rewind() ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+}
+
 size_t HttpClient::header_callback(char* buffer, size_t size, size_t nitems,
     void* userdata) {
     // from libcurl docs:
     // The header callback is called once for each header and
     // only complete header lines are passed on to the callback.
-    auto headers = static_cast<std::map<std::string, std::string>*>(userdata);
+    HttpTransfer* transfer = static_cast<HttpTransfer*>(userdata);
     size_t total_size = size * nitems;
 
-    std::string line(buffer, total_size);
-
-    if (line.find(":") == std::string::npos || line == "\r\n" || line == "\n") {
+    std::string_view line(buffer, total_size);
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+        line.remove_suffix(1);
+
+    // Status line, i.e. `HTTP/1.1 200 OK`, there may be more than one
+    // (100 Continue, redirects) and the last one is the one that counts
+    if (line.starts_with("HTTP/")) {
+        if (size_t code_start = line.find(' '); code_start != std::string_view::npos)
+            std::from_chars(line.data() + code_start + 1, line.data() + line.size(), transfer->status);
+        if (transfer->on_response)
+            std::exchange(transfer->on_response, nullptr)();
         return total_size;
     }
 
-    size_t separator = line.find(":");
-    if (separator != std::string::npos) {
-        std::string k = line.substr(0, separator);
-        std::string v = line.substr(separator + 2); // `:_<here>` advance 2
-        v.erase(v.find_last_not_of("\r\n") + 1); // .strip()
-        (*headers)[k] = v;
-    }
+    size_t separator = line.find(':');
+    if (separator == std::string_view::npos)
+        return total_size;
+
+    std::string_view value = line.substr(separator + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    transfer->headers_buf.set(line.substr(0, separator), value);
 
     return total_size;
 }
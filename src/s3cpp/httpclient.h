@@ -1,14 +1,33 @@
 #ifndef S3CPP_HTTPCLIENT
 #define S3CPP_HTTPCLIENT
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <curl/multi.h>
+#include <expected>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <s3cpp/limiter.h>
+#include <s3cpp/retry.h>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Forward declaration
 class HttpClient;
@@ -21,14 +40,114 @@ enum class HttpMethod {
     Delete
 };
 
-struct LowerCaseCompare { // A custom lambda to sort keys alphabetically
-    bool operator()(const std::string& a, const std::string& b) const {
-        std::string sa = a;
-        std::string sb = b;
-        std::transform(sa.begin(), sa.end(), sa.begin(), ::tolower);
-        std::transform(sb.begin(), sb.end(), sb.begin(), ::tolower);
-        return sa < sb;
+// Orders header names alphabetically, ignoring case. Compares in place, no
+// lowercased copies of either side
+struct LowerCaseCompare {
+    using is_transparent = void;
+
+    static constexpr char lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    static constexpr bool equal(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return lower(x) == lower(y); });
     }
+    constexpr bool operator()(std::string_view a, std::string_view b) const {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) { return lower(x) < lower(y); });
+    }
+};
+
+// Header fields of a request or a response, sorted by name (LowerCaseCompare)
+//
+// Every field is kept as its `Name: value` line, NUL-terminated, packed in a
+// single buffer and indexed by a flat vector. A message costs the same two
+// allocations however many headers it has, and the lines can be handed to
+// cURL as they are. Names and values are views into the buffer, valid until
+// the headers are modified
+class HttpHeaders {
+    struct Entry {
+        uint32_t offset;
+        uint32_t name_size;
+        uint32_t value_size;
+    };
+
+public:
+    using value_type = std::pair<std::string_view, std::string_view>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = HttpHeaders::value_type;
+        using reference = value_type;
+        struct pointer {
+            value_type field;
+            const value_type* operator->() const { return &field; }
+        };
+
+        const_iterator() = default;
+
+        value_type operator*() const {
+            const char* name = buffer_ + entry_->offset;
+            return { { name, entry_->name_size }, { name + entry_->name_size + 2, entry_->value_size } };
+        }
+        pointer operator->() const { return { **this }; }
+        // `Name: value`, followed by a NUL in the buffer
+        std::string_view line() const {
+            return { buffer_ + entry_->offset, entry_->name_size + 2 + entry_->value_size };
+        }
+
+        const_iterator& operator++() {
+            ++entry_;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++entry_;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const { return entry_ == other.entry_; }
+
+    private:
+        friend class HttpHeaders;
+        const_iterator(const char* buffer, const Entry* entry)
+            : buffer_(buffer)
+            , entry_(entry) { }
+
+        const char* buffer_ = nullptr;
+        const Entry* entry_ = nullptr;
+    };
+    using iterator = const_iterator;
+
+    HttpHeaders() = default;
+    HttpHeaders(std::initializer_list<value_type> fields);
+
+    const_iterator begin() const { return { buffer_.data(), entries_.data() }; }
+    const_iterator end() const { return { buffer_.data(), entries_.data() + entries_.size() }; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    const_iterator find(std::string_view name) const;
+    bool contains(std::string_view name) const { return find(name) != end(); }
+    // Throws std::out_of_range when there is no such header
+    std::string_view at(std::string_view name) const;
+
+    // Adds the header or replaces its value, a replaced header keeps the
+    // spelling of its name
+    void set(std::string_view name, std::string_view value);
+    void reserve(size_t fields, size_t bytes);
+    void clear();
+
+    // Same names, spelled the same, with the same values
+    bool operator==(const HttpHeaders& other) const;
+
+private:
+    std::string buffer_;
+    std::vector<Entry> entries_;
+
+    std::string_view name(const Entry& entry) const { return { buffer_.data() + entry.offset, entry.name_size }; }
+    std::vector<Entry>::const_iterator lower_bound(std::string_view name) const;
 };
 
 class HttpResponse {
@@ -38,10 +157,10 @@ public:
     HttpResponse(int c, std::string b)
         : code_(c)
         , body_(std::move(b)) { };
-    HttpResponse(int c, std::map<std::string, std::string, LowerCaseCompare> h)
+    HttpResponse(int c, HttpHeaders h)
         : code_(c)
         , headers_(std::move(h)) { };
-    HttpResponse(int c, std::string b, std::map<std::string, std::string, LowerCaseCompare> h)
+    HttpResponse(int c, std::string b, HttpHeaders h)
         : code_(c)
         , body_(std::move(b))
         , headers_(std::move(h)) { };
@@ -49,7 +168,7 @@ public:
     // Getters
     int status() const { return code_; }
     const std::string& body() const { return body_; }
-    const auto& headers() const { return headers_; }
+    const HttpHeaders& headers() const { return headers_; }
 
     // Status via code
     bool is_ok() const { return code_ >= 200 && code_ < 300; }
@@ -64,9 +183,114 @@ public:
 private:
     int code_;
     std::string body_;
-    std::map<std::string, std::string, LowerCaseCompare> headers_;
+    HttpHeaders headers_;
+};
+
+// Thrown by `execute()` when the transfer itself fails, i.e. the connection
+// could not be made or broke halfway. `status()` is the one of the response
+// if it had started to arrive, 0 otherwise
+class HttpTransportError : public std::runtime_error {
+public:
+    HttpTransportError(CURLcode code, int status)
+        : HttpTransportError(code, status, std::string("libcurl error: ") + curl_easy_strerror(code)) { }
+    HttpTransportError(CURLcode code, int status, const std::string& message)
+        : std::runtime_error(message)
+        , code_(code)
+        , status_(status) { }
+
+    CURLcode code() const { return code_; }
+    int status() const { return status_; }
+
+private:
+    CURLcode code_;
+    int status_;
+};
+
+// Completion callback of an asynchronous request, on transport errors it
+// receives the same libcurl message the synchronous `execute()` throws
+using HttpCallback = std::function<void(std::expected<HttpResponse, std::string>)>;
+
+// Completion of a transfer on the event loop, transport errors keep their code
+using HttpTransferCallback = std::function<void(std::expected<HttpResponse, HttpTransportError>)>;
+
+struct HttpHedgingOptions {
+    // A duplicate is sent once a request waits for its first byte longer
+    // than this percentile of the recent times to first byte
+    double percentile = 95;
+    // Used until `min_samples` times to first byte have been seen
+    std::chrono::milliseconds initial_delay = std::chrono::milliseconds(50);
+    size_t min_samples = 20;
+    // Hedges are never sent sooner than this
+    std::chrono::milliseconds min_delay = std::chrono::milliseconds(5);
+    // At most this fraction of the requests is hedged, with bursts of up to
+    // `burst` hedges in a row
+    double max_ratio = 0.05;
+    size_t burst = 10;
+};
+
+struct HttpHedgingStats {
+    // Requests that could have been hedged
+    uint64_t requests = 0;
+    // Duplicates sent
+    uint64_t hedged = 0;
+    // Duplicates that answered first
+    uint64_t won = 0;
+};
+
+// Hedged requests: when a request has not received its first byte after the
+// usual time to first byte of the recent requests, a duplicate is sent on
+// another connection. The first response wins and the other transfer is
+// cancelled. A few slow front-ends no longer set the tail latency
+//
+// Shared by all the requests it is attached to (see `HttpRequest::hedge()`),
+// safe to use from any thread. Only meant for idempotent requests
+class HttpHedging {
+public:
+    explicit HttpHedging(const HttpHedgingOptions& options = {});
+
+    // How long a request waits for its first byte before it is hedged
+    std::chrono::nanoseconds delay() const;
+    void record(std::chrono::nanoseconds time_to_first_byte);
+    HttpHedgingStats stats() const;
+
+private:
+    friend class HttpClient;
+
+    static constexpr size_t Samples = 256;
+
+    HttpHedgingOptions options_;
+    // Every request adds a token to the budget, every hedge takes `hedge_cost_`
+    size_t hedge_cost_;
+    RetryBudget budget_;
+
+    mutable std::mutex mutex_;
+    // Ring of the last `Samples` times to first byte
+    std::vector<std::chrono::nanoseconds> samples_;
+    size_t next_sample_ = 0;
+
+    std::atomic<uint64_t> requests_ = 0;
+    std::atomic<uint64_t> hedged_ = 0;
+    std::atomic<uint64_t> won_ = 0;
+
+    // Counts a request
+    void admit();
+    // Takes the budget of a hedge, false when there is not enough left
+    bool acquire();
 };
 
+// Receives the body of a successful (2xx) response chunk by chunk, as soon as
+// it arrives. Returning false stops the transfer. Error bodies are still
+// buffered on `HttpResponse::body()`
+using HttpBodySink = std::function<bool(std::string_view chunk)>;
+
+// Produces the request body on demand, filling at most `size` bytes of
+// `buffer`. Returns how many bytes were written, 0 once the body is done and
+// a negative value to abort the transfer
+using HttpBodySource = std::function<std::ptrdiff_t(char* buffer, size_t size)>;
+// Restarts a body source from its first byte, libcurl needs this to resend
+// the body (i.e. after a redirect). Returns false when it is not possible
+using HttpBodyRewind = std::function<bool()>;
+
 // HttpRequest will handle all the headers and request params
 //
 // Curiously Recurring Template Pattern (CRTP)
@@ -85,7 +309,10 @@ public:
         : client_(client)
         , URL_(std::move(URL))
         , http_method_(std::move(http_method))
-        , timeout_(0) { };
+        , timeout_(0) {
+        // Enough for a signed request, so headers are added without regrowing
+        headers_.reserve(8, 512);
+    };
 
     T& timeout(const long long& seconds) {
         timeout_ = std::chrono::seconds(seconds);
@@ -95,17 +322,34 @@ public:
         timeout_ = seconds;
         return static_cast<T&>(*this);
     }
-    T& header(const std::string& header_, const std::string& value) {
-        headers_[header_] = value;
+    T& header(std::string_view header_, std::string_view value) {
+        headers_.set(header_, value);
+        return static_cast<T&>(*this);
+    }
+    // Replaces every header set so far
+    T& headers(HttpHeaders headers) {
+        headers_ = std::move(headers);
+        return static_cast<T&>(*this);
+    }
+    T& sink(HttpBodySink body_sink) {
+        sink_ = std::move(body_sink);
+        return static_cast<T&>(*this);
+    }
+    // Asynchronous executions only: the event loop holds the transfer back
+    // for `delay` before starting it, without blocking the other transfers
+    T& start_after(std::chrono::nanoseconds delay) {
+        start_after_ = delay;
         return static_cast<T&>(*this);
     }
 
     const std::string& getURL() const { return URL_; }
     const HttpMethod& getHttpMethod() const { return http_method_; }
     const long long getTimeout() const { return timeout_.count(); }
-    const std::map<std::string, std::string, LowerCaseCompare>& getHeaders() const {
+    const HttpHeaders& getHeaders() const {
         return headers_;
     }
+    const HttpBodySink& getSink() const { return sink_; }
+    std::chrono::nanoseconds getStartAfter() const { return start_after_; }
 
     // Cannonicalize HTTP verb from the request
     const std::string getHttpMethodStr(const HttpMethod& http_method) const {
@@ -128,16 +372,34 @@ public:
 protected:
     HttpClient& client_;
     std::string URL_;
-    std::map<std::string, std::string, LowerCaseCompare> headers_;
+    HttpHeaders headers_;
     std::chrono::seconds timeout_;
     HttpMethod http_method_;
+    HttpBodySink sink_;
+    std::chrono::nanoseconds start_after_ { 0 };
 };
 
 // GET/HEAD
 class HttpRequest : public HttpRequestBase<HttpRequest> {
 public:
     using HttpRequestBase::HttpRequestBase;
+
+    // Hedge the request (see `HttpHedging`) when it is executed synchronously
+    // and without a sink, a sink cannot be handed two bodies
+    HttpRequest& hedge(std::shared_ptr<HttpHedging> hedging) {
+        hedging_ = std::move(hedging);
+        return *this;
+    }
+    const std::shared_ptr<HttpHedging>& getHedging() const { return hedging_; }
+
     HttpResponse execute();
+
+    // Non-blocking, the callback runs on the event loop thread of the client
+    void execute_async(HttpCallback callback);
+    std::future<HttpResponse> execute_async();
+
+private:
+    std::shared_ptr<HttpHedging> hedging_;
 };
 
 // POST/PUT
@@ -149,59 +411,268 @@ public:
     }
 
     HttpBodyRequest& body(const std::string& data) {
+        body_ = data;
+        return (*this);
+    }
+    HttpBodyRequest& body(std::string&& data) {
         body_ = std::move(data);
         return (*this);
     }
+    // Stream the body from `source` instead of holding it in memory, the
+    // length has to be known upfront as it is sent as Content-Length
+    HttpBodyRequest& body(HttpBodySource source, uint64_t content_length, HttpBodyRewind rewind = {}) {
+        source_ = std::move(source);
+        source_length_ = content_length;
+        rewind_ = std::move(rewind);
+        return (*this);
+    }
 
     const std::string& getBody() const { return body_; }
+    const HttpBodySource& getBodySource() const { return source_; }
+    const HttpBodyRewind& getBodyRewind() const { return rewind_; }
+    uint64_t getBodySourceLength() const { return source_length_; }
 
     HttpResponse execute();
 
+    // Non-blocking, the callback runs on the event loop thread of the client
+    void execute_async(HttpCallback callback);
+    std::future<HttpResponse> execute_async();
+
 private:
     std::string body_ = "";
+    HttpBodySource source_;
+    HttpBodyRewind rewind_;
+    uint64_t source_length_ = 0;
+};
+
+struct HttpClientOptions {
+    // Maximum number of requests in flight at once (one easy handle each)
+    size_t max_connections = 64;
+    // Maximum number of requests in flight against the same host
+    size_t max_connections_per_host = 16;
+    // Pooled handles and keep-alive connections idle for longer are evicted
+    std::chrono::seconds idle_timeout = std::chrono::seconds(60);
+};
+
+// Pool of reusable cURL easy handles
+//
+// All the handles are attached to the same CURLSH, so the DNS cache, the TLS
+// sessions and the connection cache are shared between them. That is, any
+// handle we check out is able to reuse a warm keep-alive connection, even if
+// the connection was opened by a different handle
+class HttpHandlePool {
+public:
+    // RAII guard over a checked out handle, it goes back to the pool on destruction
+    class Lease {
+    public:
+        Lease(HttpHandlePool& pool, CURL* handle, std::string host)
+            : pool_(&pool)
+            , handle_(handle)
+            , host_(std::move(host)) { }
+        ~Lease() {
+            if (pool_)
+                pool_->release(handle_, host_);
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other)
+            : pool_(other.pool_)
+            , handle_(other.handle_)
+            , host_(std::move(other.host_)) {
+            other.pool_ = nullptr;
+            other.handle_ = nullptr;
+        }
+        Lease& operator=(Lease&&) = delete;
+
+        CURL* get() const { return handle_; }
+
+    private:
+        HttpHandlePool* pool_;
+        CURL* handle_;
+        std::string host_;
+    };
+
+    HttpHandlePool(const HttpClientOptions& options);
+    ~HttpHandlePool();
+
+    HttpHandlePool(const HttpHandlePool&) = delete;
+    HttpHandlePool& operator=(const HttpHandlePool&) = delete;
+
+    // Blocks while `max_connections` (or `max_connections_per_host`) are in use
+    Lease acquire(const std::string& host);
+
+    const HttpClientOptions& options() const { return options_; }
+    size_t idle() const;
+    size_t in_use() const;
+
+private:
+    struct IdleHandle {
+        CURL* handle;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    HttpClientOptions options_;
+    CURLSH* share_ = nullptr;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> share_locks_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    // LIFO, the most recently used handle is at the back
+    std::vector<IdleHandle> idle_;
+    std::unordered_map<std::string, size_t> in_use_per_host_;
+    size_t in_use_ = 0;
+
+    void release(CURL* handle, const std::string& host);
+    // expects `mutex_` to be held
+    void evict_idle(std::chrono::steady_clock::time_point now);
+
+    static void lock_callback(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock_callback(CURL* handle, curl_lock_data data, void* userptr);
 };
 
-// HttpClient should only focus on handling the cURL handle
+// State of a single request while it is being transferred
+//
+// The synchronous path points `body` and `header_list` to the request, the
+// asynchronous path outlives the request so it keeps its own copy of them in
+// `body_storage` and `header_storage`
+struct HttpTransfer {
+    std::string url;
+    HttpMethod method;
+    std::string body_storage;
+    std::string_view body;
+    long long timeout = 0;
+    HttpHeaders header_storage;
+    // one node per request header line, chained to the prebuilt list of the
+    // client headers. `header_list` is the head of the whole list
+    std::vector<curl_slist> header_nodes;
+    curl_slist* header_list = nullptr;
+
+    // status of the last response line seen, so the body can be routed
+    // to the sink or to `body_buf` before the transfer is done
+    int status = 0;
+    std::string body_buf;
+    HttpHeaders headers_buf;
+    HttpBodySink sink;
+    bool sink_stopped = false;
+    // streamed request body, takes precedence over `body`
+    HttpBodySource source;
+    HttpBodyRewind rewind;
+    uint64_t source_length = 0;
+    HttpTransferCallback callback;
+    // called once the status line of the response arrives
+    std::function<void()> on_response;
+    // set to have the event loop drop the transfer, it completes with an error
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    // bandwidth limits of the client, bodies only
+    std::shared_ptr<RateLimiter> send_limit;
+    std::shared_ptr<RateLimiter> receive_limit;
+    // run by the event loop, which pauses the transfer while a limit is in
+    // debt instead of blocking in the callbacks. `paused` is the CURLPAUSE_* mask
+    bool on_loop = false;
+    int paused = CURLPAUSE_CONT;
+    // the event loop does not start the transfer before then
+    std::chrono::steady_clock::time_point start_at;
+
+    HttpTransfer() = default;
+    HttpTransfer(const HttpTransfer&) = delete;
+    HttpTransfer& operator=(const HttpTransfer&) = delete;
+};
+
+// Single-threaded event loop that drives all the asynchronous transfers of a
+// client through one curl_multi handle
+//
+// The thread is only started on the first submitted transfer. Transfers over
+// the connection limits are queued by libcurl until a connection frees up
+class HttpEventLoop {
+public:
+    HttpEventLoop(const HttpClientOptions& options);
+    // Pending transfers are completed with an error
+    ~HttpEventLoop();
+
+    HttpEventLoop(const HttpEventLoop&) = delete;
+    HttpEventLoop& operator=(const HttpEventLoop&) = delete;
+
+    void submit(std::unique_ptr<HttpTransfer> transfer);
+    // Have the loop drop the transfers whose `cancelled` flag is set
+    void sweep();
+
+private:
+    CURLM* multi_handle = nullptr;
+    size_t max_free_handles_;
+    std::thread thread_;
+
+    // guards `submitted_`, `stopping_` and the thread startup
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<HttpTransfer>> submitted_;
+    bool stopping_ = false;
+    bool sweep_ = false;
+
+    // only touched from the event loop thread
+    std::unordered_map<CURL*, std::unique_ptr<HttpTransfer>> running_;
+    // submitted transfers whose `start_at` is still ahead, by `start_at`
+    std::multimap<std::chrono::steady_clock::time_point, std::unique_ptr<HttpTransfer>> delayed_;
+    std::vector<CURL*> free_handles_;
+
+    void run();
+    void start(std::unique_ptr<HttpTransfer> transfer);
+    void finish(CURL* handle, CURLcode code);
+    void drop_cancelled();
+    // reset the handle for the next transfer, or clean it up
+    void recycle(CURL* handle, const HttpTransfer& transfer);
+    // (un)pause the transfers as their bandwidth limits go in and out of
+    // debt, returns how long until the next one is due to resume
+    std::chrono::milliseconds throttle();
+    // start the delayed transfers that are due, returns how long until the
+    // next one is
+    std::chrono::milliseconds start_due();
+};
+
+// HttpClient should only focus on handling the cURL handles
 // and making the request (HttpRequest) and returning HttpResponse
+//
+// It is safe to execute requests from multiple threads on the same client,
+// each request checks out its own handle from the pool
 class HttpClient {
     // `execute()` is invoked from the request only
     friend class HttpRequest;
     friend class HttpBodyRequest;
+    friend class HttpEventLoop;
 
 public:
-    HttpClient() {
-        curl_handle = curl_easy_init();
-        if (!curl_handle)
-            throw std::runtime_error("Failed to initialize cURL");
-        headers_["User-Agent"] = "s3cpp/0.0.0 github.com/ggcr/s3cpp";
-    }
+    HttpClient()
+        : HttpClient(std::unordered_map<std::string, std::string> {}, HttpClientOptions {}) { }
+    HttpClient(const HttpClientOptions& options)
+        : HttpClient(std::unordered_map<std::string, std::string> {}, options) { }
     HttpClient(std::unordered_map<std::string, std::string> headers)
-        : headers_(std::move(headers)) {
-        curl_handle = curl_easy_init();
-        if (!curl_handle)
-            throw std::runtime_error("Failed to initialize cURL");
-        headers_["User-Agent"] = "s3cpp/0.0.0 github.com/ggcr/s3cpp";
-    }
-    ~HttpClient() {
-        if (curl_handle)
-            curl_easy_cleanup(curl_handle);
-    };
+        : HttpClient(std::move(headers), HttpClientOptions {}) { }
+    HttpClient(std::unordered_map<std::string, std::string> headers, const HttpClientOptions& options)
+        : pool_(std::make_unique<HttpHandlePool>(options))
+        , loop_(std::make_unique<HttpEventLoop>(options)) {
+        for (const auto& [name, value] : headers)
+            headers_.set(name, value);
+        headers_.set("User-Agent", "s3cpp/0.0.0 github.com/ggcr/s3cpp");
+        build_client_header_list();
+    }
+
+    // The event loop goes first, transfers still in flight point into
+    // `header_list_` and hold the bandwidth limiters
+    ~HttpClient() { loop_.reset(); }
 
     HttpClient(const HttpClient&) = delete;
     HttpClient& operator=(const HttpClient&) = delete;
 
-    // When transfering ownership we must invalidate the source cURL handle
-    HttpClient(HttpClient&& other)
-        : curl_handle(other.curl_handle) {
-        other.curl_handle = nullptr;
-    }
+    // When transfering ownership the source client is left without a pool
+    HttpClient(HttpClient&& other) = default;
     HttpClient& operator=(HttpClient&& other) {
         if (this != &other) {
-            // cleanup current handle
-            if (curl_handle)
-                curl_easy_cleanup(curl_handle);
-            curl_handle = std::move(other.curl_handle);
-            other.curl_handle = nullptr;
+            // stop our event loop before tearing down the pool
+            loop_ = std::move(other.loop_);
+            pool_ = std::move(other.pool_);
+            headers_ = std::move(other.headers_);
+            header_list_ = std::move(other.header_list_);
+            upload_limit_ = std::move(other.upload_limit_);
+            download_limit_ = std::move(other.download_limit_);
         }
         return *this;
     }
@@ -223,15 +694,43 @@ public:
         return HttpBodyRequest { *this, URL, HttpMethod::Delete };
     };
 
+    // Cap the bytes a second of all the request bodies and of all the response
+    // bodies, null for no limit. Synchronous transfers wait in the cURL
+    // callbacks, the event loop pauses its transfers. Set it before issuing
+    // requests, a limiter can be shared by several clients
+    void set_rate_limits(std::shared_ptr<RateLimiter> upload, std::shared_ptr<RateLimiter> download) {
+        upload_limit_ = std::move(upload);
+        download_limit_ = std::move(download);
+    }
+
+    const HttpHandlePool& pool() const {
+        if (!pool_)
+            throw std::runtime_error("cURL handle pool is invalid");
+        return *pool_;
+    }
+
 private:
-    CURL* curl_handle = nullptr;
+    std::unique_ptr<HttpHandlePool> pool_;
+    std::unique_ptr<HttpEventLoop> loop_;
     // response body
     static size_t write_callback(char* ptr, size_t size, size_t nmemb,
         void* userdata);
     // response headers
     static size_t header_callback(char* buffer, size_t size, size_t nitems,
         void* userdata);
-    std::unordered_map<std::string, std::string> headers_;
+    // streamed request body
+    static size_t read_callback(char* buffer, size_t size, size_t nitems,
+        void* userdata);
+    static int seek_callback(void* userdata, curl_off_t offset, int origin);
+
+    struct HeaderListDeleter {
+        void operator()(curl_slist* list) const { curl_slist_free_all(list); }
+    };
+    HttpHeaders headers_;
+    // `headers_` as a cURL list, built once as they never change
+    std::unique_ptr<curl_slist, HeaderListDeleter> header_list_;
+    std::shared_ptr<RateLimiter> upload_limit_;
+    std::shared_ptr<RateLimiter> download_limit_;
 
     // main logic to perform the request
     // this is invoked by HttpRequest
@@ -239,10 +738,23 @@ private:
     HttpResponse execute_head(HttpRequest& request);
     HttpResponse execute_post(HttpBodyRequest& request);
     HttpResponse execute_delete(HttpBodyRequest& request);
+    // hand the request over to the event loop
+    void execute_async(HttpRequest& request, HttpCallback callback);
+    void execute_async(HttpBodyRequest& request, HttpCallback callback);
+    // race the request against a duplicate, see `HttpHedging`
+    HttpResponse execute_hedged(HttpRequest& request, HttpHedging& hedging);
 
-    const std::unordered_map<std::string, std::string>& getHeaders() const {
-        return headers_;
-    }
+    // check out a handle for the host of the given URL
+    HttpHandlePool::Lease acquire(const std::string& URL);
+    // blocking transfer on a pooled handle
+    HttpResponse perform(HttpTransfer& transfer);
+    // set every option the transfer needs on a clean handle
+    static void prepare(CURL* handle, HttpTransfer& transfer);
+    template <typename T>
+    std::unique_ptr<HttpTransfer> make_transfer(const HttpRequestBase<T>& request, bool own_body) const;
+    void build_client_header_list();
+    // chain the request headers in front of the client ones, into `transfer`
+    void build_header_list(HttpTransfer& transfer, const HttpHeaders& request_headers, bool own_headers) const;
 };
 
 #endif
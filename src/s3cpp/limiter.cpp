@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cmath>
+#include <s3cpp/limiter.h>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Weights of a new sample in the moving averages of the latency, the recent
+// one follows the last ten responses or so, the baseline the last hundred
+constexpr double RecentWeight = 0.1;
+constexpr double BaselineWeight = 0.01;
+// Responses seen before rising latency is acted upon
+constexpr size_t LatencyWarmup = 20;
+// Jitter below this is not a rise, whatever the ratio
+constexpr double MinLatencyRise = 0.001;
+
+} // namespace
+
+void ConcurrencyPermit::release(ConcurrencySignal signal) {
+    if (limiter_)
+        std::exchange(limiter_, nullptr)->release(window_, signal, std::chrono::steady_clock::now() - start_);
+}
+
+ConcurrencyLimiter::ConcurrencyLimiter(const ConcurrencyOptions& options)
+    : options_(options) {
+    options_.MinLimit = std::max<size_t>(options_.MinLimit, 1);
+    options_.MaxLimit = std::max(options_.MaxLimit, options_.MinLimit);
+    limit_ = static_cast<double>(std::clamp(options_.InitialLimit, options_.MinLimit, options_.MaxLimit));
+}
+
+ConcurrencyPermit ConcurrencyLimiter::acquire() {
+    std::unique_lock lock(mutex_);
+    available_.wait(lock, [this] { return in_flight_ < static_cast<size_t>(limit_); });
+    in_flight_++;
+    return ConcurrencyPermit(this, window_);
+}
+
+void ConcurrencyLimiter::release(uint64_t window, ConcurrencySignal signal, std::chrono::steady_clock::duration latency) {
+    std::unique_lock lock(mutex_);
+    const size_t before = static_cast<size_t>(limit_);
+    // Whether the window was full when this request went out
+    const bool saturated = in_flight_ >= before;
+    in_flight_--;
+
+    if (signal == ConcurrencySignal::Congested) {
+        throttled_++;
+        if (window == window_)
+            decrease();
+    } else if (signal == ConcurrencySignal::Healthy) {
+        const double seconds = std::chrono::duration<double>(latency).count();
+        if (samples_++ == 0) {
+            recent_latency_ = seconds;
+            baseline_latency_ = seconds;
+        } else {
+            recent_latency_ += RecentWeight * (seconds - recent_latency_);
+            baseline_latency_ += BaselineWeight * (seconds - baseline_latency_);
+        }
+
+        const bool rising = recent_latency_ > options_.LatencyTolerance * baseline_latency_ && recent_latency_ - baseline_latency_ > MinLatencyRise;
+        if (samples_ > LatencyWarmup && rising) {
+            if (window == window_) {
+                decrease();
+                // Starts over, the next decrease takes a new run of slow responses
+                recent_latency_ = baseline_latency_;
+            }
+        } else if (saturated) {
+            limit_ = std::min(limit_ + 1 / limit_, static_cast<double>(options_.MaxLimit));
+        }
+    }
+
+    const bool grew = static_cast<size_t>(limit_) > before;
+    lock.unlock();
+    if (grew)
+        available_.notify_all();
+    else
+        available_.notify_one();
+}
+
+void ConcurrencyLimiter::decrease() {
+    limit_ = std::max(std::floor(limit_ * options_.Backoff), static_cast<double>(options_.MinLimit));
+    window_++;
+    decreases_++;
+}
+
+size_t ConcurrencyLimiter::limit() const {
+    std::lock_guard lock(mutex_);
+    return static_cast<size_t>(limit_);
+}
+
+size_t ConcurrencyLimiter::inFlight() const {
+    std::lock_guard lock(mutex_);
+    return in_flight_;
+}
+
+uint64_t ConcurrencyLimiter::throttled() const {
+    std::lock_guard lock(mutex_);
+    return throttled_;
+}
+
+uint64_t ConcurrencyLimiter::decreases() const {
+    std::lock_guard lock(mutex_);
+    return decreases_;
+}
+
+std::string AdaptiveConcurrency::partition(std::string_view bucket, std::string_view key) const {
+    std::string partition(bucket);
+    size_t end = 0;
+    for (size_t depth = 0; depth < options_.PrefixDepth; depth++) {
+        const size_t slash = key.find('/', end);
+        if (slash == std::string_view::npos)
+            break;
+        end = slash + 1;
+    }
+    if (end > 0) {
+        partition += '/';
+        partition += key.substr(0, end);
+    }
+    return partition;
+}
+
+std::shared_ptr<ConcurrencyLimiter> AdaptiveConcurrency::limiter(const std::string& partition) {
+    std::lock_guard lock(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    auto [it, created] = limiters_.try_emplace(partition);
+    if (created)
+        it->second.limiter = std::make_shared<ConcurrencyLimiter>(options_);
+    it->second.used = now;
+    // held from here on, the sweep leaves it alone
+    std::shared_ptr<ConcurrencyLimiter> limiter = it->second.limiter;
+    if (created && now - swept_ >= options_.IdleTimeout)
+        evictIdle(now);
+    return limiter;
+}
+
+void AdaptiveConcurrency::evictIdle(std::chrono::steady_clock::time_point now) {
+    swept_ = now;
+    // Nobody else holds an idle limiter, so none of its permits is out either
+    std::erase_if(limiters_, [&](const auto& entry) {
+        const Partition& partition = entry.second;
+        return now - partition.used >= options_.IdleTimeout && partition.limiter.use_count() == 1 && partition.limiter->inFlight() == 0;
+    });
+}
+
+std::vector<ConcurrencyLimit> AdaptiveConcurrency::limits() const {
+    std::lock_guard lock(mutex_);
+    std::vector<ConcurrencyLimit> limits;
+    limits.reserve(limiters_.size());
+    for (const auto& [partition, entry] : limiters_) {
+        const auto& limiter = entry.limiter;
+        limits.push_back(ConcurrencyLimit {
+            .Partition = partition,
+            .Limit = limiter->limit(),
+            .InFlight = limiter->inFlight(),
+            .Throttled = limiter->throttled(),
+            .Decreases = limiter->decreases(),
+        });
+    }
+    std::ranges::sort(limits, {}, &ConcurrencyLimit::Partition);
+    return limits;
+}
+
+RateLimiter::RateLimiter(double rate, double burst)
+    : rate_(rate)
+    , burst_(burst > 0 ? burst : rate)
+    , tokens_(burst_)
+    , updated_(std::chrono::steady_clock::now()) {
+    if (!(rate > 0))
+        throw std::invalid_argument("RateLimiter rate must be positive");
+}
+
+void RateLimiter::acquire(size_t tokens) {
+    const std::chrono::nanoseconds wait = reserve(tokens);
+    if (wait > std::chrono::nanoseconds::zero())
+        std::this_thread::sleep_for(wait);
+}
+
+std::chrono::nanoseconds RateLimiter::reserve(size_t tokens) {
+    std::lock_guard lock(mutex_);
+    refill();
+    // What is owed before this caller, it does not wait for its own share
+    const double debt = std::max(-tokens_, 0.0);
+    tokens_ -= static_cast<double>(tokens);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(debt / rate_));
+}
+
+std::chrono::nanoseconds RateLimiter::waitTime() const {
+    std::lock_guard lock(mutex_);
+    refill();
+    const double debt = std::max(-tokens_, 0.0);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(debt / rate_));
+}
+
+void RateLimiter::refill() const {
+    const auto now = std::chrono::steady_clock::now();
+    tokens_ = std::min(burst_, tokens_ + std::chrono::duration<double>(now - updated_).count() * rate_);
+    updated_ = now;
+}
@@ -0,0 +1,208 @@
+#ifndef S3CPP_LIMITER
+#define S3CPP_LIMITER
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// How S3Client adapts the number of requests in flight, see
+// `S3Client::SetAdaptiveConcurrency()`
+struct ConcurrencyOptions {
+    // In-flight requests allowed per partition, the limit starts at
+    // `InitialLimit` and stays within [`MinLimit`, `MaxLimit`]
+    size_t InitialLimit = 8;
+    size_t MinLimit = 1;
+    size_t MaxLimit = 256;
+    // Multiplicative decrease, the limit is multiplied by this on SlowDown,
+    // 503, timeouts or rising latency
+    double Backoff = 0.7;
+    // Latency is rising once the recent average goes over this many times the
+    // long-term one
+    double LatencyTolerance = 2.0;
+    // Requests are partitioned by bucket and the first `PrefixDepth`
+    // "/"-separated segments of the key, S3 scales request rates by prefix
+    size_t PrefixDepth = 1;
+    // Partitions without requests for this long are forgotten, their limit
+    // starts over from `InitialLimit`. Keeps hashed or random prefixes from
+    // piling up
+    std::chrono::seconds IdleTimeout = std::chrono::seconds(60);
+};
+
+// The state of a partition, see `S3Client::ConcurrencyLimits()`
+struct ConcurrencyLimit {
+    // "bucket" or "bucket/prefix/"
+    std::string Partition;
+    size_t Limit = 0;
+    size_t InFlight = 0;
+    // Throttled (or timed out) responses, and how many times the limit went down
+    uint64_t Throttled = 0;
+    uint64_t Decreases = 0;
+};
+
+// What the response of a request says about the load of S3
+enum class ConcurrencySignal {
+    // Nothing, i.e. a 404 or a failed connection
+    None,
+    // Success, the latency tells whether there is room for more
+    Healthy,
+    // SlowDown, 503 or a timeout
+    Congested,
+};
+
+class ConcurrencyLimiter;
+
+// A slot of a ConcurrencyLimiter, given back on release() or destruction
+class ConcurrencyPermit {
+public:
+    ConcurrencyPermit(ConcurrencyPermit&& other) noexcept
+        : limiter_(std::exchange(other.limiter_, nullptr))
+        , window_(other.window_)
+        , start_(other.start_) { }
+    ConcurrencyPermit& operator=(ConcurrencyPermit&&) = delete;
+    ~ConcurrencyPermit() { release(ConcurrencySignal::None); }
+
+    // The latency is measured from the moment the slot was granted
+    void release(ConcurrencySignal signal);
+
+private:
+    friend class ConcurrencyLimiter;
+    ConcurrencyPermit(ConcurrencyLimiter* limiter, uint64_t window)
+        : limiter_(limiter)
+        , window_(window)
+        , start_(std::chrono::steady_clock::now()) { }
+
+    ConcurrencyLimiter* limiter_;
+    uint64_t window_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// AIMD limit on the requests in flight, as TCP does for its window
+//
+// Healthy responses raise the limit by one per limit's worth of them, about
+// one per round trip at full use. Congestion multiplies it by `Backoff`, at
+// most once per window: responses to requests sent before the last decrease
+// do not count, so a burst of 503s cuts the limit once rather than down to
+// the minimum. The limit only grows while it is actually used. Safe to use
+// from any thread
+class ConcurrencyLimiter {
+public:
+    explicit ConcurrencyLimiter(const ConcurrencyOptions& options = {});
+
+    // Waits until fewer requests than the limit are in flight
+    ConcurrencyPermit acquire();
+
+    size_t limit() const;
+    size_t inFlight() const;
+    uint64_t throttled() const;
+    uint64_t decreases() const;
+
+private:
+    friend class ConcurrencyPermit;
+
+    ConcurrencyOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    double limit_;
+    size_t in_flight_ = 0;
+    // Bumped on every decrease
+    uint64_t window_ = 0;
+    // Moving averages of the latency, in seconds, a recent and a long-term one
+    double recent_latency_ = 0;
+    double baseline_latency_ = 0;
+    size_t samples_ = 0;
+    uint64_t throttled_ = 0;
+    uint64_t decreases_ = 0;
+
+    void release(uint64_t window, ConcurrencySignal signal, std::chrono::steady_clock::duration latency);
+    // With `mutex_` held
+    void decrease();
+};
+
+// One ConcurrencyLimiter per partition of the requests, created on first use
+// and dropped once idle for `IdleTimeout`
+class AdaptiveConcurrency {
+public:
+    explicit AdaptiveConcurrency(const ConcurrencyOptions& options)
+        : options_(options) { }
+
+    // The partition of a request to `bucket`, `key` being the object key or
+    // empty for bucket requests
+    std::string partition(std::string_view bucket, std::string_view key) const;
+    // Keep the limiter for as long as requests go through it, it is not
+    // dropped while held
+    std::shared_ptr<ConcurrencyLimiter> limiter(const std::string& partition);
+    std::vector<ConcurrencyLimit> limits() const;
+
+private:
+    struct Partition {
+        std::shared_ptr<ConcurrencyLimiter> limiter;
+        std::chrono::steady_clock::time_point used;
+    };
+
+    ConcurrencyOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Partition> limiters_;
+    // Idle partitions are looked for at most once per `IdleTimeout`
+    std::chrono::steady_clock::time_point swept_ = std::chrono::steady_clock::now();
+
+    // With `mutex_` held
+    void evictIdle(std::chrono::steady_clock::time_point now);
+};
+
+// Token bucket: `rate` tokens a second, up to `burst` of them saved up while
+// idle (a second's worth by default)
+//
+// Callers take what they need even when the bucket cannot cover it, the
+// bucket goes into debt and the next callers wait until it is paid back. A
+// request never waits for tokens it does not need yet, and the rate holds
+// on average whatever the sizes taken. Safe to use from any thread, one
+// limiter can be shared by several clients
+class RateLimiter {
+public:
+    explicit RateLimiter(double rate, double burst = 0);
+
+    // Takes `tokens`, waiting as long as the bucket was in debt
+    void acquire(size_t tokens = 1);
+    // Takes `tokens` without waiting, returns how long the caller should wait
+    std::chrono::nanoseconds reserve(size_t tokens);
+    // How long until the bucket is out of debt, zero if it is not
+    std::chrono::nanoseconds waitTime() const;
+    double rate() const { return rate_; }
+
+private:
+    const double rate_;
+    const double burst_;
+    mutable std::mutex mutex_;
+    // Negative while in debt
+    mutable double tokens_;
+    mutable std::chrono::steady_clock::time_point updated_;
+
+    // With `mutex_` held
+    void refill() const;
+};
+
+// Client-side rate limits of an S3Client, see `S3Client::SetRateLimits()`.
+// Traffic without a limiter is not limited
+struct RateLimits {
+    // Requests a second, by class of operation. Get: GetObject, HeadObject and
+    // HeadBucket. Put: uploads, copies, bucket creation and the multipart
+    // calls. List: ListObjects and ListBuckets. Delete: DeleteObject(s),
+    // DeleteBucket and AbortMultipartUpload
+    std::shared_ptr<RateLimiter> Get;
+    std::shared_ptr<RateLimiter> Put;
+    std::shared_ptr<RateLimiter> List;
+    std::shared_ptr<RateLimiter> Delete;
+    // Bytes a second of the request bodies and of the response bodies
+    std::shared_ptr<RateLimiter> Upload;
+    std::shared_ptr<RateLimiter> Download;
+};
+
+#endif
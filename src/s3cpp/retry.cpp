@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <random>
+#include <s3cpp/retry.h>
+
+RetryCause retryCause(CURLcode code, bool idempotent) {
+    switch (code) {
+    // Nothing was sent, safe whatever the request
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+        return RetryCause::Transport;
+    case CURLE_OPERATION_TIMEDOUT:
+        return idempotent ? RetryCause::Timeout : RetryCause::None;
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return idempotent ? RetryCause::Transport : RetryCause::None;
+    default:
+        return RetryCause::None;
+    }
+}
+
+RetryCause retryCause(int status, std::string_view errorCode, bool idempotent) {
+    if (status == 429 || errorCode == "SlowDown" || errorCode == "Throttling" || errorCode == "ThrottlingException"
+        || errorCode == "RequestLimitExceeded" || errorCode == "TooManyRequestsException")
+        return RetryCause::Throttling;
+    if (!idempotent)
+        return RetryCause::None;
+    if (errorCode == "RequestTimeout")
+        return RetryCause::Timeout;
+    if (status == 500 || status == 502 || status == 503 || status == 504)
+        return RetryCause::ServerError;
+    return RetryCause::None;
+}
+
+bool RetryBudget::acquire(size_t cost) {
+    size_t tokens = tokens_.load(std::memory_order_relaxed);
+    do {
+        if (tokens < cost)
+            return false;
+    } while (!tokens_.compare_exchange_weak(tokens, tokens - cost, std::memory_order_relaxed));
+    return true;
+}
+
+void RetryBudget::release(size_t tokens) {
+    size_t current = tokens_.load(std::memory_order_relaxed);
+    while (current < capacity_ && !tokens_.compare_exchange_weak(current, std::min(capacity_, current + tokens), std::memory_order_relaxed)) {
+    }
+}
+
+std::chrono::milliseconds RetryBackoff::next() {
+    thread_local std::minstd_rand random { std::random_device {}() };
+    const auto upper = std::min(max_, std::max(base_, previous_ * 3));
+    std::uniform_int_distribution<std::chrono::milliseconds::rep> delay(std::min(base_, upper).count(), upper.count());
+    previous_ = std::chrono::milliseconds(delay(random));
+    return previous_;
+}
@@ -0,0 +1,91 @@
+#ifndef S3CPP_RETRY
+#define S3CPP_RETRY
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <curl/curl.h>
+#include <string_view>
+
+// How S3Client retries failed requests, see `S3Client::SetRetryOptions()`
+struct RetryOptions {
+    // Attempts per request, the first one included. 1 turns retries off
+    int MaxAttempts = 3;
+    // Delays are drawn with decorrelated jitter: at random between `BaseDelay`
+    // and three times the previous delay, never over `MaxDelay`
+    std::chrono::milliseconds BaseDelay = std::chrono::milliseconds(50);
+    std::chrono::milliseconds MaxDelay = std::chrono::seconds(20);
+    // Tokens of the retry budget shared by all the requests of a client (see
+    // `RetryBudget`). Every retry takes `RetryCost` of them, `TimeoutCost`
+    // after a timeout
+    size_t RetryBudget = 500;
+    size_t RetryCost = 5;
+    size_t TimeoutCost = 10;
+};
+
+// Why a failed attempt is worth another one
+enum class RetryCause {
+    // Not retryable
+    None,
+    // The connection failed or broke
+    Transport,
+    // No response within the timeout of the request
+    Timeout,
+    // 500 and friends
+    ServerError,
+    // 503 SlowDown, 429 and the other "too many requests" answers
+    Throttling,
+};
+
+// Transport errors are only retried for idempotent requests, unless the
+// request never reached the server
+RetryCause retryCause(CURLcode code, bool idempotent);
+// Error responses, `errorCode` being the <Code> of the body if any. Only
+// throttling answers, which S3 sends before doing anything, are retried for
+// non idempotent requests
+RetryCause retryCause(int status, std::string_view errorCode, bool idempotent);
+
+// Token bucket capping the retries of a whole client
+//
+// Retries take tokens and requests that succeed at the first attempt put one
+// back. While S3 is healthy the bucket stays full, once most requests fail it
+// runs dry and failures are handed back as they are. A brownout of the
+// endpoint does not turn into a retry storm. Safe to use from any thread
+class RetryBudget {
+public:
+    explicit RetryBudget(size_t capacity)
+        : capacity_(capacity)
+        , tokens_(capacity) { }
+
+    // Takes `cost` tokens, false (and nothing taken) when there are not enough
+    bool acquire(size_t cost);
+    // Puts `tokens` back, up to the capacity
+    void release(size_t tokens);
+    size_t available() const { return tokens_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    std::atomic<size_t> tokens_;
+};
+
+// Delays between the attempts of one request, "decorrelated jitter": each one
+// is drawn at random between the base and three times the previous one.
+// Concurrent clients do not retry in lockstep, and delays still grow about
+// exponentially
+class RetryBackoff {
+public:
+    RetryBackoff(std::chrono::milliseconds base, std::chrono::milliseconds max)
+        : base_(base)
+        , max_(max)
+        , previous_(base) { }
+
+    std::chrono::milliseconds next();
+
+private:
+    std::chrono::milliseconds base_;
+    std::chrono::milliseconds max_;
+    std::chrono::milliseconds previous_;
+};
+
+#endif
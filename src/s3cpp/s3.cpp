@@ -1,9 +1,566 @@
 #include "s3cpp/httpclient.h"
 #include <expected>
+#include <cerrno>
+#include <cstring>
+#include <exception>
 #include <print>
+#include <type_traits>
+#include <unordered_map>
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <s3cpp/checksum.h>
 #include <s3cpp/s3.h>
 
+namespace {
+
+// Object key as it goes in a URL path, URL-encoded except for the separators
+std::string uriEncodePath(const std::string& key) {
+    std::string encoded;
+    encoded.reserve(key.size());
+    for (unsigned char c : key) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
+            encoded += c;
+        } else {
+            encoded += std::format("%{:02X}", c);
+        }
+    }
+    return encoded;
+}
+
+// Presigned URLs are valid for a week at most
+std::optional<Error> checkPresignExpiry(std::chrono::seconds expires) {
+    if (expires < std::chrono::seconds(1) || expires > std::chrono::days(7))
+        return Error { .Code = "InvalidArgument", .Message = "Presigned URLs expire after 1 second to 7 days" };
+    return std::nullopt;
+}
+
+// Fills in the checksum `SDKChecksumAlgorithm` asks for, once the body is set.
+// In-memory bodies are checksummed here, streamed ones while they are sent
+std::optional<Error> addChecksum(HttpBodyRequest& req, const PutObjectInput& options) {
+    if (!options.SDKChecksumAlgorithm.has_value())
+        return std::nullopt;
+    const std::string& name = options.SDKChecksumAlgorithm.value();
+    // values the caller computed upfront are sent as they are
+    if ((name == "CRC32" && options.ChecksumCRC32.has_value()) || (name == "CRC32C" && options.ChecksumCRC32C.has_value())
+        || (name == "CRC64NVME" && options.ChecksumCRC64NVME.has_value()) || (name == "SHA1" && options.ChecksumSHA1.has_value())
+        || (name == "SHA256" && options.ChecksumSHA256.has_value()))
+        return std::nullopt;
+
+    std::optional<ChecksumAlgorithm> algorithm = checksumAlgorithmFromName(name);
+    if (!algorithm)
+        return Error { .Code = "InvalidArgument", .Message = std::format("{} checksums are not computed by the client, pass the value in the input", name) };
+
+    if (req.getBodySource()) {
+        req.header("x-amz-trailer", std::string(checksumHeader(*algorithm)));
+    } else {
+        Checksum checksum(*algorithm);
+        checksum.update(req.getBody());
+        req.header(std::string(checksumHeader(*algorithm)), checksum.base64());
+    }
+    return std::nullopt;
+}
+
+// The full object checksum sent along with a GetObject body, if it is one
+// computed here. Ranges are not covered by it, and the composite checksums of
+// multipart uploads ("<base64>-<parts>") are not over the body
+std::optional<ChecksumAlgorithm> verifiableChecksum(const HttpResponse& res) {
+    if (res.status() != 200)
+        return std::nullopt;
+    auto type = res.headers().find("x-amz-checksum-type");
+    if (type != res.headers().end() && type->second == "COMPOSITE")
+        return std::nullopt;
+    for (ChecksumAlgorithm algorithm : { ChecksumAlgorithm::CRC64NVME, ChecksumAlgorithm::CRC32C }) {
+        auto it = res.headers().find(checksumHeader(algorithm));
+        if (it != res.headers().end() && it->second.find('-') == std::string_view::npos)
+            return algorithm;
+    }
+    return std::nullopt;
+}
+
+std::optional<Error> checkChecksum(const HttpResponse& res, const Checksum& checksum) {
+    const std::string header(checksumHeader(checksum.algorithm()));
+    const std::string_view expected = res.headers().at(header);
+    const std::string computed = checksum.base64();
+    if (computed != expected)
+        return Error { .Code = "ChecksumMismatch", .Message = std::format("The body does not match its checksum, {} is {} but {} was computed", header, expected, computed) };
+    return std::nullopt;
+}
+
+// Text content for the XML request bodies
+std::string xmlEscape(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+        case '&':
+            escaped += "&amp;";
+            break;
+        case '<':
+            escaped += "&lt;";
+            break;
+        case '>':
+            escaped += "&gt;";
+            break;
+        case '"':
+            escaped += "&quot;";
+            break;
+        case '\'':
+            escaped += "&apos;";
+            break;
+        default:
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// base64(MD5(body)), as expected on the Content-MD5 header
+std::string contentMD5(const std::string& body) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLen = 0;
+    EVP_Digest(body.data(), body.size(), digest, &digestLen, EVP_md5(), nullptr);
+    unsigned char encoded[4 * ((EVP_MAX_MD_SIZE + 2) / 3) + 1];
+    int encodedLen = EVP_EncodeBlock(encoded, digest, digestLen);
+    return std::string(reinterpret_cast<const char*>(encoded), encodedLen);
+}
+
+// Field tables of the XML responses, the paths are the full dotted ones
+constexpr XMLFieldTable ErrorFields { std::array {
+    xmlField<&Error::Code>("Error.Code"),
+    xmlField<&Error::Message>("Error.Message"),
+    xmlField<&Error::Resource>("Error.Resource"),
+    xmlField<&Error::RequestId>("Error.RequestId"),
+} };
+
+constexpr XMLFieldTable ListObjectsFields { std::array {
+    xmlField<&ListObjectsResult::IsTruncated>("ListBucketResult.IsTruncated"),
+    xmlField<&ListObjectsResult::Marker>("ListBucketResult.Marker"),
+    xmlField<&ListObjectsResult::NextMarker>("ListBucketResult.NextMarker"),
+    xmlField<&ListObjectsResult::Name>("ListBucketResult.Name"),
+    xmlField<&ListObjectsResult::Prefix>("ListBucketResult.Prefix"),
+    xmlField<&ListObjectsResult::Delimiter>("ListBucketResult.Delimiter"),
+    xmlField<&ListObjectsResult::MaxKeys>("ListBucketResult.MaxKeys"),
+    xmlField<&ListObjectsResult::EncodingType>("ListBucketResult.EncodingType"),
+    xmlField<&ListObjectsResult::KeyCount>("ListBucketResult.KeyCount"),
+    xmlField<&ListObjectsResult::ContinuationToken>("ListBucketResult.ContinuationToken"),
+    xmlField<&ListObjectsResult::NextContinuationToken>("ListBucketResult.NextContinuationToken"),
+    xmlField<&ListObjectsResult::StartAfter>("ListBucketResult.StartAfter"),
+    xmlRecord<&ListObjectsResult::Contents>("ListBucketResult.Contents"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::ChecksumAlgorithm>("ListBucketResult.Contents.ChecksumAlgorithm"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::ChecksumType>("ListBucketResult.Contents.ChecksumType"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::ETag>("ListBucketResult.Contents.ETag"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::Key>("ListBucketResult.Contents.Key"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::LastModified>("ListBucketResult.Contents.LastModified"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::Owner, &Contents_::Owner_::DisplayName>("ListBucketResult.Contents.Owner.DisplayName"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::Owner, &Contents_::Owner_::ID>("ListBucketResult.Contents.Owner.ID"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::RestoreStatus, &Contents_::RestoreStatus_::IsRestoreInProgress>("ListBucketResult.Contents.RestoreStatus.IsRestoreInProgress"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::RestoreStatus, &Contents_::RestoreStatus_::RestoreExpiryDate>("ListBucketResult.Contents.RestoreStatus.RestoreExpiryDate"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::Size>("ListBucketResult.Contents.Size"),
+    xmlRecordField<&ListObjectsResult::Contents, &Contents_::StorageClass>("ListBucketResult.Contents.StorageClass"),
+    xmlRecord<&ListObjectsResult::CommonPrefixes>("ListBucketResult.CommonPrefixes"),
+    xmlRecordField<&ListObjectsResult::CommonPrefixes, &CommonPrefix::Prefix>("ListBucketResult.CommonPrefixes.Prefix"),
+} };
+
+constexpr XMLFieldTable ListBucketsFields { std::array {
+    xmlRecord<&ListAllMyBucketsResult::Buckets>("ListAllMyBucketsResult.Buckets.Bucket"),
+    xmlRecordField<&ListAllMyBucketsResult::Buckets, &Bucket::BucketARN>("ListAllMyBucketsResult.Buckets.Bucket.BucketArn"),
+    xmlRecordField<&ListAllMyBucketsResult::Buckets, &Bucket::BucketRegion>("ListAllMyBucketsResult.Buckets.Bucket.BucketRegion"),
+    xmlRecordField<&ListAllMyBucketsResult::Buckets, &Bucket::CreationDate>("ListAllMyBucketsResult.Buckets.Bucket.CreationDate"),
+    xmlRecordField<&ListAllMyBucketsResult::Buckets, &Bucket::Name>("ListAllMyBucketsResult.Buckets.Bucket.Name"),
+    xmlField<&ListAllMyBucketsResult::Owner, &ListAllMyBucketsResult::Owner_::DisplayName>("ListAllMyBucketsResult.Owner.DisplayName"),
+    xmlField<&ListAllMyBucketsResult::Owner, &ListAllMyBucketsResult::Owner_::ID>("ListAllMyBucketsResult.Owner.ID"),
+    xmlField<&ListAllMyBucketsResult::ContinuationToken>("ListAllMyBucketsResult.ContinuationToken"),
+    xmlField<&ListAllMyBucketsResult::Prefix>("ListAllMyBucketsResult.Prefix"),
+} };
+
+constexpr XMLFieldTable CreateMultipartUploadFields { std::array {
+    xmlField<&CreateMultipartUploadResult::Bucket>("InitiateMultipartUploadResult.Bucket"),
+    xmlField<&CreateMultipartUploadResult::Key>("InitiateMultipartUploadResult.Key"),
+    xmlField<&CreateMultipartUploadResult::UploadId>("InitiateMultipartUploadResult.UploadId"),
+} };
+
+constexpr XMLFieldTable CompleteMultipartUploadFields { std::array {
+    xmlField<&CompleteMultipartUploadResult::Location>("CompleteMultipartUploadResult.Location"),
+    xmlField<&CompleteMultipartUploadResult::Bucket>("CompleteMultipartUploadResult.Bucket"),
+    xmlField<&CompleteMultipartUploadResult::Key>("CompleteMultipartUploadResult.Key"),
+    xmlField<&CompleteMultipartUploadResult::ETag>("CompleteMultipartUploadResult.ETag"),
+    xmlField<&CompleteMultipartUploadResult::ChecksumCRC32>("CompleteMultipartUploadResult.ChecksumCRC32"),
+    xmlField<&CompleteMultipartUploadResult::ChecksumCRC32C>("CompleteMultipartUploadResult.ChecksumCRC32C"),
+    xmlField<&CompleteMultipartUploadResult::ChecksumSHA1>("CompleteMultipartUploadResult.ChecksumSHA1"),
+    xmlField<&CompleteMultipartUploadResult::ChecksumSHA256>("CompleteMultipartUploadResult.ChecksumSHA256"),
+    xmlField<&CompleteMultipartUploadResult::ChecksumType>("CompleteMultipartUploadResult.ChecksumType"),
+} };
+
+constexpr XMLFieldTable DeleteObjectsFields { std::array {
+    xmlRecord<&DeleteObjectsResult::Deleted>("DeleteResult.Deleted"),
+    xmlRecordField<&DeleteObjectsResult::Deleted, &DeletedObject::Key>("DeleteResult.Deleted.Key"),
+    xmlRecordField<&DeleteObjectsResult::Deleted, &DeletedObject::VersionId>("DeleteResult.Deleted.VersionId"),
+    xmlRecordField<&DeleteObjectsResult::Deleted, &DeletedObject::DeleteMarker>("DeleteResult.Deleted.DeleteMarker"),
+    xmlRecordField<&DeleteObjectsResult::Deleted, &DeletedObject::DeleteMarkerVersionId>("DeleteResult.Deleted.DeleteMarkerVersionId"),
+    xmlRecord<&DeleteObjectsResult::Errors>("DeleteResult.Error"),
+    xmlRecordField<&DeleteObjectsResult::Errors, &DeleteError::Key>("DeleteResult.Error.Key"),
+    xmlRecordField<&DeleteObjectsResult::Errors, &DeleteError::VersionId>("DeleteResult.Error.VersionId"),
+    xmlRecordField<&DeleteObjectsResult::Errors, &DeleteError::Code>("DeleteResult.Error.Code"),
+    xmlRecordField<&DeleteObjectsResult::Errors, &DeleteError::Message>("DeleteResult.Error.Message"),
+} };
+
+constexpr XMLFieldTable CopyObjectFields { std::array {
+    xmlField<&CopyObjectResult::ETag>("CopyObjectResult.ETag"),
+    xmlField<&CopyObjectResult::LastModified>("CopyObjectResult.LastModified"),
+    xmlField<&CopyObjectResult::ChecksumCRC32>("CopyObjectResult.ChecksumCRC32"),
+    xmlField<&CopyObjectResult::ChecksumCRC32C>("CopyObjectResult.ChecksumCRC32C"),
+    xmlField<&CopyObjectResult::ChecksumCRC64NVME>("CopyObjectResult.ChecksumCRC64NVME"),
+    xmlField<&CopyObjectResult::ChecksumSHA1>("CopyObjectResult.ChecksumSHA1"),
+    xmlField<&CopyObjectResult::ChecksumSHA256>("CopyObjectResult.ChecksumSHA256"),
+    xmlField<&CopyObjectResult::ChecksumType>("CopyObjectResult.ChecksumType"),
+} };
+
+constexpr XMLFieldTable UploadPartCopyFields { std::array {
+    xmlField<&UploadPartCopyResult::ETag>("CopyPartResult.ETag"),
+    xmlField<&UploadPartCopyResult::LastModified>("CopyPartResult.LastModified"),
+    xmlField<&UploadPartCopyResult::ChecksumCRC32>("CopyPartResult.ChecksumCRC32"),
+    xmlField<&UploadPartCopyResult::ChecksumCRC32C>("CopyPartResult.ChecksumCRC32C"),
+    xmlField<&UploadPartCopyResult::ChecksumSHA1>("CopyPartResult.ChecksumSHA1"),
+    xmlField<&UploadPartCopyResult::ChecksumSHA256>("CopyPartResult.ChecksumSHA256"),
+} };
+
+// Fills `Result` through its field table as the parser goes, or an `Error`
+// when the root element is <Error> (S3 may send one with a 200). Paths with
+// no field, i.e. ones S3 added after this was written, are skipped
+template <typename Result, size_t N>
+struct ResponseHandler {
+    const XMLFieldTable<Result, N>& fields;
+    XMLEventParser<ResponseHandler>* parser = nullptr;
+    Result result {};
+    std::optional<Error> error;
+
+    // The field of the innermost element, text only comes for leaves
+    const XMLField<Result>* field = nullptr;
+    const XMLField<Error>* errorField = nullptr;
+
+    void startElement(std::string_view) {
+        const std::string_view path = parser->path();
+        if (parser->depth() == 1 && path == "Error")
+            error.emplace();
+        if (error) {
+            errorField = ErrorFields.find(path);
+            return;
+        }
+        field = fields.find(path);
+        if (field && field->start)
+            field->start(result);
+    }
+
+    void text(std::string_view value) {
+        if (error) {
+            if (errorField && errorField->text)
+                errorField->text(*error, value);
+        } else if (field && field->text) {
+            field->text(result, value);
+        }
+    }
+
+    void endElement(std::string_view) { }
+
+    std::expected<Result, Error> take() {
+        if (error)
+            return std::unexpected<Error>(std::move(*error));
+        return std::move(result);
+    }
+};
+
+// A whole XML body into `Result`, with `result` as the starting point
+template <typename Result, size_t N>
+std::expected<Result, Error> parseXML(std::string_view body, const XMLFieldTable<Result, N>& fields, Result result = {}) {
+    ResponseHandler<Result, N> handler { fields };
+    handler.result = std::move(result);
+    XMLEventParser<ResponseHandler<Result, N>> parser(handler);
+    handler.parser = &parser;
+    parser.feed(body);
+    parser.finish();
+    return handler.take();
+}
+
+// ISO 8601 in UTC as S3 writes it, i.e. 2009-10-12T17:50:30.000Z
+std::chrono::sys_time<std::chrono::milliseconds> parseTimestamp(std::string_view value) {
+    auto number = [value](size_t offset, size_t length) {
+        int n = 0;
+        auto result = std::from_chars(value.data() + offset, value.data() + offset + length, n);
+        if (result.ec != std::errc {} || result.ptr != value.data() + offset + length)
+            throw std::runtime_error(std::format("Unable to parse timestamp from '{}'", value));
+        return n;
+    };
+    if (value.size() < 20 || value[4] != '-' || value[7] != '-' || value[10] != 'T' || value[13] != ':' || value[16] != ':' || value.back() != 'Z')
+        throw std::runtime_error(std::format("Unable to parse timestamp from '{}'", value));
+
+    const std::chrono::year_month_day date { std::chrono::year(number(0, 4)), std::chrono::month(number(5, 2)), std::chrono::day(number(8, 2)) };
+    if (!date.ok())
+        throw std::runtime_error(std::format("Unable to parse timestamp from '{}'", value));
+    std::chrono::milliseconds time = std::chrono::hours(number(11, 2)) + std::chrono::minutes(number(14, 2)) + std::chrono::seconds(number(17, 2));
+    // Fraction of a second, down to the millisecond
+    if (value[19] == '.') {
+        const size_t digits = value.size() - 21;
+        if (digits == 0)
+            throw std::runtime_error(std::format("Unable to parse timestamp from '{}'", value));
+        int fraction = number(20, std::min<size_t>(digits, 3));
+        for (size_t i = digits; i < 3; i++)
+            fraction *= 10;
+        time += std::chrono::milliseconds(fraction);
+    } else if (value.size() != 20) {
+        throw std::runtime_error(std::format("Unable to parse timestamp from '{}'", value));
+    }
+    return std::chrono::sys_days(date) + time;
+}
+
+// Gathers a CompactListObjectsResult. The attributes of an object are
+// collected in `pending` and looked up among the distinct ones of the page
+// once the next object starts, or the page ends
+struct CompactListBuilder {
+    CompactListObjectsResult result;
+    ObjectAttributes pending;
+
+    struct AttributesHash {
+        // The strings are interned, equal values have equal addresses
+        size_t operator()(const ObjectAttributes& attributes) const {
+            size_t h = attributes.IsRestoreInProgress;
+            for (std::string_view value : { attributes.StorageClass, attributes.OwnerID, attributes.OwnerDisplayName, attributes.ChecksumAlgorithm, attributes.ChecksumType, attributes.RestoreExpiryDate })
+                h = h * 31 + std::hash<const void*> {}(value.data());
+            return h;
+        }
+    };
+    std::unordered_map<ObjectAttributes, uint32_t, AttributesHash> indexes;
+
+    void startObject() {
+        if (result.AttributeIndexes.size() < result.Keys.size())
+            endObject();
+        result.Keys.emplace_back();
+        result.ETags.emplace_back();
+        result.Sizes.push_back(0);
+        result.LastModified.emplace_back();
+        pending = {};
+    }
+
+    void endObject() {
+        auto [it, inserted] = indexes.try_emplace(pending, static_cast<uint32_t>(result.Attributes.size()));
+        if (inserted)
+            result.Attributes.push_back(pending);
+        result.AttributeIndexes.push_back(it->second);
+    }
+
+    CompactListObjectsResult finish() && {
+        if (result.AttributeIndexes.size() < result.Keys.size())
+            endObject();
+        return std::move(result);
+    }
+};
+
+CompactListBuilder compactListBuilder(int maxKeys) {
+    CompactListBuilder builder;
+    builder.result.Keys.reserve(maxKeys);
+    builder.result.ETags.reserve(maxKeys);
+    builder.result.Sizes.reserve(maxKeys);
+    builder.result.LastModified.reserve(maxKeys);
+    builder.result.AttributeIndexes.reserve(maxKeys);
+    return builder;
+}
+
+// Page fields, copied into the arena or parsed
+template <auto Member>
+constexpr XMLField<CompactListBuilder> compactField(std::string_view path) {
+    return { path, [](CompactListBuilder& builder, std::string_view value) {
+                auto& target = builder.result.*Member;
+                if constexpr (std::is_same_v<std::remove_cvref_t<decltype(target)>, std::string_view>)
+                    target = builder.result.Arena.store(value);
+                else
+                    xmlAssign(target, value);
+            } };
+}
+
+// Strings of ObjectAttributes, interned
+template <auto Member>
+constexpr XMLField<CompactListBuilder> compactAttribute(std::string_view path) {
+    return { path, [](CompactListBuilder& builder, std::string_view value) { builder.pending.*Member = builder.result.Arena.intern(value); } };
+}
+
+constexpr XMLFieldTable CompactListObjectsFields { std::array {
+    compactField<&CompactListObjectsResult::IsTruncated>("ListBucketResult.IsTruncated"),
+    compactField<&CompactListObjectsResult::Marker>("ListBucketResult.Marker"),
+    compactField<&CompactListObjectsResult::NextMarker>("ListBucketResult.NextMarker"),
+    compactField<&CompactListObjectsResult::Name>("ListBucketResult.Name"),
+    compactField<&CompactListObjectsResult::Prefix>("ListBucketResult.Prefix"),
+    compactField<&CompactListObjectsResult::Delimiter>("ListBucketResult.Delimiter"),
+    compactField<&CompactListObjectsResult::MaxKeys>("ListBucketResult.MaxKeys"),
+    compactField<&CompactListObjectsResult::EncodingType>("ListBucketResult.EncodingType"),
+    compactField<&CompactListObjectsResult::KeyCount>("ListBucketResult.KeyCount"),
+    compactField<&CompactListObjectsResult::ContinuationToken>("ListBucketResult.ContinuationToken"),
+    compactField<&CompactListObjectsResult::NextContinuationToken>("ListBucketResult.NextContinuationToken"),
+    compactField<&CompactListObjectsResult::StartAfter>("ListBucketResult.StartAfter"),
+    XMLField<CompactListBuilder> { "ListBucketResult.Contents", nullptr, [](CompactListBuilder& builder) { builder.startObject(); } },
+    XMLField<CompactListBuilder> { "ListBucketResult.Contents.Key", [](CompactListBuilder& builder, std::string_view value) { builder.result.Keys.back() = builder.result.Arena.store(value); } },
+    XMLField<CompactListBuilder> { "ListBucketResult.Contents.ETag", [](CompactListBuilder& builder, std::string_view value) { builder.result.ETags.back() = builder.result.Arena.store(value); } },
+    XMLField<CompactListBuilder> { "ListBucketResult.Contents.Size", [](CompactListBuilder& builder, std::string_view value) { builder.result.Sizes.back() = XMLParser::parseNumber<int64_t>(value); } },
+    XMLField<CompactListBuilder> { "ListBucketResult.Contents.LastModified", [](CompactListBuilder& builder, std::string_view value) { builder.result.LastModified.back() = parseTimestamp(value); } },
+    compactAttribute<&ObjectAttributes::StorageClass>("ListBucketResult.Contents.StorageClass"),
+    compactAttribute<&ObjectAttributes::OwnerID>("ListBucketResult.Contents.Owner.ID"),
+    compactAttribute<&ObjectAttributes::OwnerDisplayName>("ListBucketResult.Contents.Owner.DisplayName"),
+    compactAttribute<&ObjectAttributes::ChecksumAlgorithm>("ListBucketResult.Contents.ChecksumAlgorithm"),
+    compactAttribute<&ObjectAttributes::ChecksumType>("ListBucketResult.Contents.ChecksumType"),
+    compactAttribute<&ObjectAttributes::RestoreExpiryDate>("ListBucketResult.Contents.RestoreStatus.RestoreExpiryDate"),
+    XMLField<CompactListBuilder> { "ListBucketResult.Contents.RestoreStatus.IsRestoreInProgress", [](CompactListBuilder& builder, std::string_view value) { builder.pending.IsRestoreInProgress = XMLParser::parseBool(value); } },
+    XMLField<CompactListBuilder> { "ListBucketResult.CommonPrefixes", nullptr, [](CompactListBuilder& builder) { builder.result.CommonPrefixes.emplace_back(); } },
+    XMLField<CompactListBuilder> { "ListBucketResult.CommonPrefixes.Prefix", [](CompactListBuilder& builder, std::string_view value) { builder.result.CommonPrefixes.back() = builder.result.Arena.store(value); } },
+} };
+
+} // namespace
+
+template <typename Result, size_t N>
+std::expected<Result, Error> S3Client::sendXML(HttpRequest& req, const XMLFieldTable<Result, N>& fields, Result result) {
+    ResponseHandler<Result, N> handler { fields };
+    handler.result = std::move(result);
+    XMLEventParser parser(handler);
+    handler.parser = &parser;
+
+    // Exceptions cannot go through cURL, they stop the transfer and are rethrown here
+    std::exception_ptr failure;
+    req.sink([&parser, &failure](std::string_view chunk) {
+        try {
+            parser.feed(chunk);
+            return true;
+        } catch (...) {
+            failure = std::current_exception();
+            return false;
+        }
+    });
+    HttpResponse res = send(req);
+
+    // Error bodies are not handed to the sink
+    if (!res.is_ok())
+        return std::unexpected<Error>(deserializeError(res.body()));
+    if (failure)
+        std::rethrow_exception(failure);
+    parser.finish();
+    return handler.take();
+}
+
 std::expected<ListObjectsResult, Error> S3Client::ListObjects(const std::string& bucket, const ListObjectsInput& options) {
+    // The page is parsed as it is received, instead of once it is all in
+    ListObjectsResult result {};
+    result.Contents.reserve(options.MaxKeys.value_or(1000));
+    HttpRequest req = buildListObjectsRequest(bucket, options);
+    return sendXML(req, ListObjectsFields, std::move(result));
+}
+
+std::expected<CompactListObjectsResult, Error> S3Client::ListObjectsCompact(const std::string& bucket, const ListObjectsInput& options) {
+    HttpRequest req = buildListObjectsRequest(bucket, options);
+    auto builder = sendXML(req, CompactListObjectsFields, compactListBuilder(options.MaxKeys.value_or(1000)));
+    if (!builder)
+        return std::unexpected<Error>(std::move(builder.error()));
+    return std::move(*builder).finish();
+}
+
+ListObjectsRange S3Client::ListAll(const std::string& bucket, const std::string& prefix, size_t prefetch) {
+    return ListObjectsRange(*this, bucket, prefix, prefetch);
+}
+
+PrefetchingListObjectsPaginator::PrefetchingListObjectsPaginator(S3Client& client, const std::string& bucket, const std::string& prefix, int maxKeys, size_t depth)
+    : client_(client)
+    , bucket_(bucket)
+    , prefix_(prefix)
+    , maxKeys_(maxKeys)
+    , depth_(std::max<size_t>(depth, 1)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+PrefetchingListObjectsPaginator::~PrefetchingListObjectsPaginator() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    space_.notify_all();
+    thread_.join();
+}
+
+bool PrefetchingListObjectsPaginator::HasMorePages() const {
+    std::lock_guard lock(mutex_);
+    return !pages_.empty() || failure_ || !done_;
+}
+
+std::expected<ListObjectsResult, Error> PrefetchingListObjectsPaginator::NextPage() {
+    std::unique_lock lock(mutex_);
+    ready_.wait(lock, [this] { return !pages_.empty() || done_; });
+    if (pages_.empty()) {
+        if (failure_)
+            std::rethrow_exception(std::exchange(failure_, nullptr));
+        return std::unexpected<Error>(Error { .Code = "NoMorePages", .Message = "The listing has no more pages" });
+    }
+    std::expected<ListObjectsResult, Error> page = std::move(pages_.front());
+    pages_.pop_front();
+    lock.unlock();
+    space_.notify_one();
+    return page;
+}
+
+void PrefetchingListObjectsPaginator::run() {
+    ListObjectsInput options;
+    if (!prefix_.empty())
+        options.Prefix = prefix_;
+    options.MaxKeys = maxKeys_;
+
+    for (;;) {
+        {
+            std::unique_lock lock(mutex_);
+            space_.wait(lock, [this] { return stop_ || pages_.size() < depth_; });
+            if (stop_)
+                return;
+        }
+
+        try {
+            std::expected<ListObjectsResult, Error> page = client_.ListObjects(bucket_, options);
+            const bool last = !page || !page->IsTruncated;
+            if (!last)
+                options.ContinuationToken = page->NextContinuationToken;
+            {
+                std::lock_guard lock(mutex_);
+                pages_.push_back(std::move(page));
+                done_ = last;
+            }
+            ready_.notify_one();
+            if (last)
+                return;
+        } catch (...) {
+            {
+                std::lock_guard lock(mutex_);
+                failure_ = std::current_exception();
+                done_ = true;
+            }
+            ready_.notify_one();
+            return;
+        }
+    }
+}
+
+void ListObjectsRange::advance() {
+    if (index_ < page_.Contents.size())
+        index_++;
+    while (index_ >= page_.Contents.size() && pages_->HasMorePages()) {
+        std::expected<ListObjectsResult, Error> page = pages_->NextPage();
+        if (!page)
+            throw std::runtime_error(std::format("Unable to list objects: {}: {}", page.error().Code, page.error().Message));
+        page_ = std::move(*page);
+        index_ = 0;
+    }
+}
+
+std::future<std::expected<ListObjectsResult, Error>> S3Client::ListObjectsAsync(const std::string& bucket, const ListObjectsInput& options) {
+    HttpRequest req = buildListObjectsRequest(bucket, options);
+    return sendAsync<ListObjectsResult>(req, [this, maxKeys = options.MaxKeys.value_or(1000)](const HttpResponse& res) {
+        return parseListObjectsResponse(res, maxKeys);
+    });
+}
+
+HttpRequest S3Client::buildListObjectsRequest(const std::string& bucket, const ListObjectsInput& options) {
     // Silent-ly accept maxKeys > 1000, even though we will return 1K at most
     // Pagination is opt-in as in the Go SDK, the user must be aware of this
 
@@ -35,15 +592,13 @@ std::expected<ListObjectsResult, Error> S3Client::ListObjects(const std::string&
     if (options.RequestPayer.has_value())
         req.header("x-amz-request-payer", options.RequestPayer.value());
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
-
-    const std::vector<XMLNode>& XMLBody = Parser.parse(res.body());
+    return req;
+}
 
-    if (res.is_ok()) {
-        return deserializeListObjectsResult(XMLBody, maxKeys);
-    }
-    return std::unexpected<Error>(deserializeError(XMLBody));
+std::expected<ListObjectsResult, Error> S3Client::parseListObjectsResponse(const HttpResponse& res, const int maxKeys) {
+    if (!res.is_ok())
+        return std::unexpected<Error>(deserializeError(res.body()));
+    return deserializeListObjectsResult(res.body(), maxKeys);
 }
 
 std::expected<ListAllMyBucketsResult, Error> S3Client::ListBuckets(const ListBucketsInput& options) {
@@ -72,191 +627,120 @@ std::expected<ListAllMyBucketsResult, Error> S3Client::ListBuckets(const ListBuc
 
     HttpRequest req = Client.get(url).header("Host", endpoint_);
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
-
-    const std::vector<XMLNode>& XMLBody = Parser.parse(res.body());
+    HttpResponse res = send(req);
 
     if (res.is_ok()) {
-        return deserializeListBucketsResult(XMLBody, options.MaxBuckets);
+        return deserializeListBucketsResult(res.body(), options.MaxBuckets);
     }
-    return std::unexpected<Error>(deserializeError(XMLBody));
+    return std::unexpected<Error>(deserializeError(res.body()));
 }
 
-std::expected<ListObjectsResult, Error> S3Client::deserializeListObjectsResult(const std::vector<XMLNode>& nodes, const int maxKeys) {
-    ListObjectsResult result;
+std::expected<ListObjectsResult, Error> S3Client::deserializeListObjectsResult(std::string_view body, const int maxKeys) {
+    ListObjectsResult result {};
     result.Contents.reserve(maxKeys);
-    result.CommonPrefixes.reserve(maxKeys);
-
-    result.Contents.push_back(Contents_ {});
-    result.CommonPrefixes.push_back(CommonPrefix {});
-
-    int contentsIdx = 0;
-    int commonPrefixesIdx = 0;
+    return parseXML(body, ListObjectsFields, std::move(result));
+}
 
-    // To keep track when we need to append an element
-    std::vector<std::string_view> seenContents;
-    std::vector<std::string_view> seenCommonPrefix;
+std::expected<CompactListObjectsResult, Error> S3Client::deserializeCompactListObjectsResult(std::string_view body, const int maxKeys) {
+    auto builder = parseXML(body, CompactListObjectsFields, compactListBuilder(maxKeys));
+    if (!builder)
+        return std::unexpected<Error>(std::move(builder.error()));
+    return std::move(*builder).finish();
+}
 
-    for (const auto& node : nodes) {
-        /* Sigh... no reflection */
+std::expected<ListAllMyBucketsResult, Error> S3Client::deserializeListBucketsResult(std::string_view body, std::optional<int> maxBuckets) {
+    ListAllMyBucketsResult result {};
+    if (maxBuckets.has_value())
+        result.Buckets.reserve(maxBuckets.value());
+    return parseXML(body, ListBucketsFields, std::move(result));
+}
 
-        // Check if we've seen this tag before in the current object
-        if (node.tag.contains("ListBucketResult.Contents")) {
-            if (std::find(seenContents.begin(), seenContents.end(), node.tag) != seenContents.end()) {
-                result.Contents.push_back(Contents_ {});
-                seenContents.clear();
-                contentsIdx++;
-            }
-        } else if (node.tag.contains("ListBucketResult.CommonPrefix")) {
-            if (std::find(seenCommonPrefix.begin(), seenCommonPrefix.end(), node.tag) != seenCommonPrefix.end()) {
-                result.CommonPrefixes.push_back(CommonPrefix {});
-                seenCommonPrefix.clear();
-                commonPrefixesIdx++;
-            }
-        }
+std::expected<std::string, Error> S3Client::GetObject(const std::string& bucket, const std::string& key, const GetObjectInput& options) {
+    HttpRequest req = buildGetObjectRequest(bucket, key, options).hedge(hedging_);
+    return parseGetObjectResponse(send(req));
+}
 
-        if (node.tag == "ListBucketResult.IsTruncated") {
-            result.IsTruncated = Parser.parseBool(std::move(node.value));
-        } else if (node.tag == "ListBucketResult.Marker") {
-            result.Marker = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.NextMarker") {
-            result.NextMarker = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Name") {
-            result.Name = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Prefix") {
-            result.Prefix = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Delimiter") {
-            result.Delimiter = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.MaxKeys") {
-            result.MaxKeys = Parser.parseNumber<int>(std::move(node.value));
-        } else if (node.tag == "ListBucketResult.EncodingType") {
-            result.EncodingType = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.KeyCount") {
-            result.KeyCount = Parser.parseNumber<int>(std::move(node.value));
-        } else if (node.tag == "ListBucketResult.ContinuationToken") {
-            result.ContinuationToken = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.NextContinuationToken") {
-            result.NextContinuationToken = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.StartAfter") {
-            result.StartAfter = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.ChecksumAlgorithm") {
-            result.Contents[contentsIdx].ChecksumAlgorithm = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.ChecksumType") {
-            result.Contents[contentsIdx].ChecksumType = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.ETag") {
-            result.Contents[contentsIdx].ETag = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.Key") {
-            result.Contents[contentsIdx].Key = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.LastModified") {
-            result.Contents[contentsIdx].LastModified = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.Owner.DisplayName") {
-            result.Contents[contentsIdx].Owner.DisplayName = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.Owner.ID") {
-            result.Contents[contentsIdx].Owner.ID = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.RestoreStatus.IsRestoreInProgress") {
-            result.Contents[contentsIdx].RestoreStatus.IsRestoreInProgress = Parser.parseBool(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.RestoreStatus.RestoreExpiryDate") {
-            result.Contents[contentsIdx].RestoreStatus.RestoreExpiryDate = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.Size") {
-            result.Contents[contentsIdx].Size = Parser.parseNumber<long>(node.value);
-        } else if (node.tag == "ListBucketResult.Contents.StorageClass") {
-            result.Contents[contentsIdx].StorageClass = std::move(node.value);
-        } else if (node.tag == "ListBucketResult.CommonPrefixes.Prefix") {
-            result.CommonPrefixes[commonPrefixesIdx].Prefix = std::move(node.value);
-        } else {
-            // Detect and parse error
-            // Note(cristian): This fallback should not be needed as we have
-            // the HTTP status codes for this, however, I like it
-            if (node.tag.substr(0, 6) == "Error.") {
-                return std::unexpected<Error>(deserializeError(nodes));
-            }
-            throw std::runtime_error(std::format("No case for ListBucketResult response found for: {}", node.tag));
-        }
+std::future<std::expected<std::string, Error>> S3Client::GetObjectAsync(const std::string& bucket, const std::string& key, const GetObjectInput& options) {
+    HttpRequest req = buildGetObjectRequest(bucket, key, options);
+    return sendAsync<std::string>(req, [this](const HttpResponse& res) {
+        return parseGetObjectResponse(res);
+    });
+}
 
-        // Add already seen fields
-        if (node.tag.contains("ListBucketResult.Contents")) {
-            seenContents.push_back(node.tag);
-        } else if (node.tag.contains("ListBucketResult.CommonPrefix")) {
-            seenCommonPrefix.push_back(node.tag);
+std::expected<GetObjectResult, Error> S3Client::GetObject(const std::string& bucket, const std::string& key, const HttpBodySink& sink, const GetObjectInput& options) {
+    bool sinkStopped = false;
+    // Which checksum comes back is only known once the headers arrive, so
+    // both are computed while the body streams through
+    std::vector<Checksum> checksums;
+    if (options.CheckSumMode == "ENABLED")
+        checksums = { Checksum(ChecksumAlgorithm::CRC32C), Checksum(ChecksumAlgorithm::CRC64NVME) };
+
+    HttpRequest req = buildGetObjectRequest(bucket, key, options).sink([&sink, &sinkStopped, &checksums](std::string_view chunk) {
+        for (Checksum& checksum : checksums)
+            checksum.update(chunk);
+        sinkStopped = !sink(chunk);
+        return !sinkStopped;
+    });
+    HttpResponse res = send(req);
+    auto result = parseGetObjectStreamResponse(res, sinkStopped);
+    if (result && !checksums.empty()) {
+        if (std::optional<ChecksumAlgorithm> algorithm = verifiableChecksum(res)) {
+            auto checksum = std::ranges::find(checksums, *algorithm, &Checksum::algorithm);
+            if (std::optional<Error> error = checkChecksum(res, *checksum))
+                return std::unexpected<Error>(*error);
         }
     }
-
-    // Remove the initial empty object if it was never populated
-    if (!result.Contents.empty() && result.Contents[0].Key.empty()) {
-        result.Contents.erase(result.Contents.begin());
-    }
-    if (!result.CommonPrefixes.empty() && result.CommonPrefixes[0].Prefix.empty()) {
-        result.CommonPrefixes.erase(result.CommonPrefixes.begin());
-    }
-
     return result;
 }
 
-std::expected<ListAllMyBucketsResult, Error> S3Client::deserializeListBucketsResult(const std::vector<XMLNode>& nodes, std::optional<int> maxBuckets) {
-    ListAllMyBucketsResult result;
-    if (maxBuckets.has_value())
-        result.Buckets.reserve(maxBuckets.value());
-    result.Buckets.push_back(Bucket {});
-
-    int bucketsIdx = 0;
-
-    // To keep track when we need to append an element
-    std::vector<std::string_view> seenBuckets;
-
-    for (const auto& node : nodes) {
-        /* Sigh... no reflection */
-
-        // Check if we've seen this tag before in the current object
-        if (node.tag.contains("ListAllMyBucketsResult.Buckets.")) {
-            if (std::find(seenBuckets.begin(), seenBuckets.end(), node.tag) != seenBuckets.end()) {
-                result.Buckets.push_back(Bucket {});
-                seenBuckets.clear();
-                bucketsIdx++;
-            }
-        }
+std::expected<GetObjectResult, Error> S3Client::GetObject(const std::string& bucket, const std::string& key, std::ostream& out, const GetObjectInput& options) {
+    return GetObject(bucket, key, [&out](std::string_view chunk) {
+        out.write(chunk.data(), chunk.size());
+        return out.good();
+    },
+        options);
+}
 
-        if (node.tag == "ListAllMyBucketsResult.Buckets.Bucket.BucketArn") {
-            result.Buckets[bucketsIdx].BucketARN = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.Buckets.Bucket.BucketRegion") {
-            result.Buckets[bucketsIdx].BucketRegion = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.Buckets.Bucket.CreationDate") {
-            result.Buckets[bucketsIdx].CreationDate = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.Buckets.Bucket.Name") {
-            result.Buckets[bucketsIdx].Name = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.Owner.DisplayName") {
-            result.Owner.DisplayName = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.Owner.ID") {
-            result.Owner.ID = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.ContinuationToken") {
-            result.ContinuationToken = std::move(node.value);
-        } else if (node.tag == "ListAllMyBucketsResult.Prefix") {
-            result.Prefix = std::move(node.value);
-        } else {
-            // Detect and parse error
-            // Note(cristian): This fallback should not be needed as we have
-            // the HTTP status codes for this, however, I like it
-            if (node.tag.substr(0, 6) == "Error.") {
-                return std::unexpected<Error>(deserializeError(nodes));
-            }
-            throw std::runtime_error(std::format("No case for ListAllMyBucketsResult response found for: {}", node.tag));
+std::expected<GetObjectResult, Error> S3Client::GetObject(const std::string& bucket, const std::string& key, int fd, const GetObjectInput& options) {
+    return GetObject(bucket, key, [fd](std::string_view chunk) {
+        // write(2) may take less than the whole chunk
+        while (!chunk.empty()) {
+            ssize_t written = ::write(fd, chunk.data(), chunk.size());
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            chunk.remove_prefix(written);
         }
+        return true;
+    },
+        options);
+}
 
-        // Add already seen fields
-        if (node.tag.contains("ListAllMyBucketsResult.Buckets")) {
-            seenBuckets.push_back(node.tag);
+std::expected<GetObjectResult, Error> S3Client::GetObjectInto(const std::string& bucket, const std::string& key, std::span<std::byte> buffer, const GetObjectInput& options) {
+    size_t offset = 0;
+    bool overflow = false;
+    // Bytes go from the cURL receive buffer into `buffer` directly, nothing
+    // else is allocated for the body
+    auto res = GetObject(bucket, key, [&](std::string_view chunk) {
+        if (chunk.size() > buffer.size() - offset) {
+            overflow = true;
+            return false;
         }
-    }
-
-    // Remove the initial empty object if it was never populated
-    if (!result.Buckets.empty() && result.Buckets[0].Name.empty()) {
-        result.Buckets.erase(result.Buckets.begin());
-    }
-
-    return result;
+        std::memcpy(buffer.data() + offset, chunk.data(), chunk.size());
+        offset += chunk.size();
+        return true;
+    },
+        options);
+
+    if (overflow)
+        return std::unexpected<Error>(Error { .Code = "BufferTooSmall", .Message = std::format("The object does not fit in a buffer of {} bytes", buffer.size()) });
+    if (res)
+        res->ContentLength = offset;
+    return res;
 }
 
-std::expected<std::string, Error> S3Client::GetObject(const std::string& bucket, const std::string& key, const GetObjectInput& options) {
+HttpRequest S3Client::buildGetObjectRequest(const std::string& bucket, const std::string& key, const GetObjectInput& options) {
     std::string url = buildURL(bucket) + std::format("/{}", key);
 
     HttpRequest req = Client.get(url).header("Host", getHostHeader(bucket));
@@ -272,39 +756,168 @@ std::expected<std::string, Error> S3Client::GetObject(const std::string& bucket,
         req.header("If-Modified-Since", options.If_Modified_Since.value());
     if (options.If_Unmodified_Since.has_value())
         req.header("If-Unmodified-Since", options.If_Unmodified_Since.value());
+    if (options.CheckSumMode.has_value())
+        req.header("x-amz-checksum-mode", options.CheckSumMode.value());
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    return req;
+}
 
+std::expected<std::string, Error> S3Client::parseGetObjectResponse(const HttpResponse& res) {
     if (res.is_ok()) {
+        // Only sent back with x-amz-checksum-mode: ENABLED
+        if (std::optional<ChecksumAlgorithm> algorithm = verifiableChecksum(res)) {
+            Checksum checksum(*algorithm);
+            checksum.update(res.body());
+            if (std::optional<Error> error = checkChecksum(res, checksum))
+                return std::unexpected<Error>(*error);
+        }
         return res.body();
     }
-    return std::unexpected<Error>(deserializeError(Parser.parse(res.body())));
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+std::expected<GetObjectResult, Error> S3Client::parseGetObjectStreamResponse(const HttpResponse& res, bool sinkStopped) {
+    if (res.is_ok()) {
+        if (sinkStopped)
+            return std::unexpected<Error>(Error { .Code = "SinkStopped", .Message = "The body sink stopped the transfer" });
+        return deserializeGetObjectResult(res.headers());
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
 }
 
 std::expected<PutObjectResult, Error> S3Client::PutObject(const std::string& bucket, const std::string& key, const std::string& body, const PutObjectInput& options) {
-    // TODO(cristian): For now let's support only string body
+    HttpBodyRequest req = buildPutObjectRequest(bucket, key, options).body(body);
+    if (std::optional<Error> error = addChecksum(req, options))
+        return std::unexpected<Error>(*error);
+    return parsePutObjectResponse(send(req));
+}
 
+std::expected<PutObjectResult, Error> S3Client::PutObject(const std::string& bucket, const std::string& key, HttpBodySource source, uint64_t contentLength, const PutObjectInput& options) {
+    HttpBodyRequest req = buildPutObjectRequest(bucket, key, options).body(std::move(source), contentLength);
+    if (std::optional<Error> error = addChecksum(req, options))
+        return std::unexpected<Error>(*error);
+    return parsePutObjectResponse(send(req));
+}
+
+std::expected<PutObjectResult, Error> S3Client::PutObject(const std::string& bucket, const std::string& key, int fd, const PutObjectInput& options) {
+    struct stat st;
+    off_t start = ::lseek(fd, 0, SEEK_CUR);
+    if (::fstat(fd, &st) != 0 || start < 0 || !S_ISREG(st.st_mode))
+        return std::unexpected<Error>(Error { .Code = "InvalidFile", .Message = "PutObject needs a seekable regular file descriptor" });
+
+    // pread(2) leaves the offset of `fd` alone and lets cURL rewind for free
+    off_t offset = start;
+    HttpBodySource source = [fd, &offset](char* buffer, size_t size) -> std::ptrdiff_t {
+        while (true) {
+            ssize_t n = ::pread(fd, buffer, size, offset);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n > 0)
+                offset += n;
+            return n;
+        }
+    };
+    HttpBodyRewind rewind = [start, &offset] {
+        offset = start;
+        return true;
+    };
+
+    HttpBodyRequest req = buildPutObjectRequest(bucket, key, options).body(std::move(source), st.st_size - start, std::move(rewind));
+    if (std::optional<Error> error = addChecksum(req, options))
+        return std::unexpected<Error>(*error);
+    return parsePutObjectResponse(send(req));
+}
+
+std::expected<PutObjectResult, Error> S3Client::PutObjectFromFile(const std::string& bucket, const std::string& key, const std::string& path, const PutObjectInput& options) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidFile", .Message = std::format("Could not open {}: {}", path, std::strerror(errno)) });
+    auto res = PutObject(bucket, key, fd, options);
+    ::close(fd);
+    return res;
+}
+
+std::future<std::expected<PutObjectResult, Error>> S3Client::PutObjectAsync(const std::string& bucket, const std::string& key, const std::string& body, const PutObjectInput& options) {
+    HttpBodyRequest req = buildPutObjectRequest(bucket, key, options).body(body);
+    if (std::optional<Error> error = addChecksum(req, options)) {
+        std::promise<std::expected<PutObjectResult, Error>> failed;
+        failed.set_value(std::unexpected<Error>(*error));
+        return failed.get_future();
+    }
+    return sendAsync<PutObjectResult>(req, [this](const HttpResponse& res) {
+        return parsePutObjectResponse(res);
+    });
+}
+
+HttpBodyRequest S3Client::buildPutObjectRequest(const std::string& bucket, const std::string& key, const PutObjectInput& options) {
+    // The body (in memory or streamed) is set by the caller
     std::string url = buildURL(bucket) + std::format("/{}", key);
 
-    HttpBodyRequest req = Client.put(url)
-                              .header("Host", getHostHeader(bucket))
-                              .body(body);
+    HttpBodyRequest req = Client.put(url).header("Host", getHostHeader(bucket));
 
     // opt headers
-    // ...
-
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    if (options.CacheControl.has_value())
+        req.header("Cache-Control", options.CacheControl.value());
+    if (options.ContentDisposition.has_value())
+        req.header("Content-Disposition", options.ContentDisposition.value());
+    if (options.ContentEncoding.has_value())
+        req.header("Content-Encoding", options.ContentEncoding.value());
+    if (options.ContentLanguage.has_value())
+        req.header("Content-Language", options.ContentLanguage.value());
+    if (options.ContentMD5.has_value())
+        req.header("Content-MD5", options.ContentMD5.value());
+    if (options.ContentType.has_value())
+        req.header("Content-Type", options.ContentType.value());
+    if (options.Expires.has_value())
+        req.header("Expires", options.Expires.value());
+    if (options.IfMatch.has_value())
+        req.header("If-Match", options.IfMatch.value());
+    if (options.IfNoneMatch.has_value())
+        req.header("If-None-Match", options.IfNoneMatch.value());
+    if (options.StorageClass.has_value())
+        req.header("x-amz-storage-class", options.StorageClass.value());
+    if (options.Tagging.has_value())
+        req.header("x-amz-tagging", options.Tagging.value());
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+    if (options.ChecksumCRC32.has_value())
+        req.header("x-amz-checksum-crc32", options.ChecksumCRC32.value());
+    if (options.ChecksumCRC32C.has_value())
+        req.header("x-amz-checksum-crc32c", options.ChecksumCRC32C.value());
+    if (options.ChecksumCRC64NVME.has_value())
+        req.header("x-amz-checksum-crc64nvme", options.ChecksumCRC64NVME.value());
+    if (options.ChecksumSHA1.has_value())
+        req.header("x-amz-checksum-sha1", options.ChecksumSHA1.value());
+    if (options.ChecksumSHA256.has_value())
+        req.header("x-amz-checksum-sha256", options.ChecksumSHA256.value());
+    if (options.SDKChecksumAlgorithm.has_value())
+        req.header("x-amz-sdk-checksum-algorithm", options.SDKChecksumAlgorithm.value());
+
+    return req;
+}
 
+std::expected<PutObjectResult, Error> S3Client::parsePutObjectResponse(const HttpResponse& res) {
     if (res.is_ok()) {
         return deserializePutObjectResult(res.headers());
     }
-    const std::vector<XMLNode>& XMLBody = Parser.parse(res.body());
-    return std::unexpected<Error>(deserializeError(XMLBody));
+    return std::unexpected<Error>(deserializeError(res.body()));
 }
 
 std::expected<DeleteObjectResult, Error> S3Client::DeleteObject(const std::string& bucket, const std::string& key, const DeleteObjectInput& options) {
+    HttpBodyRequest req = buildDeleteObjectRequest(bucket, key, options);
+    return parseDeleteObjectResponse(send(req));
+}
+
+std::future<std::expected<DeleteObjectResult, Error>> S3Client::DeleteObjectAsync(const std::string& bucket, const std::string& key, const DeleteObjectInput& options) {
+    HttpBodyRequest req = buildDeleteObjectRequest(bucket, key, options);
+    return sendAsync<DeleteObjectResult>(req, [this](const HttpResponse& res) {
+        return parseDeleteObjectResponse(res);
+    });
+}
+
+HttpBodyRequest S3Client::buildDeleteObjectRequest(const std::string& bucket, const std::string& key, const DeleteObjectInput& options) {
     std::string url = buildURL(bucket) + std::format("/{}", key);
     if (options.versionId.has_value())
         url += std::format("?versionId={}", options.versionId.value());
@@ -327,13 +940,66 @@ std::expected<DeleteObjectResult, Error> S3Client::DeleteObject(const std::strin
     if (options.If_MatchSize.has_value())
         req.header("x-amz-if-match-size", options.If_MatchSize.value());
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    return req;
+}
 
+std::expected<DeleteObjectResult, Error> S3Client::parseDeleteObjectResponse(const HttpResponse& res) {
     if (res.is_ok()) {
         return deserializeDeleteObjectResult(res.headers());
     }
-    return std::unexpected<Error>(deserializeError(Parser.parse(res.body())));
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+std::expected<DeleteObjectsResult, Error> S3Client::DeleteObjects(const std::string& bucket, std::span<const std::string> keys, const DeleteObjectsInput& options) {
+    std::vector<ObjectIdentifier> objects;
+    objects.reserve(keys.size());
+    for (const auto& key : keys)
+        objects.push_back(ObjectIdentifier { .Key = key });
+    return DeleteObjects(bucket, objects, options);
+}
+
+std::expected<DeleteObjectsResult, Error> S3Client::DeleteObjects(const std::string& bucket, std::span<const ObjectIdentifier> objects, const DeleteObjectsInput& options) {
+    if (objects.empty() || objects.size() > 1000)
+        return std::unexpected<Error>(Error { .Code = "InvalidArgument", .Message = std::format("DeleteObjects takes 1 to 1000 keys, got {}", objects.size()) });
+
+    std::string url = buildURL(bucket) + "?delete";
+
+    HttpBodyRequest req = Client.post(url).header("Host", getHostHeader(bucket));
+
+    // opt headers
+    if (options.MFA.has_value())
+        req.header("x-amz-mfa", options.MFA.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+    if (options.BypassGovernanceRetention.has_value())
+        req.header("x-amz-bypass-governance-retention", options.BypassGovernanceRetention.value() ? "true" : "false");
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+
+    // XML request body
+    // https://docs.aws.amazon.com/AmazonS3/latest/API/API_DeleteObjects.html#API_DeleteObjects_RequestSyntax
+    std::string deleteReqBodyXML = R"(<Delete xmlns="http://s3.amazonaws.com/doc/2006-03-01/">)";
+    for (const auto& object : objects) {
+        deleteReqBodyXML += "<Object>";
+        deleteReqBodyXML += std::format("<Key>{}</Key>", xmlEscape(object.Key));
+        if (object.VersionId.has_value())
+            deleteReqBodyXML += std::format("<VersionId>{}</VersionId>", xmlEscape(object.VersionId.value()));
+        deleteReqBodyXML += "</Object>";
+    }
+    if (options.Quiet.value_or(false))
+        deleteReqBodyXML += "<Quiet>true</Quiet>";
+    deleteReqBodyXML += "</Delete>";
+
+    // S3 refuses a DeleteObjects without an integrity check of the body
+    req.header("Content-MD5", contentMD5(deleteReqBodyXML));
+    req.body(std::move(deleteReqBodyXML));
+
+    HttpResponse res = send(req);
+
+    if (res.is_ok()) {
+        return deserializeDeleteObjectsResult(res.body());
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
 }
 
 std::expected<CreateBucketResult, Error> S3Client::CreateBucket(
@@ -401,14 +1067,12 @@ std::expected<CreateBucketResult, Error> S3Client::CreateBucket(
     createBucketReqBodyXML += "</CreateBucketConfiguration>";
     req.body(std::move(createBucketReqBodyXML));
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    HttpResponse res = send(req);
 
     if (res.is_ok()) {
         return deserializeCreateBucketResult(res.headers());
     }
-    const std::vector<XMLNode>& XMLBody = Parser.parse(res.body());
-    return std::unexpected<Error>(deserializeError(XMLBody));
+    return std::unexpected<Error>(deserializeError(res.body()));
 }
 
 std::expected<void, Error> S3Client::DeleteBucket(const std::string& bucket, const DeleteBucketInput& options) {
@@ -420,14 +1084,12 @@ std::expected<void, Error> S3Client::DeleteBucket(const std::string& bucket, con
     if (options.ExpectedBucketOwner.has_value())
         req.header("x-amz-expected-bucket-owner", std::move(options.ExpectedBucketOwner.value()));
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    HttpResponse res = send(req);
 
     if (res.status() == 204) {
         return {};
     }
-    const std::vector<XMLNode>& XMLBody = Parser.parse(res.body());
-    return std::unexpected<Error>(deserializeError(XMLBody));
+    return std::unexpected<Error>(deserializeError(res.body()));
 }
 
 std::expected<HeadBucketResult, Error> S3Client::HeadBucket(const std::string& bucket, const HeadBucketInput& options) {
@@ -439,8 +1101,7 @@ std::expected<HeadBucketResult, Error> S3Client::HeadBucket(const std::string& b
     if (options.ExpectedBucketOwner.has_value())
         req.header("x-amz-expected-bucket-owner", std::move(options.ExpectedBucketOwner.value()));
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    HttpResponse res = send(req);
 
     if (res.status() == 200) {
         return deserializeHeadBucketResult(res.headers());
@@ -468,6 +1129,18 @@ std::expected<HeadBucketResult, Error> S3Client::HeadBucket(const std::string& b
 }
 
 std::expected<HeadObjectResult, Error> S3Client::HeadObject(const std::string& bucket, const std::string& key, const HeadObjectInput& options) {
+    HttpRequest req = buildHeadObjectRequest(bucket, key, options).hedge(hedging_);
+    return parseHeadObjectResponse(send(req));
+}
+
+std::future<std::expected<HeadObjectResult, Error>> S3Client::HeadObjectAsync(const std::string& bucket, const std::string& key, const HeadObjectInput& options) {
+    HttpRequest req = buildHeadObjectRequest(bucket, key, options);
+    return sendAsync<HeadObjectResult>(req, [this](const HttpResponse& res) {
+        return parseHeadObjectResponse(res);
+    });
+}
+
+HttpRequest S3Client::buildHeadObjectRequest(const std::string& bucket, const std::string& key, const HeadObjectInput& options) {
     std::string url = buildURL(bucket) + std::format("/{}", key);
 
     // Query params
@@ -531,9 +1204,10 @@ std::expected<HeadObjectResult, Error> S3Client::HeadObject(const std::string& b
     if (options.SideEncryptionCustomerKeyMD5.has_value())
         req.header("x-amz-server-side-encryption-customer-key-MD5", options.SideEncryptionCustomerKeyMD5.value());
 
-    Signer.sign(req);
-    HttpResponse res = req.execute();
+    return req;
+}
 
+std::expected<HeadObjectResult, Error> S3Client::parseHeadObjectResponse(const HttpResponse& res) {
     if (res.status() == 200) {
         return deserializeHeadObjectResult(res.headers());
     }
@@ -558,78 +1232,526 @@ std::expected<HeadObjectResult, Error> S3Client::HeadObject(const std::string& b
     return std::unexpected<Error>(error);
 }
 
-Error S3Client::deserializeError(const std::vector<XMLNode>& nodes) {
-    Error error;
+std::expected<CopyObjectResult, Error> S3Client::CopyObject(const std::string& sourceBucket, const std::string& sourceKey, const std::string& bucket, const std::string& key, const CopyObjectInput& options) {
+    std::string url = buildURL(bucket) + std::format("/{}", key);
 
-    for (const auto& node : nodes) {
-        /* Sigh... no reflection */
-
-        if (node.tag == "Error.Code") {
-            error.Code = std::move(node.value);
-        } else if (node.tag == "Error.Message") {
-            error.Message = std::move(node.value);
-        } else if (node.tag == "Error.Resource") {
-            error.Resource = std::move(node.value);
-        } else if (node.tag == "Error.RequestId") {
-            error.RequestId = Parser.parseNumber<int>(std::move(node.value));
-        } else {
-            continue;
-        }
+    HttpBodyRequest req = Client.put(url)
+                              .header("Host", getHostHeader(bucket))
+                              .header("x-amz-copy-source", buildCopySource(sourceBucket, sourceKey, options.SourceVersionId));
+
+    // opt headers
+    if (options.CopySourceIfMatch.has_value())
+        req.header("x-amz-copy-source-if-match", options.CopySourceIfMatch.value());
+    if (options.CopySourceIfModifiedSince.has_value())
+        req.header("x-amz-copy-source-if-modified-since", options.CopySourceIfModifiedSince.value());
+    if (options.CopySourceIfNoneMatch.has_value())
+        req.header("x-amz-copy-source-if-none-match", options.CopySourceIfNoneMatch.value());
+    if (options.CopySourceIfUnmodifiedSince.has_value())
+        req.header("x-amz-copy-source-if-unmodified-since", options.CopySourceIfUnmodifiedSince.value());
+    if (options.ACL.has_value())
+        req.header("x-amz-acl", options.ACL.value());
+    if (options.CacheControl.has_value())
+        req.header("Cache-Control", options.CacheControl.value());
+    if (options.ContentDisposition.has_value())
+        req.header("Content-Disposition", options.ContentDisposition.value());
+    if (options.ContentEncoding.has_value())
+        req.header("Content-Encoding", options.ContentEncoding.value());
+    if (options.ContentLanguage.has_value())
+        req.header("Content-Language", options.ContentLanguage.value());
+    if (options.ContentType.has_value())
+        req.header("Content-Type", options.ContentType.value());
+    if (options.Expires.has_value())
+        req.header("Expires", options.Expires.value());
+    if (options.ChecksumAlgorithm.has_value())
+        req.header("x-amz-checksum-algorithm", options.ChecksumAlgorithm.value());
+    if (options.MetadataDirective.has_value())
+        req.header("x-amz-metadata-directive", options.MetadataDirective.value());
+    if (options.TaggingDirective.has_value())
+        req.header("x-amz-tagging-directive", options.TaggingDirective.value());
+    if (options.Tagging.has_value())
+        req.header("x-amz-tagging", options.Tagging.value());
+    if (options.ServerSideEncryption.has_value())
+        req.header("x-amz-server-side-encryption", options.ServerSideEncryption.value());
+    if (options.StorageClass.has_value())
+        req.header("x-amz-storage-class", options.StorageClass.value());
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.ExpectedSourceBucketOwner.has_value())
+        req.header("x-amz-source-expected-bucket-owner", options.ExpectedSourceBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+
+    HttpResponse res = send(req);
+
+    // Note: a copy can fail after the 200 OK was sent, the <Error> then
+    // comes in the body. deserializeCopyObjectResult handles that case
+    if (res.is_ok()) {
+        return deserializeCopyObjectResult(res.body(), res.headers());
     }
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
 
-    return error;
+std::string S3Client::buildCopySource(const std::string& bucket, const std::string& key, const std::optional<std::string>& versionId) const {
+    std::string source = std::format("/{}/{}", bucket, uriEncodePath(key));
+    if (versionId.has_value())
+        source += std::format("?versionId={}", versionId.value());
+    return source;
 }
 
-std::expected<PutObjectResult, Error> S3Client::deserializePutObjectResult(const std::map<std::string, std::string, LowerCaseCompare>& headers) {
-    PutObjectResult result;
+std::expected<std::string, Error> S3Client::PresignGetObject(const std::string& bucket, const std::string& key, std::chrono::seconds expires, const PresignGetObjectInput& options) {
+    if (auto error = checkPresignExpiry(expires))
+        return std::unexpected<Error>(*error);
+
+    std::vector<std::pair<std::string, std::string>> query;
+    if (options.response_cache_control.has_value())
+        query.emplace_back("response-cache-control", options.response_cache_control.value());
+    if (options.response_content_disposition.has_value())
+        query.emplace_back("response-content-disposition", options.response_content_disposition.value());
+    if (options.response_content_encoding.has_value())
+        query.emplace_back("response-content-encoding", options.response_content_encoding.value());
+    if (options.response_content_language.has_value())
+        query.emplace_back("response-content-language", options.response_content_language.value());
+    if (options.response_content_type.has_value())
+        query.emplace_back("response-content-type", options.response_content_type.value());
+    if (options.response_expires.has_value())
+        query.emplace_back("response-expires", options.response_expires.value());
+    if (options.versionId.has_value())
+        query.emplace_back("versionId", options.versionId.value());
 
-    for (const auto& [header, value] : headers) {
-        /* Sigh... no reflection */
-        if (header == "ETag")
-            result.ETag = std::move(value);
-        else if (header == "Expiration")
-            result.Expiration = std::move(value);
-        else if (header == "ChecksumCRC32")
-            result.ChecksumCRC32 = std::move(value);
-        else if (header == "ChecksumCRC32C")
-            result.ChecksumCRC32C = std::move(value);
-        else if (header == "ChecksumCRC64NVME")
-            result.ChecksumCRC64NVME = std::move(value);
-        else if (header == "ChecksumSHA1")
-            result.ChecksumSHA1 = std::move(value);
-        else if (header == "ChecksumSHA256")
-            result.ChecksumSHA256 = std::move(value);
-        else if (header == "ChecksumType")
-            result.ChecksumType = std::move(value);
-        else if (header == "ServerSideEncryption")
-            result.ServerSideEncryption = std::move(value);
-        else if (header == "VersionId")
-            result.VersionId = std::move(value);
-        else if (header == "SSECustomerAlgorithm")
-            result.SSECustomerAlgorithm = std::move(value);
-        else if (header == "SSECustomerKeyMD5")
-            result.SSECustomerKeyMD5 = std::move(value);
-        else if (header == "SSEKMSKeyId")
-            result.SSEKMSKeyId = std::move(value);
-        else if (header == "SSEKMSEncryptionContext")
-            result.SSEKMSEncryptionContext = std::move(value);
-        else if (header == "BucketKeyEnabled")
-            result.BucketKeyEnabled = Parser.parseBool(value);
-        else if (header == "Size")
-            result.Size = Parser.parseNumber<int64_t>(value);
-        else if (header == "RequestCharged")
-            result.RequestCharged = std::move(value);
-        else {
-            continue;
-            // To debug:
-            // throw std::runtime_error(std::format("No case for PutObjectResult response found for: {}", header));
+    return Signer.presign("GET", buildURL(bucket) + "/" + uriEncodePath(key), getHostHeader(bucket), expires, query);
+}
+
+std::expected<std::vector<std::string>, Error> S3Client::PresignGetObjects(const std::string& bucket, std::span<const std::string> keys, std::chrono::seconds expires) {
+    if (auto error = checkPresignExpiry(expires))
+        return std::unexpected<Error>(*error);
+
+    const std::string bucketURL = buildURL(bucket);
+    std::vector<std::string> urls;
+    urls.reserve(keys.size());
+    for (const auto& key : keys)
+        urls.push_back(bucketURL + "/" + uriEncodePath(key));
+    return Signer.presign("GET", urls, getHostHeader(bucket), expires);
+}
+
+std::expected<std::string, Error> S3Client::PresignPutObject(const std::string& bucket, const std::string& key, std::chrono::seconds expires) {
+    if (auto error = checkPresignExpiry(expires))
+        return std::unexpected<Error>(*error);
+    return Signer.presign("PUT", buildURL(bucket) + "/" + uriEncodePath(key), getHostHeader(bucket), expires);
+}
+
+std::expected<std::string, Error> S3Client::PresignHeadObject(const std::string& bucket, const std::string& key, std::chrono::seconds expires, const PresignHeadObjectInput& options) {
+    if (auto error = checkPresignExpiry(expires))
+        return std::unexpected<Error>(*error);
+
+    std::vector<std::pair<std::string, std::string>> query;
+    if (options.versionId.has_value())
+        query.emplace_back("versionId", options.versionId.value());
+    return Signer.presign("HEAD", buildURL(bucket) + "/" + uriEncodePath(key), getHostHeader(bucket), expires, query);
+}
+
+std::expected<CreateMultipartUploadResult, Error> S3Client::CreateMultipartUpload(const std::string& bucket, const std::string& key, const CreateMultipartUploadInput& options) {
+    std::string url = buildURL(bucket) + std::format("/{}?uploads", key);
+
+    HttpBodyRequest req = Client.post(url).header("Host", getHostHeader(bucket));
+
+    // opt headers
+    if (options.CacheControl.has_value())
+        req.header("Cache-Control", options.CacheControl.value());
+    if (options.ContentDisposition.has_value())
+        req.header("Content-Disposition", options.ContentDisposition.value());
+    if (options.ContentEncoding.has_value())
+        req.header("Content-Encoding", options.ContentEncoding.value());
+    if (options.ContentLanguage.has_value())
+        req.header("Content-Language", options.ContentLanguage.value());
+    if (options.ContentType.has_value())
+        req.header("Content-Type", options.ContentType.value());
+    if (options.Expires.has_value())
+        req.header("Expires", options.Expires.value());
+    if (options.ChecksumAlgorithm.has_value())
+        req.header("x-amz-checksum-algorithm", options.ChecksumAlgorithm.value());
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+    if (options.ServerSideEncryption.has_value())
+        req.header("x-amz-server-side-encryption", options.ServerSideEncryption.value());
+    if (options.SSEKMSKeyId.has_value())
+        req.header("x-amz-server-side-encryption-aws-kms-key-id", options.SSEKMSKeyId.value());
+    if (options.StorageClass.has_value())
+        req.header("x-amz-storage-class", options.StorageClass.value());
+    if (options.Tagging.has_value())
+        req.header("x-amz-tagging", options.Tagging.value());
+
+    HttpResponse res = send(req);
+
+    if (res.is_ok()) {
+        return deserializeCreateMultipartUploadResult(res.body());
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+std::expected<UploadPartResult, Error> S3Client::UploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, const std::string& body, const UploadPartInput& options) {
+    HttpBodyRequest req = buildUploadPartRequest(bucket, key, uploadId, partNumber, options).body(body);
+    return parseUploadPartResponse(send(req));
+}
+
+std::expected<UploadPartResult, Error> S3Client::UploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, HttpBodySource source, uint64_t contentLength, const UploadPartInput& options) {
+    return UploadPart(bucket, key, uploadId, partNumber, std::move(source), contentLength, HttpBodyRewind {}, options);
+}
+
+std::expected<UploadPartResult, Error> S3Client::UploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, HttpBodySource source, uint64_t contentLength, HttpBodyRewind rewind, const UploadPartInput& options) {
+    HttpBodyRequest req = buildUploadPartRequest(bucket, key, uploadId, partNumber, options).body(std::move(source), contentLength, std::move(rewind));
+    return parseUploadPartResponse(send(req));
+}
+
+HttpBodyRequest S3Client::buildUploadPartRequest(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, const UploadPartInput& options) {
+    std::string url = buildURL(bucket) + std::format("/{}?partNumber={}&uploadId={}", key, partNumber, uploadId);
+
+    HttpBodyRequest req = Client.put(url).header("Host", getHostHeader(bucket));
+
+    // opt headers
+    if (options.ContentMD5.has_value())
+        req.header("Content-MD5", options.ContentMD5.value());
+    if (options.ChecksumCRC32.has_value())
+        req.header("x-amz-checksum-crc32", options.ChecksumCRC32.value());
+    if (options.ChecksumCRC32C.has_value())
+        req.header("x-amz-checksum-crc32c", options.ChecksumCRC32C.value());
+    if (options.ChecksumSHA1.has_value())
+        req.header("x-amz-checksum-sha1", options.ChecksumSHA1.value());
+    if (options.ChecksumSHA256.has_value())
+        req.header("x-amz-checksum-sha256", options.ChecksumSHA256.value());
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+
+    return req;
+}
+
+std::expected<UploadPartResult, Error> S3Client::parseUploadPartResponse(const HttpResponse& res) {
+    if (res.is_ok()) {
+        return deserializeUploadPartResult(res.headers());
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+std::expected<UploadPartCopyResult, Error> S3Client::UploadPartCopy(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, const std::string& sourceBucket, const std::string& sourceKey, const UploadPartCopyInput& options) {
+    std::string url = buildURL(bucket) + std::format("/{}?partNumber={}&uploadId={}", key, partNumber, uploadId);
+
+    HttpBodyRequest req = Client.put(url)
+                              .header("Host", getHostHeader(bucket))
+                              .header("x-amz-copy-source", buildCopySource(sourceBucket, sourceKey, options.SourceVersionId));
+
+    // opt headers
+    if (options.CopySourceRange.has_value())
+        req.header("x-amz-copy-source-range", options.CopySourceRange.value());
+    if (options.CopySourceIfMatch.has_value())
+        req.header("x-amz-copy-source-if-match", options.CopySourceIfMatch.value());
+    if (options.CopySourceIfModifiedSince.has_value())
+        req.header("x-amz-copy-source-if-modified-since", options.CopySourceIfModifiedSince.value());
+    if (options.CopySourceIfNoneMatch.has_value())
+        req.header("x-amz-copy-source-if-none-match", options.CopySourceIfNoneMatch.value());
+    if (options.CopySourceIfUnmodifiedSince.has_value())
+        req.header("x-amz-copy-source-if-unmodified-since", options.CopySourceIfUnmodifiedSince.value());
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.ExpectedSourceBucketOwner.has_value())
+        req.header("x-amz-source-expected-bucket-owner", options.ExpectedSourceBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+
+    HttpResponse res = send(req);
+
+    if (res.is_ok()) {
+        return deserializeUploadPartCopyResult(res.body(), res.headers());
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+std::expected<CompleteMultipartUploadResult, Error> S3Client::CompleteMultipartUpload(const std::string& bucket, const std::string& key, const std::string& uploadId, const std::vector<CompletedPart>& parts, const CompleteMultipartUploadInput& options) {
+    std::string url = buildURL(bucket) + std::format("/{}?uploadId={}", key, uploadId);
+
+    HttpBodyRequest req = Client.post(url).header("Host", getHostHeader(bucket));
+
+    // opt headers
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+
+    // XML request body, parts must be in ascending PartNumber order
+    // https://docs.aws.amazon.com/AmazonS3/latest/API/API_CompleteMultipartUpload.html#API_CompleteMultipartUpload_RequestSyntax
+    std::string completeReqBodyXML = R"(<CompleteMultipartUpload xmlns="http://s3.amazonaws.com/doc/2006-03-01/">)";
+    for (const auto& part : parts) {
+        completeReqBodyXML += "<Part>";
+        completeReqBodyXML += std::format("<PartNumber>{}</PartNumber>", part.PartNumber);
+        completeReqBodyXML += std::format("<ETag>{}</ETag>", part.ETag);
+        if (!part.ChecksumCRC32.empty())
+            completeReqBodyXML += std::format("<ChecksumCRC32>{}</ChecksumCRC32>", part.ChecksumCRC32);
+        if (!part.ChecksumCRC32C.empty())
+            completeReqBodyXML += std::format("<ChecksumCRC32C>{}</ChecksumCRC32C>", part.ChecksumCRC32C);
+        if (!part.ChecksumSHA1.empty())
+            completeReqBodyXML += std::format("<ChecksumSHA1>{}</ChecksumSHA1>", part.ChecksumSHA1);
+        if (!part.ChecksumSHA256.empty())
+            completeReqBodyXML += std::format("<ChecksumSHA256>{}</ChecksumSHA256>", part.ChecksumSHA256);
+        completeReqBodyXML += "</Part>";
+    }
+    completeReqBodyXML += "</CompleteMultipartUpload>";
+    req.body(std::move(completeReqBodyXML));
+
+    HttpResponse res = send(req);
+
+    // Note: S3 may answer 200 OK and still fail the upload with an <Error>
+    // body, deserializeCompleteMultipartUploadResult handles that case
+    if (res.is_ok()) {
+        return deserializeCompleteMultipartUploadResult(res.body());
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+std::expected<void, Error> S3Client::AbortMultipartUpload(const std::string& bucket, const std::string& key, const std::string& uploadId, const AbortMultipartUploadInput& options) {
+    std::string url = buildURL(bucket) + std::format("/{}?uploadId={}", key, uploadId);
+
+    HttpBodyRequest req = Client.del(url).header("Host", getHostHeader(bucket));
+
+    // opt headers
+    if (options.ExpectedBucketOwner.has_value())
+        req.header("x-amz-expected-bucket-owner", options.ExpectedBucketOwner.value());
+    if (options.RequestPayer.has_value())
+        req.header("x-amz-request-payer", options.RequestPayer.value());
+
+    HttpResponse res = send(req);
+
+    if (res.status() == 204) {
+        return {};
+    }
+    return std::unexpected<Error>(deserializeError(res.body()));
+}
+
+Task<std::expected<ListObjectsResult, Error>> S3Client::ListObjectsTask(std::string bucket, ListObjectsInput options) {
+    HttpRequest req = buildListObjectsRequest(bucket, options);
+    HttpResponse res = co_await sendTask(req);
+    co_return parseListObjectsResponse(res, options.MaxKeys.value_or(1000));
+}
+
+Task<std::expected<std::string, Error>> S3Client::GetObjectTask(std::string bucket, std::string key, GetObjectInput options) {
+    HttpRequest req = buildGetObjectRequest(bucket, key, options);
+    HttpResponse res = co_await sendTask(req);
+    co_return parseGetObjectResponse(res);
+}
+
+Task<std::expected<PutObjectResult, Error>> S3Client::PutObjectTask(std::string bucket, std::string key, std::string body, PutObjectInput options) {
+    HttpBodyRequest req = buildPutObjectRequest(bucket, key, options).body(std::move(body));
+    if (std::optional<Error> error = addChecksum(req, options))
+        co_return std::unexpected<Error>(*error);
+    HttpResponse res = co_await sendTask(req);
+    co_return parsePutObjectResponse(res);
+}
+
+Task<std::expected<DeleteObjectResult, Error>> S3Client::DeleteObjectTask(std::string bucket, std::string key, DeleteObjectInput options) {
+    HttpBodyRequest req = buildDeleteObjectRequest(bucket, key, options);
+    HttpResponse res = co_await sendTask(req);
+    co_return parseDeleteObjectResponse(res);
+}
+
+Task<std::expected<HeadObjectResult, Error>> S3Client::HeadObjectTask(std::string bucket, std::string key, HeadObjectInput options) {
+    HttpRequest req = buildHeadObjectRequest(bucket, key, options);
+    HttpResponse res = co_await sendTask(req);
+    co_return parseHeadObjectResponse(res);
+}
+
+HttpResponse S3Client::send(HttpRequest& req) {
+    return sendWithRetries(req);
+}
+
+HttpResponse S3Client::send(HttpBodyRequest& req) {
+    return sendWithRetries(req);
+}
+
+template <typename Request>
+HttpResponse S3Client::sendWithRetries(Request& req) {
+    RateLimiter* rateLimiter = requestLimiter(req.getHttpMethod(), req.getURL());
+    if (retry_options_.MaxAttempts <= 1 && !concurrency_) {
+        if (rateLimiter)
+            rateLimiter->acquire();
+        Signer.sign(req);
+        return req.execute();
+    }
+    std::shared_ptr<ConcurrencyLimiter> limiter = concurrency_ ? concurrencyLimiter(req.getURL()) : nullptr;
+
+    // Signing adds headers and, for aws-chunked bodies, wraps the body source.
+    // Every attempt is signed from the request as it was handed in
+    const HttpHeaders headers = req.getHeaders();
+    HttpBodySource source;
+    HttpBodyRewind rewind;
+    uint64_t sourceLength = 0;
+    if constexpr (std::is_same_v<Request, HttpBodyRequest>) {
+        source = req.getBodySource();
+        rewind = req.getBodyRewind();
+        sourceLength = req.getBodySourceLength();
+    }
+    const bool idempotent = req.getHttpMethod() != HttpMethod::Post;
+
+    RetryBackoff backoff(retry_options_.BaseDelay, retry_options_.MaxDelay);
+    size_t spent = 0;
+    for (int attempt = 1;; attempt++) {
+        if (attempt > 1) {
+            req.headers(headers);
+            if constexpr (std::is_same_v<Request, HttpBodyRequest>) {
+                if (source)
+                    req.body(source, sourceLength, rewind);
+            }
+        }
+        if (rateLimiter)
+            rateLimiter->acquire();
+        // Waiting for a slot is not part of the latency of the attempt
+        std::optional<ConcurrencyPermit> permit;
+        if (limiter)
+            permit.emplace(limiter->acquire());
+        Signer.sign(req);
+
+        RetryCause cause = RetryCause::None;
+        ConcurrencySignal signal = ConcurrencySignal::None;
+        std::exception_ptr failure;
+        std::optional<HttpResponse> res;
+        try {
+            res.emplace(req.execute());
+        } catch (const HttpTransportError& error) {
+            // Whatever a sink was handed cannot be taken back
+            const bool delivered = req.getSink() && error.status() >= 200 && error.status() < 300;
+            cause = delivered ? RetryCause::None : retryCause(error.code(), idempotent);
+            if (error.code() == CURLE_OPERATION_TIMEDOUT)
+                signal = ConcurrencySignal::Congested;
+            failure = std::current_exception();
+        }
+        if (res && !res->is_ok()) {
+            std::string code;
+            if (!res->body().empty()) {
+                try {
+                    code = deserializeError(res->body()).Code;
+                } catch (const std::exception&) {
+                    // not an S3 error body, i.e. from a proxy
+                }
+            }
+            cause = retryCause(res->status(), code, idempotent);
+            if (cause == RetryCause::Throttling || res->status() == 503)
+                signal = ConcurrencySignal::Congested;
+        } else if (res) {
+            signal = ConcurrencySignal::Healthy;
+        }
+        if (permit)
+            permit->release(signal);
+
+        if (cause == RetryCause::None || attempt >= retry_options_.MaxAttempts) {
+            // Healthy requests fill the budget back up
+            if (res && res->is_ok())
+                retry_budget_->release(attempt == 1 ? 1 : spent);
+            if (failure)
+                std::rethrow_exception(failure);
+            return std::move(*res);
         }
+
+        const size_t cost = cause == RetryCause::Timeout ? retry_options_.TimeoutCost : retry_options_.RetryCost;
+        bool retry = retry_budget_->acquire(cost);
+        if constexpr (std::is_same_v<Request, HttpBodyRequest>) {
+            if (retry && source) {
+                retry = rewind && rewind();
+                if (!retry)
+                    retry_budget_->release(cost);
+            }
+        }
+        if (!retry) {
+            if (failure)
+                std::rethrow_exception(failure);
+            return std::move(*res);
+        }
+        spent = cost;
+        std::this_thread::sleep_for(backoff.next());
     }
+}
 
+std::pair<std::string_view, std::string_view> S3Client::splitURL(std::string_view url) const {
+    // scheme://host/path?query, built by buildURL()
+    if (const size_t scheme = url.find("://"); scheme != std::string_view::npos)
+        url.remove_prefix(scheme + 3);
+    url = url.substr(0, url.find('?'));
+    const size_t slash = url.find('/');
+    const std::string_view host = url.substr(0, slash);
+    std::string_view path = slash == std::string_view::npos ? std::string_view {} : url.substr(slash + 1);
+
+    std::string_view bucket;
+    if (addressing_style_ == S3AddressingStyle::VirtualHosted) {
+        // bucket.endpoint
+        if (host.size() > endpoint_.size() + 1 && host.ends_with(endpoint_))
+            bucket = host.substr(0, host.size() - endpoint_.size() - 1);
+    } else {
+        // endpoint/bucket/key
+        bucket = path.substr(0, path.find('/'));
+        path = bucket.size() < path.size() ? path.substr(bucket.size() + 1) : std::string_view {};
+    }
+    return { bucket, path };
+}
+
+std::shared_ptr<ConcurrencyLimiter> S3Client::concurrencyLimiter(const std::string& url) {
+    const auto [bucket, key] = splitURL(url);
+    return concurrency_->limiter(concurrency_->partition(bucket, key));
+}
+
+RateLimiter* S3Client::requestLimiter(HttpMethod method, const std::string& url) const {
+    switch (method) {
+    case HttpMethod::Get:
+        // Bucket-level GETs are listings, ListObjects and ListBuckets
+        return (splitURL(url).second.empty() ? rate_limits_.List : rate_limits_.Get).get();
+    case HttpMethod::Head:
+        return rate_limits_.Get.get();
+    case HttpMethod::Post:
+        // POST /?delete is DeleteObjects, the others are multipart uploads
+        return (url.ends_with("?delete") ? rate_limits_.Delete : rate_limits_.Put).get();
+    case HttpMethod::Put:
+        return rate_limits_.Put.get();
+    case HttpMethod::Delete:
+        return rate_limits_.Delete.get();
+    }
+    return nullptr;
+}
+
+Error S3Client::deserializeError(std::string_view body) {
+    // The <Error> root makes parseXML() hand it back as the unexpected value
+    std::expected<Error, Error> error = parseXML(body, ErrorFields);
+    return error ? std::move(*error) : std::move(error.error());
+}
+
+std::expected<PutObjectResult, Error> S3Client::deserializePutObjectResult(const HttpHeaders& headers) {
+    PutObjectResult result {};
+    // Header names are case-insensitive, lookups go through LowerCaseCompare
+    auto value = [&headers](std::string_view header) -> std::string {
+        auto it = headers.find(header);
+        return (it != headers.end()) ? std::string(it->second) : "";
+    };
+
+    result.ETag = value("ETag");
+    result.Expiration = value("x-amz-expiration");
+    result.ChecksumCRC32 = value("x-amz-checksum-crc32");
+    result.ChecksumCRC32C = value("x-amz-checksum-crc32c");
+    result.ChecksumCRC64NVME = value("x-amz-checksum-crc64nvme");
+    result.ChecksumSHA1 = value("x-amz-checksum-sha1");
+    result.ChecksumSHA256 = value("x-amz-checksum-sha256");
+    result.ChecksumType = value("x-amz-checksum-type");
+    result.ServerSideEncryption = value("x-amz-server-side-encryption");
+    result.VersionId = value("x-amz-version-id");
+    result.SSECustomerAlgorithm = value("x-amz-server-side-encryption-customer-algorithm");
+    result.SSECustomerKeyMD5 = value("x-amz-server-side-encryption-customer-key-MD5");
+    result.SSEKMSKeyId = value("x-amz-server-side-encryption-aws-kms-key-id");
+    result.SSEKMSEncryptionContext = value("x-amz-server-side-encryption-context");
+    if (const std::string enabled = value("x-amz-server-side-encryption-bucket-key-enabled"); !enabled.empty())
+        result.BucketKeyEnabled = Parser.parseBool(enabled);
+    if (const std::string size = value("x-amz-object-size"); !size.empty())
+        result.Size = Parser.parseNumber<int64_t>(size);
+    result.RequestCharged = value("x-amz-request-charged");
     return result;
 }
 
-std::expected<DeleteObjectResult, Error> S3Client::deserializeDeleteObjectResult(const std::map<std::string, std::string, LowerCaseCompare>& headers) {
+std::expected<DeleteObjectResult, Error> S3Client::deserializeDeleteObjectResult(const HttpHeaders& headers) {
     DeleteObjectResult result;
     for (const auto& [header, value] : headers) {
         if (header == "x-amz-version-id")
@@ -645,7 +1767,7 @@ std::expected<DeleteObjectResult, Error> S3Client::deserializeDeleteObjectResult
     return result;
 }
 
-std::expected<CreateBucketResult, Error> S3Client::deserializeCreateBucketResult(const std::map<std::string, std::string, LowerCaseCompare>& headers) {
+std::expected<CreateBucketResult, Error> S3Client::deserializeCreateBucketResult(const HttpHeaders& headers) {
     CreateBucketResult result;
     for (const auto& [header, value] : headers) {
         if (header == "Location")
@@ -659,7 +1781,7 @@ std::expected<CreateBucketResult, Error> S3Client::deserializeCreateBucketResult
     return result;
 }
 
-std::expected<HeadBucketResult, Error> S3Client::deserializeHeadBucketResult(const std::map<std::string, std::string, LowerCaseCompare>& headers) {
+std::expected<HeadBucketResult, Error> S3Client::deserializeHeadBucketResult(const HttpHeaders& headers) {
     HeadBucketResult result;
     for (const auto& [header, value] : headers) {
         if (header == "x-amz-bucket-arn")
@@ -679,7 +1801,7 @@ std::expected<HeadBucketResult, Error> S3Client::deserializeHeadBucketResult(con
     return result;
 }
 
-std::expected<HeadObjectResult, Error> S3Client::deserializeHeadObjectResult(const std::map<std::string, std::string, LowerCaseCompare>& headers) {
+std::expected<HeadObjectResult, Error> S3Client::deserializeHeadObjectResult(const HttpHeaders& headers) {
     HeadObjectResult result;
     for (const auto& [header, value] : headers) {
         if (header == "x-amz-delete-marker")
@@ -762,3 +1884,85 @@ std::expected<HeadObjectResult, Error> S3Client::deserializeHeadObjectResult(con
     }
     return result;
 }
+
+std::expected<GetObjectResult, Error> S3Client::deserializeGetObjectResult(const HttpHeaders& headers) {
+    GetObjectResult result {};
+    // Header names are case-insensitive, lookups go through LowerCaseCompare
+    auto value = [&headers](std::string_view header) -> std::string {
+        auto it = headers.find(header);
+        return (it != headers.end()) ? std::string(it->second) : "";
+    };
+
+    result.AcceptRanges = value("accept-ranges");
+    result.CacheControl = value("Cache-Control");
+    result.ContentDisposition = value("Content-Disposition");
+    result.ContentEncoding = value("Content-Encoding");
+    result.ContentLanguage = value("Content-Language");
+    if (const std::string length = value("Content-Length"); !length.empty())
+        result.ContentLength = Parser.parseNumber<int64_t>(length);
+    result.ContentRange = value("Content-Range");
+    result.ContentType = value("Content-Type");
+    result.ChecksumCRC32 = value("x-amz-checksum-crc32");
+    result.ChecksumCRC32C = value("x-amz-checksum-crc32c");
+    result.ChecksumCRC64NVME = value("x-amz-checksum-crc64nvme");
+    result.ChecksumSHA1 = value("x-amz-checksum-sha1");
+    result.ChecksumSHA256 = value("x-amz-checksum-sha256");
+    result.ChecksumType = value("x-amz-checksum-type");
+    result.ETag = value("ETag");
+    result.Expires = value("Expires");
+    result.LastModified = value("Last-Modified");
+    if (const std::string parts = value("x-amz-mp-parts-count"); !parts.empty())
+        result.PartsCount = Parser.parseNumber<int>(parts);
+    result.StorageClass = value("x-amz-storage-class");
+    result.VersionId = value("x-amz-version-id");
+    return result;
+}
+
+std::expected<CreateMultipartUploadResult, Error> S3Client::deserializeCreateMultipartUploadResult(std::string_view body) {
+    return parseXML(body, CreateMultipartUploadFields);
+}
+
+std::expected<UploadPartResult, Error> S3Client::deserializeUploadPartResult(const HttpHeaders& headers) {
+    UploadPartResult result;
+    auto value = [&headers](std::string_view header) -> std::string {
+        auto it = headers.find(header);
+        return (it != headers.end()) ? std::string(it->second) : "";
+    };
+
+    result.ETag = value("ETag");
+    result.ChecksumCRC32 = value("x-amz-checksum-crc32");
+    result.ChecksumCRC32C = value("x-amz-checksum-crc32c");
+    result.ChecksumSHA1 = value("x-amz-checksum-sha1");
+    result.ChecksumSHA256 = value("x-amz-checksum-sha256");
+    result.ServerSideEncryption = value("x-amz-server-side-encryption");
+    return result;
+}
+
+std::expected<CompleteMultipartUploadResult, Error> S3Client::deserializeCompleteMultipartUploadResult(std::string_view body) {
+    return parseXML(body, CompleteMultipartUploadFields);
+}
+
+std::expected<DeleteObjectsResult, Error> S3Client::deserializeDeleteObjectsResult(std::string_view body) {
+    // <Deleted> and <Error> elements come interleaved, each one is a record of its own list
+    return parseXML(body, DeleteObjectsFields);
+}
+
+std::expected<CopyObjectResult, Error> S3Client::deserializeCopyObjectResult(std::string_view body, const HttpHeaders& headers) {
+    std::expected<CopyObjectResult, Error> result = parseXML(body, CopyObjectFields);
+    if (!result)
+        return result;
+    if (auto it = headers.find("x-amz-version-id"); it != headers.end())
+        result->VersionId = it->second;
+    if (auto it = headers.find("x-amz-copy-source-version-id"); it != headers.end())
+        result->CopySourceVersionId = it->second;
+    return result;
+}
+
+std::expected<UploadPartCopyResult, Error> S3Client::deserializeUploadPartCopyResult(std::string_view body, const HttpHeaders& headers) {
+    std::expected<UploadPartCopyResult, Error> result = parseXML(body, UploadPartCopyFields);
+    if (!result)
+        return result;
+    if (auto it = headers.find("x-amz-copy-source-version-id"); it != headers.end())
+        result->CopySourceVersionId = it->second;
+    return result;
+}
@@ -1,9 +1,24 @@
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <expected>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <thread>
 #include <s3cpp/auth.h>
 #include <s3cpp/httpclient.h>
+#include <s3cpp/limiter.h>
+#include <s3cpp/retry.h>
+#include <s3cpp/task.hpp>
 #include <s3cpp/types.h>
 #include <s3cpp/xml.hpp>
 
+class ListObjectsRange;
+
 class S3Client {
 public:
     S3Client(const std::string& access, const std::string& secret)
@@ -32,36 +47,148 @@ public:
 
     // S3 operations: Goal is to support CRUD and stay minimal
     std::expected<ListObjectsResult, Error> ListObjects(const std::string& bucket, const ListObjectsInput& options = {});
+    // Same page laid out by columns over an arena, see `CompactListObjectsResult`
+    std::expected<CompactListObjectsResult, Error> ListObjectsCompact(const std::string& bucket, const ListObjectsInput& options = {});
+    // Every object under `prefix`, page after page, with up to `prefetch`
+    // pages requested ahead. See `ListObjectsRange`
+    ListObjectsRange ListAll(const std::string& bucket, const std::string& prefix = "", size_t prefetch = 2);
     std::expected<ListAllMyBucketsResult, Error> ListBuckets(const ListBucketsInput& options = {});
     std::expected<std::string, Error> GetObject(const std::string& bucket, const std::string& key, const GetObjectInput& options = {});
+    // Streaming GetObject, the body is handed to the sink as it arrives and is never buffered whole
+    std::expected<GetObjectResult, Error> GetObject(const std::string& bucket, const std::string& key, const HttpBodySink& sink, const GetObjectInput& options = {});
+    std::expected<GetObjectResult, Error> GetObject(const std::string& bucket, const std::string& key, std::ostream& out, const GetObjectInput& options = {});
+    std::expected<GetObjectResult, Error> GetObject(const std::string& bucket, const std::string& key, int fd, const GetObjectInput& options = {});
+    // Read the body straight into a caller-owned buffer, e.g. sized from a prior
+    // HeadObject. Fails with `BufferTooSmall` rather than growing it
+    std::expected<GetObjectResult, Error> GetObjectInto(const std::string& bucket, const std::string& key, std::span<std::byte> buffer, const GetObjectInput& options = {});
     std::expected<PutObjectResult, Error> PutObject(const std::string& bucket, const std::string& key, const std::string& body, const PutObjectInput& options = {});
+    // Streaming PutObject, the body is pulled from `source` while it is sent and
+    // never held in memory whole. It cannot be hashed upfront, so the payload is
+    // sent as UNSIGNED-PAYLOAD, or signed chunk by chunk with `PayloadSigning::Streaming`
+    std::expected<PutObjectResult, Error> PutObject(const std::string& bucket, const std::string& key, HttpBodySource source, uint64_t contentLength, const PutObjectInput& options = {});
+    // Uploads from the current offset of `fd` to the end of the file
+    std::expected<PutObjectResult, Error> PutObject(const std::string& bucket, const std::string& key, int fd, const PutObjectInput& options = {});
+    std::expected<PutObjectResult, Error> PutObjectFromFile(const std::string& bucket, const std::string& key, const std::string& path, const PutObjectInput& options = {});
     std::expected<DeleteObjectResult, Error> DeleteObject(const std::string& bucket, const std::string& key, const DeleteObjectInput& options = {});
+    // Up to 1000 keys per call, keys that could not be deleted are listed in
+    // `DeleteObjectsResult::Errors`. See `BatchDeleter` (s3cpp/transfer.h) for more
+    std::expected<DeleteObjectsResult, Error> DeleteObjects(const std::string& bucket, std::span<const std::string> keys, const DeleteObjectsInput& options = {});
+    std::expected<DeleteObjectsResult, Error> DeleteObjects(const std::string& bucket, std::span<const ObjectIdentifier> objects, const DeleteObjectsInput& options = {});
     std::expected<CreateBucketResult, Error> CreateBucket(const std::string& bucket, const CreateBucketConfiguration& configuration = {}, const CreateBucketInput& options = {});
     std::expected<void, Error> DeleteBucket(const std::string& bucket, const DeleteBucketInput& options = {});
     std::expected<HeadBucketResult, Error> HeadBucket(const std::string& bucket, const HeadBucketInput& options = {});
     std::expected<HeadObjectResult, Error> HeadObject(const std::string& bucket, const std::string& key, const HeadObjectInput& options = {});
+    // Server-side copy, no data goes through the client. Up to 5 GB, see
+    // `MultipartCopier` (s3cpp/transfer.h) for larger objects
+    std::expected<CopyObjectResult, Error> CopyObject(const std::string& sourceBucket, const std::string& sourceKey, const std::string& bucket, const std::string& key, const CopyObjectInput& options = {});
+
+    // Presigned URLs, computed locally without any request. Whoever holds the
+    // URL can use it until it expires (7 days at most), no credentials needed
+    std::expected<std::string, Error> PresignGetObject(const std::string& bucket, const std::string& key, std::chrono::seconds expires, const PresignGetObjectInput& options = {});
+    // One URL per key, in the same order, all sharing the same signing time
+    std::expected<std::vector<std::string>, Error> PresignGetObjects(const std::string& bucket, std::span<const std::string> keys, std::chrono::seconds expires);
+    // The body is left unsigned, so any content can be uploaded with the URL
+    std::expected<std::string, Error> PresignPutObject(const std::string& bucket, const std::string& key, std::chrono::seconds expires);
+    std::expected<std::string, Error> PresignHeadObject(const std::string& bucket, const std::string& key, std::chrono::seconds expires, const PresignHeadObjectInput& options = {});
+
+    // Multipart upload, see `MultipartUploader` (s3cpp/transfer.h) to upload whole files in parallel
+    std::expected<CreateMultipartUploadResult, Error> CreateMultipartUpload(const std::string& bucket, const std::string& key, const CreateMultipartUploadInput& options = {});
+    std::expected<UploadPartResult, Error> UploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, const std::string& body, const UploadPartInput& options = {});
+    std::expected<UploadPartResult, Error> UploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, HttpBodySource source, uint64_t contentLength, const UploadPartInput& options = {});
+    // A streamed part is only retried if `rewind` can restart `source`
+    std::expected<UploadPartResult, Error> UploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, HttpBodySource source, uint64_t contentLength, HttpBodyRewind rewind, const UploadPartInput& options = {});
+    std::expected<CompleteMultipartUploadResult, Error> CompleteMultipartUpload(const std::string& bucket, const std::string& key, const std::string& uploadId, const std::vector<CompletedPart>& parts, const CompleteMultipartUploadInput& options = {});
+    std::expected<UploadPartCopyResult, Error> UploadPartCopy(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, const std::string& sourceBucket, const std::string& sourceKey, const UploadPartCopyInput& options = {});
+    std::expected<void, Error> AbortMultipartUpload(const std::string& bucket, const std::string& key, const std::string& uploadId, const AbortMultipartUploadInput& options = {});
+
+    // Asynchronous variants, driven by the event loop of the HttpClient
+    // As with the calls above, transport errors are thrown (from `future.get()`)
+    std::future<std::expected<ListObjectsResult, Error>> ListObjectsAsync(const std::string& bucket, const ListObjectsInput& options = {});
+    std::future<std::expected<std::string, Error>> GetObjectAsync(const std::string& bucket, const std::string& key, const GetObjectInput& options = {});
+    std::future<std::expected<PutObjectResult, Error>> PutObjectAsync(const std::string& bucket, const std::string& key, const std::string& body, const PutObjectInput& options = {});
+    std::future<std::expected<DeleteObjectResult, Error>> DeleteObjectAsync(const std::string& bucket, const std::string& key, const DeleteObjectInput& options = {});
+    std::future<std::expected<HeadObjectResult, Error>> HeadObjectAsync(const std::string& bucket, const std::string& key, const HeadObjectInput& options = {});
+
+    // Awaitable variants, for coroutines. Arguments are taken by value since
+    // the task only starts once it is `co_await`-ed
+    Task<std::expected<ListObjectsResult, Error>> ListObjectsTask(std::string bucket, ListObjectsInput options = {});
+    Task<std::expected<std::string, Error>> GetObjectTask(std::string bucket, std::string key, GetObjectInput options = {});
+    Task<std::expected<PutObjectResult, Error>> PutObjectTask(std::string bucket, std::string key, std::string body, PutObjectInput options = {});
+    Task<std::expected<DeleteObjectResult, Error>> DeleteObjectTask(std::string bucket, std::string key, DeleteObjectInput options = {});
+    Task<std::expected<HeadObjectResult, Error>> HeadObjectTask(std::string bucket, std::string key, HeadObjectInput options = {});
+
+    // Where coroutines are resumed once their request completes, by default
+    // on the process-wide `DefaultExecutor()`. Set it before issuing requests
+    void SetExecutor(std::shared_ptr<Executor> executor) { executor_ = std::move(executor); }
+    // How request bodies are signed, see `PayloadSigning`. Set it before issuing requests
+    void SetPayloadSigning(PayloadSigning mode) { Signer.setPayloadSigning(mode); }
+    // How failed requests are retried, 3 attempts by default. Set it before
+    // issuing requests, it also refills the retry budget
+    //
+    // Transport errors and 5xx responses are retried for every request but
+    // POSTs, which are only retried when S3 throttled them or they never left.
+    // Requests are signed again for every attempt, streamed bodies need a
+    // rewind callback to be retried and streamed responses are not retried once
+    // the sink has been handed data. Only the synchronous calls retry
+    void SetRetryOptions(const RetryOptions& options) {
+        retry_options_ = options;
+        retry_budget_ = std::make_unique<RetryBudget>(options.RetryBudget);
+    }
+    // The retry options in use and the retry budget of the client, for the
+    // callers that retry on top of it (see `ParallelDownloader`)
+    const RetryOptions& GetRetryOptions() const { return retry_options_; }
+    RetryBudget& GetRetryBudget() { return *retry_budget_; }
+    // Hedge the GetObject calls that return the body and the HeadObject calls,
+    // see `HttpHedging`. Off by default, set it before issuing requests
+    void SetHedging(const HttpHedgingOptions& options) { hedging_ = std::make_shared<HttpHedging>(options); }
+    // How many requests were hedged and how many hedges won, zeros while off
+    HttpHedgingStats HedgingStats() const { return hedging_ ? hedging_->stats() : HttpHedgingStats {}; }
+    // Cap the requests in flight per bucket and key prefix with a limit that
+    // adapts to S3, see `ConcurrencyLimiter`. Calls over the limit wait for a
+    // slot. Off by default, set it before issuing requests
+    //
+    // Every attempt of the synchronous calls takes a slot, so parallel
+    // transfers can be given a generous `Concurrency` and settle at the rate
+    // S3 sustains instead of running into SlowDown
+    void SetAdaptiveConcurrency(const ConcurrencyOptions& options) { concurrency_ = std::make_unique<AdaptiveConcurrency>(options); }
+    // The current limit of every partition in use, empty while off
+    std::vector<ConcurrencyLimit> ConcurrencyLimits() const { return concurrency_ ? concurrency_->limits() : std::vector<ConcurrencyLimit> {}; }
+    // Client-side rate limits, see `RateLimits`. Off by default, set them
+    // before issuing requests
+    //
+    // Every request takes a token of its class before it is sent, every
+    // attempt for the synchronous calls. The asynchronous ones wait on the
+    // event loop, after being signed, so a backlog of more than 15 minutes
+    // fails with RequestTimeTooSkewed. Bandwidth is limited inside the
+    // transfers, of every call. Give background jobs their own client with
+    // their own limits, latency-sensitive traffic is then left alone
+    void SetRateLimits(const RateLimits& limits) {
+        rate_limits_ = limits;
+        Client.set_rate_limits(limits.Upload, limits.Download);
+    }
 
     // S3 responses
 
-    /* TODO(cristian): Re-factor and re-think.
-     *
-     * In Go, this would be generalized using reflection and adding a method
-     * associated with the response struct.
-     *
-     * That is; Can we have a single deserialize method that takes in a struct
-     * and values and returns that?
-	  *
-	  * Otherwise; wait until C++26 to introduce reflection
-     */
-    std::expected<ListObjectsResult, Error> deserializeListObjectsResult(const std::vector<XMLNode>& nodes, const int maxKeys);
-    std::expected<ListAllMyBucketsResult, Error> deserializeListBucketsResult(const std::vector<XMLNode>& nodes, std::optional<int> maxBuckets);
-    std::expected<PutObjectResult, Error> deserializePutObjectResult(const std::map<std::string, std::string, LowerCaseCompare>& headers);
-    std::expected<DeleteObjectResult, Error> deserializeDeleteObjectResult(const std::map<std::string, std::string, LowerCaseCompare>& headers);
-    std::expected<CreateBucketResult, Error> deserializeCreateBucketResult(const std::map<std::string, std::string, LowerCaseCompare>& headers);
-    std::expected<HeadBucketResult, Error> deserializeHeadBucketResult(const std::map<std::string, std::string, LowerCaseCompare>& headers);
-    std::expected<HeadObjectResult, Error> deserializeHeadObjectResult(const std::map<std::string, std::string, LowerCaseCompare>& headers);
-
-    Error deserializeError(const std::vector<XMLNode>& nodes);
+    // XML bodies are parsed in one pass, each element dispatched through the
+    // compile-time field table of its response (see `XMLFieldTable`).
+    // Elements with no field in the table are skipped
+    std::expected<ListObjectsResult, Error> deserializeListObjectsResult(std::string_view body, const int maxKeys);
+    std::expected<CompactListObjectsResult, Error> deserializeCompactListObjectsResult(std::string_view body, const int maxKeys);
+    std::expected<ListAllMyBucketsResult, Error> deserializeListBucketsResult(std::string_view body, std::optional<int> maxBuckets);
+    std::expected<PutObjectResult, Error> deserializePutObjectResult(const HttpHeaders& headers);
+    std::expected<DeleteObjectResult, Error> deserializeDeleteObjectResult(const HttpHeaders& headers);
+    std::expected<CreateBucketResult, Error> deserializeCreateBucketResult(const HttpHeaders& headers);
+    std::expected<HeadBucketResult, Error> deserializeHeadBucketResult(const HttpHeaders& headers);
+    std::expected<HeadObjectResult, Error> deserializeHeadObjectResult(const HttpHeaders& headers);
+    std::expected<GetObjectResult, Error> deserializeGetObjectResult(const HttpHeaders& headers);
+    std::expected<CreateMultipartUploadResult, Error> deserializeCreateMultipartUploadResult(std::string_view body);
+    std::expected<UploadPartResult, Error> deserializeUploadPartResult(const HttpHeaders& headers);
+    std::expected<CompleteMultipartUploadResult, Error> deserializeCompleteMultipartUploadResult(std::string_view body);
+    std::expected<DeleteObjectsResult, Error> deserializeDeleteObjectsResult(std::string_view body);
+    std::expected<CopyObjectResult, Error> deserializeCopyObjectResult(std::string_view body, const HttpHeaders& headers);
+    std::expected<UploadPartCopyResult, Error> deserializeUploadPartCopyResult(std::string_view body, const HttpHeaders& headers);
+
+    Error deserializeError(std::string_view body);
 
 private:
     HttpClient Client;
@@ -69,6 +196,100 @@ private:
     XMLParser Parser;
     std::string endpoint_;
     S3AddressingStyle addressing_style_;
+    std::shared_ptr<Executor> executor_;
+    RetryOptions retry_options_;
+    std::unique_ptr<RetryBudget> retry_budget_ = std::make_unique<RetryBudget>(RetryOptions {}.RetryBudget);
+    std::shared_ptr<HttpHedging> hedging_;
+    std::unique_ptr<AdaptiveConcurrency> concurrency_;
+    RateLimits rate_limits_;
+
+    // Request builders and response parsers, shared by the sync and async calls
+    HttpRequest buildListObjectsRequest(const std::string& bucket, const ListObjectsInput& options);
+    HttpRequest buildGetObjectRequest(const std::string& bucket, const std::string& key, const GetObjectInput& options);
+    HttpBodyRequest buildPutObjectRequest(const std::string& bucket, const std::string& key, const PutObjectInput& options);
+    HttpBodyRequest buildDeleteObjectRequest(const std::string& bucket, const std::string& key, const DeleteObjectInput& options);
+    HttpRequest buildHeadObjectRequest(const std::string& bucket, const std::string& key, const HeadObjectInput& options);
+    std::expected<ListObjectsResult, Error> parseListObjectsResponse(const HttpResponse& res, const int maxKeys);
+    std::expected<std::string, Error> parseGetObjectResponse(const HttpResponse& res);
+    std::expected<GetObjectResult, Error> parseGetObjectStreamResponse(const HttpResponse& res, bool sinkStopped);
+    std::expected<PutObjectResult, Error> parsePutObjectResponse(const HttpResponse& res);
+    std::expected<DeleteObjectResult, Error> parseDeleteObjectResponse(const HttpResponse& res);
+    std::expected<HeadObjectResult, Error> parseHeadObjectResponse(const HttpResponse& res);
+    HttpBodyRequest buildUploadPartRequest(const std::string& bucket, const std::string& key, const std::string& uploadId, int partNumber, const UploadPartInput& options);
+    std::expected<UploadPartResult, Error> parseUploadPartResponse(const HttpResponse& res);
+
+    // Sign and execute, retrying as `retry_options_` says
+    HttpResponse send(HttpRequest& req);
+    HttpResponse send(HttpBodyRequest& req);
+    template <typename Request>
+    HttpResponse sendWithRetries(Request& req);
+    // The bucket and the key `url` points to, either may be empty
+    std::pair<std::string_view, std::string_view> splitURL(std::string_view url) const;
+    // The limiter of the bucket and key prefix `url` points to
+    std::shared_ptr<ConcurrencyLimiter> concurrencyLimiter(const std::string& url);
+    // The requests a second limiter of the class of the request, null if none
+    RateLimiter* requestLimiter(HttpMethod method, const std::string& url) const;
+    // Asynchronous requests take their token upfront and wait on the event
+    // loop for as long as the limiter is in debt, the caller never blocks
+    template <typename Request>
+    void delayForRateLimit(Request& req) const {
+        if (RateLimiter* limiter = requestLimiter(req.getHttpMethod(), req.getURL()))
+            req.start_after(limiter->reserve(1));
+    }
+
+    // Sends `req` and parses the XML body into `result` while it is received
+    template <typename Result, size_t N>
+    std::expected<Result, Error> sendXML(HttpRequest& req, const XMLFieldTable<Result, N>& fields, Result result);
+
+    template <typename Result, typename Request, typename Parse>
+    std::future<std::expected<Result, Error>> sendAsync(Request& req, Parse parse) {
+        auto promise = std::make_shared<std::promise<std::expected<Result, Error>>>();
+        auto future = promise->get_future();
+        delayForRateLimit(req);
+        Signer.sign(req);
+        req.execute_async([promise, parse = std::move(parse)](std::expected<HttpResponse, std::string> res) {
+            if (!res) {
+                promise->set_exception(std::make_exception_ptr(std::runtime_error(res.error())));
+                return;
+            }
+            try {
+                promise->set_value(parse(res.value()));
+            } catch (...) {
+                // i.e. the XML parser bailing out on a malformed body
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    // Suspends the coroutine until the (already signed) request completes
+    template <typename Request>
+    struct ResponseAwaiter {
+        Request& req;
+        Executor& executor;
+        std::optional<std::expected<HttpResponse, std::string>> result;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            // `this` lives in the coroutine frame, which stays alive until resumed
+            req.execute_async([this, handle](std::expected<HttpResponse, std::string> res) {
+                result.emplace(std::move(res));
+                executor.schedule(handle);
+            });
+        }
+        HttpResponse await_resume() {
+            if (!result->has_value())
+                throw std::runtime_error(result->error());
+            return std::move(result->value());
+        }
+    };
+
+    template <typename Request>
+    ResponseAwaiter<Request> sendTask(Request& req) {
+        delayForRateLimit(req);
+        Signer.sign(req);
+        return ResponseAwaiter<Request> { req, executor_ ? *executor_ : DefaultExecutor(), std::nullopt };
+    }
 
     std::string buildURL(const std::string& bucket) const {
         if (addressing_style_ == S3AddressingStyle::VirtualHosted) {
@@ -80,6 +301,9 @@ private:
         }
     }
 
+    // x-amz-copy-source value, /bucket/key[?versionId=]
+    std::string buildCopySource(const std::string& bucket, const std::string& key, const std::optional<std::string>& versionId) const;
+
     std::string getHostHeader(const std::string& bucket) const {
         if (addressing_style_ == S3AddressingStyle::VirtualHosted) {
             return std::format("{}.{}", bucket, endpoint_);
@@ -128,3 +352,103 @@ private:
     bool hasMorePages_ = true;
     std::string continuationToken_;
 };
+
+// ListObjectsPaginator that requests the next pages while the caller is busy
+// with the current one
+//
+// A background thread lists the bucket, following NextContinuationToken, and
+// stops once `depth` pages are waiting to be taken. The first request goes
+// out on construction. Pages (and S3 errors) come out of NextPage() in order,
+// transport errors are rethrown from it. Destroying the paginator stops the
+// listing, after the request in flight if any completes
+class PrefetchingListObjectsPaginator {
+public:
+    PrefetchingListObjectsPaginator(S3Client& client, const std::string& bucket, const std::string& prefix, int maxKeys = 1000, size_t depth = 2);
+    ~PrefetchingListObjectsPaginator();
+
+    PrefetchingListObjectsPaginator(const PrefetchingListObjectsPaginator&) = delete;
+    PrefetchingListObjectsPaginator& operator=(const PrefetchingListObjectsPaginator&) = delete;
+
+    // Never blocks, the page that is not here yet is known to exist
+    bool HasMorePages() const;
+    // Waits for the next page if it is still on its way. Past the last page
+    // it returns a `NoMorePages` error
+    std::expected<ListObjectsResult, Error> NextPage();
+
+private:
+    S3Client& client_;
+    std::string bucket_;
+    std::string prefix_;
+    int maxKeys_;
+    size_t depth_;
+
+    mutable std::mutex mutex_;
+    // Signaled when a page is added, and when one is taken
+    std::condition_variable ready_;
+    std::condition_variable space_;
+    std::deque<std::expected<ListObjectsResult, Error>> pages_;
+    std::exception_ptr failure_;
+    // The last page is in `pages_`, or the listing failed
+    bool done_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+
+    void run();
+};
+
+// Input range over the objects of a listing, i.e.
+//
+//     for (const Contents_& object : client.ListAll("my-bucket", "logs/"))
+//
+// Pages are fetched in the background by a PrefetchingListObjectsPaginator.
+// A range-for has no way to return an error, so failed pages throw
+// std::runtime_error with the S3 error code and message
+class ListObjectsRange {
+public:
+    class iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = Contents_;
+        using difference_type = std::ptrdiff_t;
+
+        Contents_& operator*() const { return range_->page_.Contents[range_->index_]; }
+        Contents_* operator->() const { return &**this; }
+        iterator& operator++() {
+            range_->advance();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.atEnd(); }
+
+    private:
+        friend class ListObjectsRange;
+        explicit iterator(ListObjectsRange* range)
+            : range_(range) { }
+        ListObjectsRange* range_;
+
+        bool atEnd() const { return range_->atEnd(); }
+    };
+
+    ListObjectsRange(S3Client& client, const std::string& bucket, const std::string& prefix, size_t prefetch)
+        : pages_(std::make_unique<PrefetchingListObjectsPaginator>(client, bucket, prefix, 1000, prefetch)) { }
+
+    // Single pass, begin() is to be called once
+    iterator begin() {
+        if (!started_) {
+            started_ = true;
+            advance();
+        }
+        return iterator(this);
+    }
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+    std::unique_ptr<PrefetchingListObjectsPaginator> pages_;
+    ListObjectsResult page_ {};
+    size_t index_ = 0;
+    bool started_ = false;
+
+    // Moves to the next object, through as many pages as needed (pages can be empty)
+    void advance();
+    bool atEnd() const { return index_ >= page_.Contents.size() && !pages_->HasMorePages(); }
+};
@@ -0,0 +1,238 @@
+#ifndef S3CPP_TASK
+#define S3CPP_TASK
+
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Executors decide on which thread an awaiting coroutine is resumed once its
+// request completes. Implement this to resume on your own event loop
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual void schedule(std::coroutine_handle<> handle) = 0;
+};
+
+// Resumes right away on the thread that completed the request, that is, the
+// event loop thread of the HttpClient. Only for coroutines that do not block
+class InlineExecutor : public Executor {
+public:
+    void schedule(std::coroutine_handle<> handle) override { handle.resume(); }
+};
+
+// Small built-in executor backed by a fixed number of worker threads
+class ThreadPoolExecutor : public Executor {
+public:
+    ThreadPoolExecutor(size_t threads = std::max(2u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < threads; i++)
+            workers_.emplace_back([this] { run(); });
+    }
+    ~ThreadPoolExecutor() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    void schedule(std::coroutine_handle<> handle) override {
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(handle);
+        }
+        ready_.notify_one();
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::coroutine_handle<>> queue_;
+    bool stopping_ = false;
+
+    void run() {
+        while (true) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return;
+                handle = queue_.front();
+                queue_.pop_front();
+            }
+            handle.resume();
+        }
+    }
+};
+
+// Process-wide executor used when a client has none set
+inline Executor& DefaultExecutor() {
+    static ThreadPoolExecutor executor;
+    return executor;
+}
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+// Once the task finishes, resume whoever was awaiting it (symmetric transfer)
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        if (auto continuation = handle.promise().continuation)
+            return continuation;
+        return std::noop_coroutine();
+    }
+    void await_resume() const noexcept { }
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T result() {
+        if (exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept { }
+
+    void result() {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+} // namespace detail
+
+// Lazily started coroutine, it runs once it is `co_await`-ed (or `sync_wait`-ed)
+//
+// Note: the coroutine frame keeps copies of the arguments, never references,
+// since the call site may be long gone by the time the task starts
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : handle_(handle) { }
+    ~Task() {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task(Task&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) { }
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter { handle_ };
+    }
+    auto operator co_await() & noexcept { return std::move(*this).operator co_await(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T> { std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void> { std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+}
+
+// Eagerly started and self-destroying, only used to bridge into `sync_wait`
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+template <typename T>
+Detached runInto(Task<T> task, std::promise<T>& out) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await std::move(task);
+            out.set_value();
+        } else {
+            out.set_value(co_await std::move(task));
+        }
+    } catch (...) {
+        out.set_exception(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+// Block the calling thread until the task completes, i.e. from `main()`
+template <typename T>
+T sync_wait(Task<T> task) {
+    std::promise<T> out;
+    std::future<T> future = out.get_future();
+    detail::runInto(std::move(task), out);
+    return future.get();
+}
+
+#endif
@@ -0,0 +1,579 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <s3cpp/transfer.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// S3 does not accept more parts than this for a single upload
+constexpr uint64_t MaxPartsPerUpload = 10000;
+// nor more keys than this on a single DeleteObjects
+constexpr size_t MaxKeysPerDelete = 1000;
+// nor copies bigger than this with a single CopyObject
+constexpr uint64_t MaxCopyObjectSize = 5ull * 1024 * 1024 * 1024;
+
+// Sends one part of a multipart upload, given the id of the upload
+using PartUpload = std::function<std::expected<CompletedPart, Error>(const std::string& uploadId)>;
+// Called under a lock, returns std::nullopt once there are no parts left
+using PartUploads = std::function<std::expected<std::optional<PartUpload>, Error>()>;
+
+// UploadPartResult and UploadPartCopyResult alike
+template <typename Result>
+CompletedPart completedPart(int number, Result& res) {
+    return CompletedPart {
+        .PartNumber = number,
+        .ETag = std::move(res.ETag),
+        .ChecksumCRC32 = std::move(res.ChecksumCRC32),
+        .ChecksumCRC32C = std::move(res.ChecksumCRC32C),
+        .ChecksumSHA1 = std::move(res.ChecksumSHA1),
+        .ChecksumSHA256 = std::move(res.ChecksumSHA256),
+    };
+}
+
+// Creates a multipart upload, sends the parts from `next` with `workers`
+// threads and completes it. On any failure the upload is aborted, S3 errors
+// come back as `Error` and transport errors are rethrown
+std::expected<CompleteMultipartUploadResult, Error> runMultipartUpload(S3Client& client, const std::string& bucket, const std::string& key, const CreateMultipartUploadInput& options, size_t workers, const PartUploads& next) {
+    auto created = client.CreateMultipartUpload(bucket, key, options);
+    if (!created)
+        return std::unexpected<Error>(created.error());
+    const std::string uploadId = created->UploadId;
+
+    // guards the reader and everything below
+    std::mutex mutex;
+    std::vector<CompletedPart> completed;
+    std::optional<Error> failure;
+    std::exception_ptr exception;
+
+    auto worker = [&] {
+        while (true) {
+            PartUpload upload;
+            {
+                std::lock_guard lock(mutex);
+                if (failure || exception)
+                    return;
+                auto nextPart = next();
+                if (!nextPart) {
+                    failure = nextPart.error();
+                    return;
+                }
+                if (!nextPart->has_value())
+                    return;
+                upload = std::move(nextPart->value());
+            }
+
+            try {
+                auto res = upload(uploadId);
+                std::lock_guard lock(mutex);
+                if (!res) {
+                    if (!failure)
+                        failure = res.error();
+                    return;
+                }
+                completed.push_back(std::move(*res));
+            } catch (...) {
+                std::lock_guard lock(mutex);
+                if (!exception)
+                    exception = std::current_exception();
+                return;
+            }
+        }
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    std::expected<CompleteMultipartUploadResult, Error> result = std::unexpected<Error>(Error {});
+    if (!failure && !exception) {
+        // S3 wants the parts in ascending order
+        std::sort(completed.begin(), completed.end(), [](const CompletedPart& a, const CompletedPart& b) {
+            return a.PartNumber < b.PartNumber;
+        });
+        try {
+            result = client.CompleteMultipartUpload(bucket, key, uploadId, completed);
+            if (result)
+                return result;
+        } catch (...) {
+            exception = std::current_exception();
+        }
+    }
+
+    // Do not leave the parts behind, they are billed until aborted
+    try {
+        client.AbortMultipartUpload(bucket, key, uploadId);
+    } catch (const std::exception&) {
+        // best effort, the original error is the one that matters
+    }
+
+    if (exception)
+        std::rethrow_exception(exception);
+    if (failure)
+        return std::unexpected<Error>(*failure);
+    return result;
+}
+
+} // namespace
+
+std::expected<CompleteMultipartUploadResult, Error> MultipartUploader::UploadFile(const std::string& bucket, const std::string& key, const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidFile", .Message = std::format("Could not open {}: {}", path, std::strerror(errno)) });
+    try {
+        auto res = Upload(bucket, key, fd);
+        ::close(fd);
+        return res;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+std::expected<CompleteMultipartUploadResult, Error> MultipartUploader::Upload(const std::string& bucket, const std::string& key, int fd) {
+    struct stat st;
+    off_t start = ::lseek(fd, 0, SEEK_CUR);
+    if (::fstat(fd, &st) != 0 || start < 0 || !S_ISREG(st.st_mode))
+        return std::unexpected<Error>(Error { .Code = "InvalidFile", .Message = "MultipartUploader needs a seekable regular file descriptor" });
+    if (options_.PartSize == 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidArgument", .Message = "PartSize must be greater than 0" });
+
+    const uint64_t size = st.st_size - start;
+    const uint64_t partSize = std::max(options_.PartSize, (size + MaxPartsPerUpload - 1) / MaxPartsPerUpload);
+    // an empty file is still uploaded as one (empty) part
+    const uint64_t parts = std::max<uint64_t>(1, (size + partSize - 1) / partSize);
+
+    uint64_t nextPart = 0;
+    PartReader next = [&]() -> std::expected<std::optional<Part>, Error> {
+        if (nextPart == parts)
+            return std::nullopt;
+        uint64_t offset = nextPart * partSize;
+        nextPart++;
+        return Part { .Number = static_cast<int>(nextPart), .Size = std::min(partSize, size - offset), .Offset = start + offset };
+    };
+    return run(bucket, key, fd, std::min<uint64_t>(options_.Concurrency, parts), std::move(next));
+}
+
+std::expected<CompleteMultipartUploadResult, Error> MultipartUploader::Upload(const std::string& bucket, const std::string& key, HttpBodySource source) {
+    if (options_.PartSize == 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidArgument", .Message = "PartSize must be greater than 0" });
+
+    int nextPart = 0;
+    bool exhausted = false;
+    PartReader next = [&]() -> std::expected<std::optional<Part>, Error> {
+        if (exhausted)
+            return std::nullopt;
+
+        std::string buffer(options_.PartSize, '\0');
+        size_t filled = 0;
+        while (filled < buffer.size()) {
+            std::ptrdiff_t read = source(buffer.data() + filled, buffer.size() - filled);
+            if (read < 0)
+                return std::unexpected<Error>(Error { .Code = "InvalidInput", .Message = "The body source failed while reading a part" });
+            if (read == 0) {
+                exhausted = true;
+                break;
+            }
+            filled += read;
+        }
+        // the input ended right at a part boundary, unless it was empty
+        if (filled == 0 && nextPart > 0)
+            return std::nullopt;
+        // better to stop here than to upload all of it and fail on Complete
+        if (static_cast<uint64_t>(nextPart) == MaxPartsPerUpload)
+            return std::unexpected<Error>(Error { .Code = "InvalidArgument", .Message = std::format("The input does not fit in {} parts of {} bytes", MaxPartsPerUpload, options_.PartSize) });
+
+        buffer.resize(filled);
+        nextPart++;
+        return Part { .Number = nextPart, .Size = filled, .Buffer = std::move(buffer) };
+    };
+    return run(bucket, key, -1, std::max<size_t>(1, options_.Concurrency), std::move(next));
+}
+
+std::expected<CompleteMultipartUploadResult, Error> MultipartUploader::run(const std::string& bucket, const std::string& key, int fd, size_t workers, PartReader next) {
+    PartUploads uploads = [&]() -> std::expected<std::optional<PartUpload>, Error> {
+        auto part = next();
+        if (!part)
+            return std::unexpected<Error>(part.error());
+        if (!part->has_value())
+            return std::nullopt;
+        return [this, &bucket, &key, fd, part = std::move(part->value())](const std::string& uploadId) -> std::expected<CompletedPart, Error> {
+            auto res = uploadPart(bucket, key, uploadId, fd, part);
+            if (!res)
+                return std::unexpected<Error>(res.error());
+            return completedPart(part.Number, *res);
+        };
+    };
+    return runMultipartUpload(client_, bucket, key, options_.CreateOptions, workers, uploads);
+}
+
+std::expected<UploadPartResult, Error> MultipartUploader::uploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int fd, const Part& part) {
+    uint64_t offset = 0;
+    HttpBodySource source = [&](char* buffer, size_t size) -> std::ptrdiff_t {
+        size = std::min<uint64_t>(size, part.Size - offset);
+        if (part.Buffer) {
+            std::memcpy(buffer, part.Buffer->data() + offset, size);
+            offset += size;
+            return size;
+        }
+        while (true) {
+            ssize_t n = ::pread(fd, buffer, size, part.Offset + offset);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n > 0)
+                offset += n;
+            return n;
+        }
+    };
+    // every attempt of the client reads the part from its start again
+    HttpBodyRewind rewind = [&offset] {
+        offset = 0;
+        return true;
+    };
+    return client_.UploadPart(bucket, key, uploadId, part.Number, std::move(source), part.Size, std::move(rewind));
+}
+
+std::expected<HeadObjectResult, Error> ParallelDownloader::DownloadFile(const std::string& bucket, const std::string& key, const std::string& path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidFile", .Message = std::format("Could not open {}: {}", path, std::strerror(errno)) });
+    try {
+        auto res = Download(bucket, key, fd);
+        ::close(fd);
+        return res;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+std::expected<HeadObjectResult, Error> ParallelDownloader::Download(const std::string& bucket, const std::string& key, int fd) {
+    off_t base = ::lseek(fd, 0, SEEK_CUR);
+    if (base < 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidFile", .Message = "ParallelDownloader needs a seekable file descriptor" });
+
+    auto head = client_.HeadObject(bucket, key);
+    if (!head)
+        return std::unexpected<Error>(head.error());
+
+    return run(bucket, key, *head, [fd, base](uint64_t offset, std::string_view chunk) {
+        // pwrite(2) may take less than the whole chunk
+        while (!chunk.empty()) {
+            ssize_t written = ::pwrite(fd, chunk.data(), chunk.size(), base + offset);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            chunk.remove_prefix(written);
+            offset += written;
+        }
+        return true;
+    });
+}
+
+std::expected<HeadObjectResult, Error> ParallelDownloader::DownloadInto(const std::string& bucket, const std::string& key, std::span<std::byte> buffer) {
+    auto head = client_.HeadObject(bucket, key);
+    if (!head)
+        return std::unexpected<Error>(head.error());
+    if (static_cast<uint64_t>(head->ContentLength) > buffer.size())
+        return std::unexpected<Error>(Error { .Code = "BufferTooSmall", .Message = std::format("The object does not fit in a buffer of {} bytes", buffer.size()) });
+
+    // ranges never overlap, so workers can write concurrently
+    return run(bucket, key, *head, [buffer](uint64_t offset, std::string_view chunk) {
+        std::memcpy(buffer.data() + offset, chunk.data(), chunk.size());
+        return true;
+    });
+}
+
+std::expected<HeadObjectResult, Error> ParallelDownloader::run(const std::string& bucket, const std::string& key, const HeadObjectResult& head, const RangeWriter& write) {
+    if (options_.PartSize == 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidArgument", .Message = "PartSize must be greater than 0" });
+
+    const uint64_t size = head.ContentLength;
+    const uint64_t ranges = (size + options_.PartSize - 1) / options_.PartSize;
+
+    // guards everything below
+    std::mutex mutex;
+    uint64_t nextRange = 0;
+    std::optional<Error> failure;
+    std::exception_ptr exception;
+
+    auto worker = [&] {
+        while (true) {
+            uint64_t start;
+            {
+                std::lock_guard lock(mutex);
+                if (failure || exception || nextRange == ranges)
+                    return;
+                start = nextRange * options_.PartSize;
+                nextRange++;
+            }
+
+            try {
+                auto res = downloadRange(bucket, key, head.ETag, start, std::min(options_.PartSize, size - start), write);
+                if (!res) {
+                    std::lock_guard lock(mutex);
+                    if (!failure)
+                        failure = res.error();
+                    return;
+                }
+            } catch (...) {
+                std::lock_guard lock(mutex);
+                if (!exception)
+                    exception = std::current_exception();
+                return;
+            }
+        }
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<uint64_t>(options_.Concurrency, ranges); i++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    if (exception)
+        std::rethrow_exception(exception);
+    if (failure)
+        return std::unexpected<Error>(*failure);
+    return head;
+}
+
+std::expected<void, Error> ParallelDownloader::downloadRange(const std::string& bucket, const std::string& key, const std::string& etag, uint64_t start, uint64_t size, const RangeWriter& write) {
+    GetObjectInput options;
+    if (!etag.empty())
+        options.If_Match = etag;
+    options.Range = std::format("bytes={}-{}", start, start + size - 1);
+
+    const RetryOptions& retry = client_.GetRetryOptions();
+    RetryBudget& budget = client_.GetRetryBudget();
+    RetryBackoff backoff(retry.BaseDelay, retry.MaxDelay);
+    size_t spent = 0;
+    for (int attempt = 1;; attempt++) {
+        // writes are positional, a restart writes the range over from its start
+        uint64_t received = 0;
+        bool outOfRange = false;
+        bool writeFailed = false;
+        auto sink = [&](std::string_view chunk) {
+            if (chunk.size() > size - received) {
+                outOfRange = true;
+                return false;
+            }
+            if (!write(start + received, chunk)) {
+                writeFailed = true;
+                return false;
+            }
+            received += chunk.size();
+            return true;
+        };
+
+        std::expected<GetObjectResult, Error> res;
+        RetryCause cause = RetryCause::Transport;
+        std::exception_ptr failure;
+        try {
+            res = client_.GetObject(bucket, key, sink, options);
+        } catch (const HttpTransportError& error) {
+            // The client retries everything but a body cut short once the
+            // sink has seen it, which only a range can start over
+            const bool delivered = error.status() >= 200 && error.status() < 300;
+            cause = delivered ? retryCause(error.code(), true) : RetryCause::None;
+            failure = std::current_exception();
+        }
+
+        if (writeFailed)
+            return std::unexpected<Error>(Error { .Code = "WriteFailed", .Message = std::format("Could not write the range at offset {}", start) });
+        if (outOfRange)
+            return std::unexpected<Error>(Error { .Code = "InvalidRange", .Message = std::format("Got more than the {} bytes asked for at offset {}", size, start) });
+        if (!failure && !res)
+            return std::unexpected<Error>(res.error());
+        if (!failure && received == size) {
+            // as for the client, a healthy range gives the retries back
+            if (spent > 0)
+                budget.release(spent);
+            return {};
+        }
+
+        const size_t cost = cause == RetryCause::Timeout ? retry.TimeoutCost : retry.RetryCost;
+        if (cause == RetryCause::None || attempt >= options_.MaxAttempts || !budget.acquire(cost)) {
+            if (failure)
+                std::rethrow_exception(failure);
+            return std::unexpected<Error>(Error { .Code = "IncompleteBody", .Message = std::format("Got {} of {} bytes at offset {}", received, size, start) });
+        }
+        spent = cost;
+        std::this_thread::sleep_for(backoff.next());
+    }
+}
+
+std::expected<CopyObjectResult, Error> MultipartCopier::Copy(const std::string& sourceBucket, const std::string& sourceKey, const std::string& bucket, const std::string& key) {
+    if (options_.PartSize == 0)
+        return std::unexpected<Error>(Error { .Code = "InvalidArgument", .Message = "PartSize must be greater than 0" });
+
+    auto head = client_.HeadObject(sourceBucket, sourceKey);
+    if (!head)
+        return std::unexpected<Error>(head.error());
+
+    const uint64_t size = head->ContentLength;
+    if (size <= std::min(options_.MultipartThreshold, MaxCopyObjectSize)) {
+        CopyObjectInput copyOptions;
+        if (!head->ETag.empty())
+            copyOptions.CopySourceIfMatch = head->ETag;
+        return client_.CopyObject(sourceBucket, sourceKey, bucket, key, copyOptions);
+    }
+
+    // a multipart upload starts without metadata, carry over what CopyObject would
+    CreateMultipartUploadInput createOptions = options_.CreateOptions;
+    auto inherit = [](std::optional<std::string>& option, const std::string& value) {
+        if (!option && !value.empty())
+            option = value;
+    };
+    inherit(createOptions.ContentType, head->ContentType);
+    inherit(createOptions.CacheControl, head->CacheControl);
+    inherit(createOptions.ContentDisposition, head->ContentDisposition);
+    inherit(createOptions.ContentEncoding, head->ContentEncoding);
+    inherit(createOptions.ContentLanguage, head->ContentLanguage);
+    inherit(createOptions.Expires, head->Expires);
+
+    const uint64_t partSize = std::max(options_.PartSize, (size + MaxPartsPerUpload - 1) / MaxPartsPerUpload);
+    const uint64_t parts = (size + partSize - 1) / partSize;
+
+    uint64_t nextPart = 0;
+    PartUploads uploads = [&]() -> std::expected<std::optional<PartUpload>, Error> {
+        if (nextPart == parts)
+            return std::nullopt;
+        UploadPartCopyInput partOptions;
+        if (!head->ETag.empty())
+            partOptions.CopySourceIfMatch = head->ETag;
+        const uint64_t start = nextPart * partSize;
+        partOptions.CopySourceRange = std::format("bytes={}-{}", start, std::min(start + partSize, size) - 1);
+        const int number = static_cast<int>(++nextPart);
+
+        return [&, number, partOptions](const std::string& uploadId) -> std::expected<CompletedPart, Error> {
+            auto res = client_.UploadPartCopy(bucket, key, uploadId, number, sourceBucket, sourceKey, partOptions);
+            if (!res)
+                return std::unexpected<Error>(res.error());
+            return completedPart(number, *res);
+        };
+    };
+    auto result = runMultipartUpload(client_, bucket, key, createOptions, std::min<uint64_t>(options_.Concurrency, parts), uploads);
+    if (!result)
+        return std::unexpected<Error>(result.error());
+    return CopyObjectResult {
+        .ETag = std::move(result->ETag),
+        .ChecksumCRC32 = std::move(result->ChecksumCRC32),
+        .ChecksumCRC32C = std::move(result->ChecksumCRC32C),
+        .ChecksumSHA1 = std::move(result->ChecksumSHA1),
+        .ChecksumSHA256 = std::move(result->ChecksumSHA256),
+        .ChecksumType = std::move(result->ChecksumType),
+        .CopySourceVersionId = head->VersionId,
+    };
+}
+
+std::expected<BatchDeleteResult, Error> BatchDeleter::Delete(const std::string& bucket, std::span<const std::string> keys) {
+    size_t offset = 0;
+    BatchReader next = [&]() -> std::expected<std::vector<std::string>, Error> {
+        size_t count = std::min(MaxKeysPerDelete, keys.size() - offset);
+        std::vector<std::string> batch(keys.begin() + offset, keys.begin() + offset + count);
+        offset += count;
+        return batch;
+    };
+    return run(bucket, std::move(next));
+}
+
+std::expected<BatchDeleteResult, Error> BatchDeleter::DeletePrefix(const std::string& bucket, const std::string& prefix) {
+    ListObjectsPaginator paginator(client_, bucket, prefix, MaxKeysPerDelete);
+    BatchReader next = [&]() -> std::expected<std::vector<std::string>, Error> {
+        std::vector<std::string> batch;
+        // an empty page may still be followed by more pages
+        while (batch.empty() && paginator.HasMorePages()) {
+            auto page = paginator.NextPage();
+            if (!page)
+                return std::unexpected<Error>(page.error());
+            for (auto& object : page->Contents)
+                batch.push_back(std::move(object.Key));
+        }
+        return batch;
+    };
+    return run(bucket, std::move(next));
+}
+
+std::expected<BatchDeleteResult, Error> BatchDeleter::run(const std::string& bucket, BatchReader next) {
+    // guards the reader and everything below
+    std::mutex mutex;
+    BatchDeleteResult result;
+    std::optional<Error> failure;
+    std::exception_ptr exception;
+
+    auto worker = [&] {
+        while (true) {
+            std::vector<std::string> batch;
+            {
+                std::lock_guard lock(mutex);
+                if (failure || exception)
+                    return;
+                auto nextBatch = next();
+                if (!nextBatch) {
+                    failure = nextBatch.error();
+                    return;
+                }
+                if (nextBatch->empty())
+                    return;
+                batch = std::move(nextBatch.value());
+            }
+
+            try {
+                auto res = deleteBatch(bucket, std::move(batch));
+                std::lock_guard lock(mutex);
+                if (!res) {
+                    if (!failure)
+                        failure = res.error();
+                    return;
+                }
+                result.Deleted += res->Deleted;
+                std::move(res->Errors.begin(), res->Errors.end(), std::back_inserter(result.Errors));
+            } catch (...) {
+                std::lock_guard lock(mutex);
+                if (!exception)
+                    exception = std::current_exception();
+                return;
+            }
+        }
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < options_.Concurrency; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    if (exception)
+        std::rethrow_exception(exception);
+    if (failure)
+        return std::unexpected<Error>(*failure);
+    return result;
+}
+
+std::expected<BatchDeleteResult, Error> BatchDeleter::deleteBatch(const std::string& bucket, std::vector<std::string> keys) {
+    // only the failures are of interest
+    auto res = client_.DeleteObjects(bucket, keys, { .Quiet = true });
+    if (!res)
+        return std::unexpected<Error>(res.error());
+    return BatchDeleteResult { .Deleted = keys.size() - res->Errors.size(), .Errors = std::move(res->Errors) };
+}
@@ -0,0 +1,202 @@
+#ifndef S3CPP_TRANSFER
+#define S3CPP_TRANSFER
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <s3cpp/s3.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct MultipartUploadOptions {
+    // Size of every part but the last one. S3 wants at least 5 MiB and at
+    // most 10000 parts, for known sizes it is grown to stay under that limit
+    uint64_t PartSize = 8 * 1024 * 1024;
+    // Parts in flight at once, each one on its own connection. Keep it within
+    // `HttpClientOptions::max_connections_per_host` of the client
+    size_t Concurrency = 8;
+    CreateMultipartUploadInput CreateOptions;
+};
+
+// Parallel multipart upload on top of S3Client
+//
+// The input is split in parts that `Concurrency` workers upload at the same
+// time. Every part is retried by the client as any other request (see
+// `S3Client::SetRetryOptions()`), and once a part fails for good the upload
+// is aborted so no orphan parts are left behind.
+//
+// As with S3Client, S3 errors come back as `Error` and transport errors are
+// thrown (after the upload has been aborted)
+class MultipartUploader {
+public:
+    MultipartUploader(S3Client& client)
+        : client_(client) { }
+    MultipartUploader(S3Client& client, const MultipartUploadOptions& options)
+        : client_(client)
+        , options_(options) { }
+
+    std::expected<CompleteMultipartUploadResult, Error> UploadFile(const std::string& bucket, const std::string& key, const std::string& path);
+    // Uploads from the current offset of `fd` to the end of the file, parts
+    // are read with pread(2) so nothing is buffered in memory
+    std::expected<CompleteMultipartUploadResult, Error> Upload(const std::string& bucket, const std::string& key, int fd);
+    // Sequential input of unknown length, i.e. a pipe or a compressor. Up to
+    // `Concurrency` parts are held in memory at once. S3 takes 10000 parts at
+    // most, larger inputs (over 78 GiB with the default `PartSize`) fail with
+    // `InvalidArgument` and the upload is aborted
+    std::expected<CompleteMultipartUploadResult, Error> Upload(const std::string& bucket, const std::string& key, HttpBodySource source);
+
+private:
+    S3Client& client_;
+    MultipartUploadOptions options_;
+
+    struct Part {
+        int Number;
+        uint64_t Size;
+        // where the part starts in the file, or the part itself for sequential inputs
+        uint64_t Offset = 0;
+        std::optional<std::string> Buffer;
+    };
+    // Called under a lock, returns std::nullopt once the input is exhausted
+    using PartReader = std::function<std::expected<std::optional<Part>, Error>()>;
+
+    std::expected<CompleteMultipartUploadResult, Error> run(const std::string& bucket, const std::string& key, int fd, size_t workers, PartReader next);
+    std::expected<UploadPartResult, Error> uploadPart(const std::string& bucket, const std::string& key, const std::string& uploadId, int fd, const Part& part);
+};
+
+struct ParallelDownloadOptions {
+    // Size of every byte range but the last one
+    uint64_t PartSize = 8 * 1024 * 1024;
+    // Ranges in flight at once, each one on its own connection. Keep it within
+    // `HttpClientOptions::max_connections_per_host` of the client
+    size_t Concurrency = 8;
+    // Attempts per range, the first one included. A range whose body is cut
+    // short is fetched again from its start, with the backoff and the retry
+    // budget of the client. 1 turns it off
+    int MaxAttempts = 3;
+};
+
+// Parallel ranged download on top of S3Client
+//
+// The object size is taken from a HeadObject, then the object is split in
+// byte ranges that `Concurrency` workers fetch at the same time. Every range
+// is written in place (pwrite(2) or straight into the caller's buffer), so no
+// reassembly happens. Ranges are pinned to the ETag of the HeadObject, an
+// object overwritten mid-download fails with `PreconditionFailed` instead of
+// mixing two versions.
+//
+// Failed requests are retried by the client as any other request (see
+// `S3Client::SetRetryOptions()`). The client cannot take back a body it
+// already handed over, so a range cut short mid-body (connection reset, short
+// read) is restarted here, up to `MaxAttempts` times.
+//
+// As with S3Client, S3 errors come back as `Error` and transport errors are thrown
+class ParallelDownloader {
+public:
+    ParallelDownloader(S3Client& client)
+        : client_(client) { }
+    ParallelDownloader(S3Client& client, const ParallelDownloadOptions& options)
+        : client_(client)
+        , options_(options) { }
+
+    // Creates (or truncates) the file at `path`
+    std::expected<HeadObjectResult, Error> DownloadFile(const std::string& bucket, const std::string& key, const std::string& path);
+    // Written from the current offset of `fd` on, which is left untouched
+    std::expected<HeadObjectResult, Error> Download(const std::string& bucket, const std::string& key, int fd);
+    // Fails with `BufferTooSmall` before fetching anything if the object does not fit
+    std::expected<HeadObjectResult, Error> DownloadInto(const std::string& bucket, const std::string& key, std::span<std::byte> buffer);
+
+private:
+    S3Client& client_;
+    ParallelDownloadOptions options_;
+
+    // Receives a chunk of the object along with its offset from the start of the object
+    using RangeWriter = std::function<bool(uint64_t offset, std::string_view chunk)>;
+
+    std::expected<HeadObjectResult, Error> run(const std::string& bucket, const std::string& key, const HeadObjectResult& head, const RangeWriter& write);
+    std::expected<void, Error> downloadRange(const std::string& bucket, const std::string& key, const std::string& etag, uint64_t start, uint64_t size, const RangeWriter& write);
+};
+
+struct MultipartCopyOptions {
+    // Sources up to this size are copied with a single CopyObject. S3 does not
+    // copy more than 5 GiB at once, so it is capped there
+    uint64_t MultipartThreshold = 5ull * 1024 * 1024 * 1024;
+    // Size of every copied range but the last one, grown to stay under 10000 parts
+    uint64_t PartSize = 128 * 1024 * 1024;
+    // UploadPartCopy requests in flight at once. No data goes through the
+    // client, so this is only bounded by the connection limit of the client
+    size_t Concurrency = 16;
+    // Unset content headers are taken from the source object, as a plain
+    // CopyObject would do
+    CreateMultipartUploadInput CreateOptions;
+};
+
+// Server-side copy of objects of any size on top of S3Client
+//
+// Small objects are copied with CopyObject. Larger ones are copied with a
+// multipart upload whose parts are UploadPartCopy ranges of the source, issued
+// by `Concurrency` workers at the same time. Either way the bytes never leave
+// S3. Ranges are pinned to the ETag of the source, so a source overwritten
+// mid-copy fails with `PreconditionFailed` instead of mixing two versions.
+//
+// As with S3Client, S3 errors come back as `Error` and transport errors are
+// thrown (after the upload has been aborted)
+class MultipartCopier {
+public:
+    MultipartCopier(S3Client& client)
+        : client_(client) { }
+    MultipartCopier(S3Client& client, const MultipartCopyOptions& options)
+        : client_(client)
+        , options_(options) { }
+
+    std::expected<CopyObjectResult, Error> Copy(const std::string& sourceBucket, const std::string& sourceKey, const std::string& bucket, const std::string& key);
+
+private:
+    S3Client& client_;
+    MultipartCopyOptions options_;
+};
+
+struct BatchDeleteOptions {
+    // DeleteObjects requests in flight at once, each one for up to 1000 keys
+    size_t Concurrency = 4;
+};
+
+struct BatchDeleteResult {
+    uint64_t Deleted = 0;
+    // Keys that could not be deleted, i.e. AccessDenied. Per-key errors are not
+    // retried, keys failing with InternalError or SlowDown can be sent again
+    std::vector<DeleteError> Errors;
+};
+
+// Deletes keys in batches of 1000 with concurrent DeleteObjects requests
+//
+// Per-key failures do not stop the batch, they are collected in
+// `BatchDeleteResult::Errors`. A failing request (i.e. NoSuchBucket) stops
+// everything and is returned as `Error`
+class BatchDeleter {
+public:
+    BatchDeleter(S3Client& client)
+        : client_(client) { }
+    BatchDeleter(S3Client& client, const BatchDeleteOptions& options)
+        : client_(client)
+        , options_(options) { }
+
+    std::expected<BatchDeleteResult, Error> Delete(const std::string& bucket, std::span<const std::string> keys);
+    // Every key under `prefix`, or the whole bucket when empty. Pages from the
+    // listing are deleted while the next ones are being listed
+    std::expected<BatchDeleteResult, Error> DeletePrefix(const std::string& bucket, const std::string& prefix);
+
+private:
+    S3Client& client_;
+    BatchDeleteOptions options_;
+
+    // Called under a lock, returns an empty batch once there are no keys left
+    using BatchReader = std::function<std::expected<std::vector<std::string>, Error>()>;
+
+    std::expected<BatchDeleteResult, Error> run(const std::string& bucket, BatchReader next);
+    std::expected<BatchDeleteResult, Error> deleteBatch(const std::string& bucket, std::vector<std::string> keys);
+};
+
+#endif
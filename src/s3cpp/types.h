@@ -1,6 +1,9 @@
+#include <chrono>
 #include <cstdint>
 #include <optional>
+#include <s3cpp/arena.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 enum class S3AddressingStyle {
@@ -58,6 +61,49 @@ struct GetObjectInput {
     std::optional<std::string> response_content_type;
     std::optional<std::string> response_expires;
     std::optional<std::string> versionId;
+    // "ENABLED" has S3 send the full object checksum, which is then checked
+    // against the body for CRC32C and CRC64NVME
+    std::optional<std::string> CheckSumMode;
+};
+
+// Query parameters signed into a presigned GetObject URL, headers such as
+// Range are up to whoever uses the URL
+struct PresignGetObjectInput {
+    std::optional<std::string> response_cache_control;
+    std::optional<std::string> response_content_disposition;
+    std::optional<std::string> response_content_encoding;
+    std::optional<std::string> response_content_language;
+    std::optional<std::string> response_content_type;
+    std::optional<std::string> response_expires;
+    std::optional<std::string> versionId;
+};
+
+struct PresignHeadObjectInput {
+    std::optional<std::string> versionId;
+};
+
+// Metadata of a streamed GetObject, the body went to the caller's sink
+struct GetObjectResult {
+    std::string AcceptRanges;
+    std::string CacheControl;
+    std::string ContentDisposition;
+    std::string ContentEncoding;
+    std::string ContentLanguage;
+    int64_t ContentLength;
+    std::string ContentRange;
+    std::string ContentType;
+    std::string ChecksumCRC32;
+    std::string ChecksumCRC32C;
+    std::string ChecksumCRC64NVME;
+    std::string ChecksumSHA1;
+    std::string ChecksumSHA256;
+    std::string ChecksumType;
+    std::string ETag;
+    std::string Expires;
+    std::string LastModified;
+    int PartsCount;
+    std::string StorageClass;
+    std::string VersionId;
 };
 
 struct ListObjectsResult {
@@ -77,6 +123,56 @@ struct ListObjectsResult {
     std::string StartAfter;
 };
 
+// What objects of a listing tend to have in common. Every distinct
+// combination is stored once per page and objects refer to it by index
+struct ObjectAttributes {
+    std::string_view StorageClass;
+    std::string_view OwnerID;
+    std::string_view OwnerDisplayName;
+    std::string_view ChecksumAlgorithm;
+    std::string_view ChecksumType;
+    bool IsRestoreInProgress = false;
+    std::string_view RestoreExpiryDate;
+
+    bool operator==(const ObjectAttributes&) const = default;
+};
+
+// ListObjectsResult laid out by columns, for holding very large listings in
+// memory. Object `i` is made of the i-th entry of every per-object vector
+//
+// Strings are views into `Arena`, which the result owns: it is move-only and
+// the views stay valid until it is destroyed. LastModified is parsed to a
+// time point, Size and LastModified take 8 bytes per object each
+struct CompactListObjectsResult {
+    bool IsTruncated = false;
+    std::string_view Marker;
+    std::string_view NextMarker;
+    std::string_view Name;
+    std::string_view Prefix;
+    std::string_view Delimiter;
+    int MaxKeys = 0;
+    std::string_view EncodingType;
+    int KeyCount = 0;
+    std::string_view ContinuationToken;
+    std::string_view NextContinuationToken;
+    std::string_view StartAfter;
+
+    // Per object
+    std::vector<std::string_view> Keys;
+    std::vector<std::string_view> ETags;
+    std::vector<int64_t> Sizes;
+    std::vector<std::chrono::sys_time<std::chrono::milliseconds>> LastModified;
+    std::vector<uint32_t> AttributeIndexes;
+
+    // Distinct attributes of the page, see `attributes()`
+    std::vector<ObjectAttributes> Attributes;
+    std::vector<std::string_view> CommonPrefixes;
+    StringArena Arena;
+
+    size_t size() const { return Keys.size(); }
+    const ObjectAttributes& attributes(size_t i) const { return Attributes[AttributeIndexes[i]]; }
+};
+
 struct ListBucketsInput {
     std::optional<std::string> BucketRegion;
     std::optional<std::string> ContinuationToken;
@@ -122,6 +218,8 @@ struct PutObjectInput {
     std::optional<std::string> ChecksumCRC64NVME;
     std::optional<std::string> ChecksumSHA1;
     std::optional<std::string> ChecksumSHA256;
+    // "CRC32C" or "CRC64NVME" with no value above has the client compute it,
+    // upfront for in-memory bodies and as an aws-chunked trailer for streamed ones
     std::optional<std::string> SDKChecksumAlgorithm;
     std::optional<std::string> ServerSideEncryption;
     std::optional<std::string> SSEKMSKeyId;
@@ -212,6 +310,41 @@ struct DeleteObjectResult {
     std::string DeleteMarker;
 };
 
+// DeleteObjects
+// https://docs.aws.amazon.com/AmazonS3/latest/API/API_DeleteObjects.html
+struct ObjectIdentifier {
+    std::string Key;
+    std::optional<std::string> VersionId;
+};
+
+struct DeleteObjectsInput {
+    // Only report the keys that could not be deleted
+    std::optional<bool> Quiet;
+    std::optional<std::string> MFA;
+    std::optional<std::string> RequestPayer;
+    std::optional<bool> BypassGovernanceRetention;
+    std::optional<std::string> ExpectedBucketOwner;
+};
+
+struct DeletedObject {
+    std::string Key;
+    std::string VersionId;
+    bool DeleteMarker = false;
+    std::string DeleteMarkerVersionId;
+};
+
+struct DeleteError {
+    std::string Key;
+    std::string VersionId;
+    std::string Code;
+    std::string Message;
+};
+
+struct DeleteObjectsResult {
+    std::vector<DeletedObject> Deleted;
+    std::vector<DeleteError> Errors;
+};
+
 struct DeleteBucketInput {
     std::optional<std::string> ExpectedBucketOwner;
 };
@@ -290,6 +423,143 @@ struct HeadObjectInput {
     std::optional<std::string> SideEncryptionCustomerKeyMD5;
 };
 
+// CopyObject
+// https://docs.aws.amazon.com/AmazonS3/latest/API/API_CopyObject.html
+struct CopyObjectInput {
+    std::optional<std::string> SourceVersionId;
+    std::optional<std::string> CopySourceIfMatch;
+    std::optional<std::string> CopySourceIfModifiedSince;
+    std::optional<std::string> CopySourceIfNoneMatch;
+    std::optional<std::string> CopySourceIfUnmodifiedSince;
+    std::optional<std::string> ACL;
+    std::optional<std::string> CacheControl;
+    std::optional<std::string> ContentDisposition;
+    std::optional<std::string> ContentEncoding;
+    std::optional<std::string> ContentLanguage;
+    std::optional<std::string> ContentType;
+    std::optional<std::string> Expires;
+    std::optional<std::string> ChecksumAlgorithm;
+    // COPY (default) or REPLACE
+    std::optional<std::string> MetadataDirective;
+    std::optional<std::string> TaggingDirective;
+    std::optional<std::string> Tagging;
+    std::optional<std::string> ServerSideEncryption;
+    std::optional<std::string> StorageClass;
+    std::optional<std::string> ExpectedBucketOwner;
+    std::optional<std::string> ExpectedSourceBucketOwner;
+    std::optional<std::string> RequestPayer;
+};
+
+struct CopyObjectResult {
+    std::string ETag;
+    std::string LastModified;
+    std::string ChecksumCRC32;
+    std::string ChecksumCRC32C;
+    std::string ChecksumCRC64NVME;
+    std::string ChecksumSHA1;
+    std::string ChecksumSHA256;
+    std::string ChecksumType;
+    std::string VersionId;
+    std::string CopySourceVersionId;
+};
+
+// Multipart upload
+// https://docs.aws.amazon.com/AmazonS3/latest/API/API_CreateMultipartUpload.html
+struct CreateMultipartUploadInput {
+    std::optional<std::string> CacheControl;
+    std::optional<std::string> ContentDisposition;
+    std::optional<std::string> ContentEncoding;
+    std::optional<std::string> ContentLanguage;
+    std::optional<std::string> ContentType;
+    std::optional<std::string> Expires;
+    std::optional<std::string> ChecksumAlgorithm;
+    std::optional<std::string> ExpectedBucketOwner;
+    std::optional<std::string> RequestPayer;
+    std::optional<std::string> ServerSideEncryption;
+    std::optional<std::string> SSEKMSKeyId;
+    std::optional<std::string> StorageClass;
+    std::optional<std::string> Tagging;
+};
+
+struct CreateMultipartUploadResult {
+    std::string Bucket;
+    std::string Key;
+    std::string UploadId;
+};
+
+struct UploadPartInput {
+    std::optional<std::string> ContentMD5;
+    std::optional<std::string> ChecksumCRC32;
+    std::optional<std::string> ChecksumCRC32C;
+    std::optional<std::string> ChecksumSHA1;
+    std::optional<std::string> ChecksumSHA256;
+    std::optional<std::string> ExpectedBucketOwner;
+    std::optional<std::string> RequestPayer;
+};
+
+struct UploadPartResult {
+    std::string ETag;
+    std::string ChecksumCRC32;
+    std::string ChecksumCRC32C;
+    std::string ChecksumSHA1;
+    std::string ChecksumSHA256;
+    std::string ServerSideEncryption;
+};
+
+struct UploadPartCopyInput {
+    std::optional<std::string> SourceVersionId;
+    // Part of the source to copy, i.e. bytes=0-9. The whole object when unset
+    std::optional<std::string> CopySourceRange;
+    std::optional<std::string> CopySourceIfMatch;
+    std::optional<std::string> CopySourceIfModifiedSince;
+    std::optional<std::string> CopySourceIfNoneMatch;
+    std::optional<std::string> CopySourceIfUnmodifiedSince;
+    std::optional<std::string> ExpectedBucketOwner;
+    std::optional<std::string> ExpectedSourceBucketOwner;
+    std::optional<std::string> RequestPayer;
+};
+
+struct UploadPartCopyResult {
+    std::string ETag;
+    std::string LastModified;
+    std::string ChecksumCRC32;
+    std::string ChecksumCRC32C;
+    std::string ChecksumSHA1;
+    std::string ChecksumSHA256;
+    std::string CopySourceVersionId;
+};
+
+struct CompletedPart {
+    int PartNumber;
+    std::string ETag;
+    std::string ChecksumCRC32;
+    std::string ChecksumCRC32C;
+    std::string ChecksumSHA1;
+    std::string ChecksumSHA256;
+};
+
+struct CompleteMultipartUploadInput {
+    std::optional<std::string> ExpectedBucketOwner;
+    std::optional<std::string> RequestPayer;
+};
+
+struct CompleteMultipartUploadResult {
+    std::string Location;
+    std::string Bucket;
+    std::string Key;
+    std::string ETag;
+    std::string ChecksumCRC32;
+    std::string ChecksumCRC32C;
+    std::string ChecksumSHA1;
+    std::string ChecksumSHA256;
+    std::string ChecksumType;
+};
+
+struct AbortMultipartUploadInput {
+    std::optional<std::string> ExpectedBucketOwner;
+    std::optional<std::string> RequestPayer;
+};
+
 // REST generic error
 // https://docs.aws.amazon.com/AmazonS3/latest/API/ErrorResponses.html#RESTErrorResponses
 struct Error {
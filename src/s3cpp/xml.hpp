@@ -1,11 +1,74 @@
+#ifndef S3CPP_XML
+#define S3CPP_XML
+
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <charconv>
+#include <concepts>
+#include <cstdint>
 #include <format>
-#include <stack>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define S3CPP_XML_X86
+#endif
+
+// Position of the first of `Chars` in [first, last), or `last`
+//
+// Looking for the next delimiter is most of the time spent on a listing, so
+// it goes 16 bytes at a time with SSE2, 32 with AVX2 when the CPU has it, and
+// a byte at a time on other architectures and for the tail
+template <char... Chars>
+struct XMLScan {
+    static const char* find(const char* first, const char* last) {
+#if defined(S3CPP_XML_X86)
+        static const auto implementation = __builtin_cpu_supports("avx2") ? findAVX2 : findSSE2;
+        return implementation(first, last);
+#else
+        return findScalar(first, last);
+#endif
+    }
+
+    static const char* findScalar(const char* first, const char* last) {
+        for (; first != last; first++) {
+            if (((*first == Chars) || ...))
+                return first;
+        }
+        return last;
+    }
+
+#if defined(S3CPP_XML_X86)
+    static const char* findSSE2(const char* first, const char* last) {
+        while (last - first >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            __m128i hits = _mm_setzero_si128();
+            ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))), ...);
+            if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits)))
+                return first + std::countr_zero(mask);
+            first += 16;
+        }
+        return findScalar(first, last);
+    }
+
+    __attribute__((target("avx2"))) static const char* findAVX2(const char* first, const char* last) {
+        while (last - first >= 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            __m256i hits = _mm256_setzero_si256();
+            ((hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Chars)))), ...);
+            if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)))
+                return first + std::countr_zero(mask);
+            first += 32;
+        }
+        return findSSE2(first, last);
+    }
+#endif
+};
 
 // We will use a regular Key Value struct to represent the raw XML nodes
 // TODO(cristian): Make private
@@ -18,154 +81,353 @@ struct XMLNode {
 		}
 };
 
-class XMLParser {
+// Event (SAX-style) parser for S3 valid XML
+//
+// Bytes are fed in as they arrive, in chunks of any size, and `Handler` is
+// called back as elements open and close:
+//
+//     void startElement(std::string_view name);
+//     void text(std::string_view value);      // leaf elements only, before endElement
+//     void endElement(std::string_view name);
+//
+// Views are only valid during the call. Text is handed out as a view into the
+// fed chunk when it sits whole in it with no entities, otherwise it goes
+// through a buffer that is reused from one element to the next. The dotted
+// path of the current element (i.e. "ListBucketResult.Contents.Key") is
+// available from `path()` during the callbacks.
+//
+// As with the rest of the parser, leading spaces of a text are dropped and
+// attributes, processing instructions and declarations are skipped.
+// Malformed documents throw std::runtime_error
+template <typename Handler>
+class XMLEventParser {
 public:
-    // Finite State Machine (FSM) for parsing S3 valid XML
-    // See the automata on #10 whiteboard: https://ggcr.github.io/whiteboards/
-    std::vector<XMLNode> parse(const std::string& xml) {
-        auto xmlElements = std::vector<XMLNode>();
-        auto sv = std::string_view { xml };
-
-        // Setup the initial state for our FSM
-        auto state = States::Start;
-
-        // Setup buffers we will use
-        std::string currentTag;
-        std::string currentTagClose;
-        std::string currentBody;
-        std::string currentPath;
-        std::string currentEntity;
-        auto tagStack = std::stack<std::string> {};
-				int tagCloseIdx = 0;
-
-        for (char ch : sv) {
-            auto prevState = state;
-            switch (state) {
-            case States::Start: {
-                if (ch == '<')
-                    state = States::Processing;
+    explicit XMLEventParser(Handler& handler)
+        : handler_(handler) { }
+
+    void feed(std::string_view chunk) {
+        size_t i = 0;
+        while (i < chunk.size()) {
+            switch (state_) {
+            case State::Text: {
+                const size_t j = scan<'<', '&'>(chunk, i);
+                const size_t end = j == std::string_view::npos ? chunk.size() : j;
+                // Only the text right inside a leaf element is kept, the
+                // whitespace between elements is not
+                if (leaf_ && !segments_.empty())
+                    appendText(chunk.substr(i, end - i));
+                if (j == std::string_view::npos) {
+                    i = chunk.size();
+                } else {
+                    state_ = chunk[j] == '<' ? State::TagOpen : State::Entity;
+                    entity_.clear();
+                    i = j + 1;
+                }
                 break;
             }
-            case States::Processing: {
-                // processing instructions are always self-contained
-                if (ch == '?')
-                    state = States::Start;
-                else {
-                    state = States::TagName;
-										currentTag += ch;
-                    if (currentPath.size() >= 2 && currentPath[currentPath.size() - 2] != '.') {
-												currentPath += '.';
+            case State::Entity: {
+                const size_t j = chunk.find(';', i);
+                if (j == std::string_view::npos) {
+                    entity_ += chunk.substr(i);
+                    i = chunk.size();
+                } else {
+                    entity_ += chunk.substr(i, j - i);
+                    materializeText();
+                    if (!has_text_) {
+                        has_text_ = true;
+                        owned_ = true;
                     }
-										currentPath += ch;
+                    appendXMLEntity(text_, entity_);
+                    state_ = State::Text;
+                    i = j + 1;
                 }
                 break;
             }
-            case States::TagName: {
-                if (ch == ' ')
-                    state = States::TagAttr;
-                else if (ch == '>') {
-                    state = States::Body;
-                    tagStack.push(currentTag);
-                    currentTag.clear();
+            case State::TagOpen: {
+                const char c = chunk[i];
+                if (c == '/') {
+                    if (segments_.empty())
+                        throw std::runtime_error("Closing tag without an open element");
+                    close_idx_ = 0;
+                    state_ = State::EndName;
+                    i++;
+                } else if (c == '?' || c == '!') {
+                    state_ = State::Skip;
+                    i++;
                 } else {
-										currentTag += ch;
-										currentPath += ch;
+                    openElement();
+                    state_ = State::StartName;
                 }
                 break;
             }
-            case States::TagAttr: {
-                if (ch == '>') {
-                    state = States::Body;
-                    tagStack.push(currentTag);
-                    currentTag.clear();
+            case State::StartName: {
+                const size_t j = scan<' ', '\t', '\r', '\n', '/', '>'>(chunk, i);
+                if (j == std::string_view::npos) {
+                    path_ += chunk.substr(i);
+                    i = chunk.size();
+                    break;
                 }
+                path_ += chunk.substr(i, j - i);
+                handler_.startElement(name());
+                state_ = chunk[j] == '>' ? State::Text : (chunk[j] == '/' ? State::SelfClose : State::Attributes);
+                i = j + 1;
                 break;
             }
-            case States::Body: {
-                if (ch == '<') {
-                    state = States::Tag;
-                } else if (ch == '&') {
-                    state = States::Entity;
-                } else {
-									// Ignore leading spaces in the Body
-									if (ch == ' ' && currentBody.size() == 0)
-										break;
-									currentBody += ch;
+            case State::Attributes: {
+                if (quote_) {
+                    const size_t j = chunk.find(quote_, i);
+                    i = j == std::string_view::npos ? chunk.size() : j + 1;
+                    if (j != std::string_view::npos)
+                        quote_ = 0;
+                    break;
+                }
+                const size_t j = scan<'"', '\'', '/', '>'>(chunk, i);
+                if (j == std::string_view::npos) {
+                    i = chunk.size();
+                    break;
                 }
+                if (chunk[j] == '>')
+                    state_ = State::Text;
+                else if (chunk[j] == '/')
+                    state_ = State::SelfClose;
+                else
+                    quote_ = chunk[j];
+                i = j + 1;
                 break;
             }
-            case States::Entity: {
-                if (ch == ';') {
-                    // Decode entity and append it to currentBody
-                    state = States::Body;
-										currentBody += decodeXMLEntity(currentEntity);
-                    currentEntity.clear();
-                } else {
-										currentEntity += ch;
-                }
+            case State::SelfClose: {
+                if (chunk[i] != '>')
+                    throw std::runtime_error(std::format("Invalid self-closing tag: {}", name()));
+                closeElement();
+                i++;
                 break;
             }
-            case States::Tag: {
-                if (ch == '/') {
-                    state = States::TagClose;
-                    if (tagCloseIdx == 0)
-                        currentTagClose = tagStack.top();
+            case State::EndName: {
+                // Matched in place against the name of the open element
+                const std::string_view expected = name();
+                if (close_idx_ < expected.size()) {
+                    const std::string_view rest = chunk.substr(i, expected.size() - close_idx_);
+                    if (rest != expected.substr(close_idx_, rest.size())) {
+                        const auto [c, _] = std::ranges::mismatch(rest, expected.substr(close_idx_));
+                        throw std::runtime_error(std::format("Invalid closing tag encountered: {} for char {}", expected, *c));
+                    }
+                    close_idx_ += rest.size();
+                    i += rest.size();
+                    break;
+                }
+                const char c = chunk[i];
+                if (c == '>') {
+                    closeElement();
+                } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                    state_ = State::EndTail;
                 } else {
-										currentTag += ch;
-										currentPath += '.';
-										currentPath += ch;
-                    state = States::Processing;
+                    throw std::runtime_error(std::format("Invalid closing tag encountered: {} for char {}", expected, c));
                 }
+                i++;
                 break;
             }
-            case States::TagClose: {
-                if (ch != currentTagClose[tagCloseIdx]) {
-                    throw std::runtime_error(std::format("Invalid closing tag encountered: {} for char {}", currentTagClose, ch));
+            case State::EndTail: {
+                const char c = chunk[i];
+                if (c == '>')
+                    closeElement();
+                else if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+                    throw std::runtime_error(std::format("Invalid closing tag encountered: {} for char {}", name(), c));
+                i++;
+                break;
+            }
+            case State::Skip: {
+                const size_t j = chunk.find('>', i);
+                if (j == std::string_view::npos) {
+                    i = chunk.size();
                 } else {
-                    // currentTagClose.erase(0, 1);
-										tagCloseIdx++;
-                    if (tagCloseIdx == currentTagClose.size()) {
-                        state = States::Emit;
-												tagCloseIdx = 0;
-										}
+                    state_ = State::Text;
+                    i = j + 1;
                 }
                 break;
             }
-            case States::Emit: {
-                if (tagStack.size() == 0)
-                    throw std::runtime_error("Tag stack is empty");
+            }
+        }
+        // The chunk goes away once this returns
+        materializeText();
+    }
 
-                std::string tagName = tagStack.top();
+    // Call once the whole document was fed
+    void finish() {
+        if (state_ != State::Text || !segments_.empty())
+            throw std::runtime_error("Incomplete XML document");
+    }
 
-                // Note: For now we will only return the leaf nodes
-                // aka, those nodes that have an actual value
-                if (currentBody.size() != 0) {
-                    xmlElements.push_back(XMLNode { currentPath, currentBody });
-                    // std::println("[EMIT] Tag={}, Body={}", currentPath, currentBody);
-                }
+    // Ready for another document, buffers keep their capacity
+    void reset() {
+        state_ = State::Text;
+        path_.clear();
+        segments_.clear();
+        text_.clear();
+        view_ = {};
+        has_text_ = false;
+        owned_ = false;
+        leaf_ = false;
+        quote_ = 0;
+    }
 
-                state = States::Body;
+    std::string_view path() const { return path_; }
+    size_t depth() const { return segments_.size(); }
 
-                // Cleanup
-                tagStack.pop();
-                if (auto pos = currentPath.find_last_of('.'); pos != std::string::npos) {
-                    currentPath.erase(pos, std::string::npos);
-                }
-                currentBody.clear();
-								currentTagClose.clear();
-                break;
-            }
-            default:
-                throw std::runtime_error(std::format("Invalid state reached: {}", std::to_underlying(state)));
+private:
+    enum class State : int {
+        Text,
+        Entity,
+        TagOpen,
+        StartName,
+        Attributes,
+        SelfClose,
+        EndName,
+        EndTail,
+        Skip,
+    };
+
+    Handler& handler_;
+    State state_ = State::Text;
+    // Dotted path of the open elements and where each of their names starts
+    std::string path_;
+    std::vector<size_t> segments_;
+    // Text of the current element, either a view into the fed chunk or `text_`
+    std::string text_;
+    std::string_view view_;
+    bool has_text_ = false;
+    bool owned_ = false;
+    // No child element seen yet in the current element
+    bool leaf_ = false;
+    std::string entity_;
+    size_t close_idx_ = 0;
+    char quote_ = 0;
+
+    std::string_view name() const {
+        return std::string_view(path_).substr(segments_.back());
+    }
+
+    // As find_first_of(), for a set known at compile time
+    template <char... Chars>
+    static size_t scan(std::string_view chunk, size_t from) {
+        const char* end = chunk.data() + chunk.size();
+        const char* found = XMLScan<Chars...>::find(chunk.data() + from, end);
+        return found == end ? std::string_view::npos : static_cast<size_t>(found - chunk.data());
+    }
+
+    void openElement() {
+        // The parent is not a leaf anymore, drop whatever text it had so far
+        clearText();
+        if (!path_.empty())
+            path_ += '.';
+        segments_.push_back(path_.size());
+        leaf_ = true;
+    }
+
+    void closeElement() {
+        if (leaf_ && has_text_)
+            handler_.text(owned_ ? std::string_view(text_) : view_);
+        handler_.endElement(name());
+
+        const size_t start = segments_.back();
+        segments_.pop_back();
+        path_.resize(start > 0 ? start - 1 : 0);
+        clearText();
+        leaf_ = false;
+        state_ = State::Text;
+    }
+
+    void appendText(std::string_view run) {
+        if (!has_text_) {
+            // Ignore leading spaces in the Body
+            const size_t first = run.find_first_not_of(' ');
+            if (first == std::string_view::npos)
+                return;
+            view_ = run.substr(first);
+            has_text_ = true;
+            owned_ = false;
+            return;
+        }
+        materializeText();
+        text_ += run;
+    }
+
+    void materializeText() {
+        if (has_text_ && !owned_) {
+            text_.assign(view_);
+            owned_ = true;
+        }
+    }
+
+    void clearText() {
+        text_.clear();
+        view_ = {};
+        has_text_ = false;
+        owned_ = false;
+    }
+
+    // Named and numeric references, the latter encoded as UTF-8
+    static void appendXMLEntity(std::string& out, std::string_view entity) {
+        if (entity == "quot")
+            out += '"';
+        else if (entity == "apos")
+            out += '\'';
+        else if (entity == "lt")
+            out += '<';
+        else if (entity == "gt")
+            out += '>';
+        else if (entity == "amp")
+            out += '&';
+        else if (entity.starts_with('#') && entity.size() > 1) {
+            const bool hex = entity[1] == 'x' || entity[1] == 'X';
+            const std::string_view digits = entity.substr(hex ? 2 : 1);
+            uint32_t code = 0;
+            auto result = std::from_chars(digits.data(), digits.data() + digits.size(), code, hex ? 16 : 10);
+            if (result.ec != std::errc {} || result.ptr != digits.data() + digits.size() || code > 0x10FFFF)
+                throw std::runtime_error(std::format("Invalid XML character reference: &{};", entity));
+            if (code < 0x80) {
+                out += static_cast<char>(code);
+            } else if (code < 0x800) {
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
             }
+        } else {
+            throw std::runtime_error(std::format("Unknown XML entity: &{};", entity));
         }
-        if (currentTag.size() == 0 && currentTagClose.size() == 0 && currentBody.size() == 0 && tagStack.size() == 0)
-            return xmlElements;
-        else
-            throw std::runtime_error("Something went wrong");
+    }
+};
+
+class XMLParser {
+public:
+    // Whole document at once, into the leaf nodes (those with an actual
+    // value) along with their dotted paths
+    std::vector<XMLNode> parse(const std::string& xml) {
+        struct Collector {
+            XMLEventParser<Collector>* parser;
+            std::vector<XMLNode> nodes;
+
+            void startElement(std::string_view) { }
+            void text(std::string_view value) { nodes.push_back(XMLNode { std::string(parser->path()), std::string(value) }); }
+            void endElement(std::string_view) { }
+        };
+
+        Collector collector;
+        XMLEventParser<Collector> parser(collector);
+        collector.parser = &parser;
+        parser.feed(xml);
+        parser.finish();
+        return std::move(collector.nodes);
     }
 
-    char decodeXMLEntity(const std::string& entity) {
+    static char decodeXMLEntity(const std::string& entity) {
         // XML escape characters
         if (entity == "quot")
             return '"';
@@ -184,8 +446,9 @@ public:
     }
 
     template <typename T>
-    T parseNumber(const std::string s) {
-        int code;
+    static T parseNumber(std::string_view s) {
+        // wide enough for Content-Length/Size of multi-GB objects
+        long long code;
         std::from_chars_result result;
         int base = 10;
 
@@ -210,7 +473,7 @@ public:
         throw std::runtime_error(std::format("Unable to parse number from '{}'", s));
     }
 
-    bool parseBool(const std::string& s) {
+    static bool parseBool(std::string_view s) {
         if (s == "True" || s == "true")
             return true;
         else if (s == "False" || s == "false")
@@ -218,17 +481,108 @@ public:
         else
             throw std::runtime_error(std::format("Unable to parse boolean from string: '{}'", s));
     }
+};
+
+// Declarative mapping of XML paths onto the members of a response struct
+//
+// Every path of interest gets an `XMLField`, built with the helpers below out
+// of member pointers, and the fields of a response go in a constexpr
+// `XMLFieldTable`. Lookups hash the path once into a collision-free table
+// worked out at compile time, so dispatching a node does not depend on how
+// many fields the response has:
+//
+//     constexpr XMLFieldTable ListBucketsFields { std::array {
+//         xmlField<&ListAllMyBucketsResult::Prefix>("ListAllMyBucketsResult.Prefix"),
+//         xmlRecord<&ListAllMyBucketsResult::Buckets>("ListAllMyBucketsResult.Buckets.Bucket"),
+//         xmlRecordField<&ListAllMyBucketsResult::Buckets, &Bucket::Name>("ListAllMyBucketsResult.Buckets.Bucket.Name"),
+//     } };
+template <typename Result>
+struct XMLField {
+    std::string_view path;
+    // Leaf elements store their text
+    void (*text)(Result&, std::string_view) = nullptr;
+    // Repeated elements start a new record of a list
+    void (*start)(Result&) = nullptr;
+};
+
+inline void xmlAssign(std::string& target, std::string_view value) { target.assign(value); }
+inline void xmlAssign(bool& target, std::string_view value) { target = XMLParser::parseBool(value); }
+template <std::integral T>
+void xmlAssign(T& target, std::string_view value) { target = XMLParser::parseNumber<T>(value); }
+
+template <typename T>
+struct XMLMemberOf;
+template <typename Class, typename Member>
+struct XMLMemberOf<Member Class::*> {
+    using type = Class;
+};
+template <auto Member>
+using XMLMemberOf_t = typename XMLMemberOf<decltype(Member)>::type;
+
+// result.*First.*Rest... = text
+template <auto First, auto... Rest>
+constexpr XMLField<XMLMemberOf_t<First>> xmlField(std::string_view path) {
+    return { path, [](XMLMemberOf_t<First>& result, std::string_view value) { xmlAssign(((result.*First) .* ... .*Rest), value); } };
+}
+
+// A new element at the back of the list result.*List
+template <auto List>
+constexpr XMLField<XMLMemberOf_t<List>> xmlRecord(std::string_view path) {
+    return { path, nullptr, [](XMLMemberOf_t<List>& result) { (result.*List).emplace_back(); } };
+}
+
+// (result.*List).back().*Members... = text
+template <auto List, auto... Members>
+constexpr XMLField<XMLMemberOf_t<List>> xmlRecordField(std::string_view path) {
+    return { path, [](XMLMemberOf_t<List>& result, std::string_view value) { xmlAssign(((result.*List).back() .* ... .*Members), value); } };
+}
+
+template <typename Result, size_t N>
+class XMLFieldTable {
+public:
+    consteval XMLFieldTable(const std::array<XMLField<Result>, N>& fields)
+        : fields_(fields) {
+        // Seeds are tried until every path lands in its own slot. With four
+        // slots per field that takes a few dozen attempts
+        for (seed_ = 0;; seed_++) {
+            slots_ = {};
+            bool collision = false;
+            for (size_t i = 0; i < N && !collision; i++) {
+                uint16_t& slot = slots_[hash(fields_[i].path, seed_) & (Slots - 1)];
+                collision = slot != 0;
+                slot = static_cast<uint16_t>(i + 1);
+            }
+            if (!collision)
+                break;
+        }
+    }
+
+    const XMLField<Result>* find(std::string_view path) const {
+        const uint16_t slot = slots_[hash(path, seed_) & (Slots - 1)];
+        if (slot == 0 || fields_[slot - 1].path != path)
+            return nullptr;
+        return &fields_[slot - 1];
+    }
 
 private:
-    enum class States : int {
-        Start,
-        Processing,
-        TagName,
-        TagAttr,
-        Body,
-        Entity,
-        Tag,
-        TagClose,
-        Emit,
-    };
+    static constexpr size_t Slots = std::bit_ceil(4 * N);
+
+    std::array<XMLField<Result>, N> fields_;
+    std::array<uint16_t, Slots> slots_ {};
+    uint64_t seed_ = 0;
+
+    // FNV-1a, seeded
+    static constexpr uint64_t hash(std::string_view path, uint64_t seed) {
+        uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+        for (char c : path) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        return h ^ (h >> 29);
+    }
 };
+
+template <typename Result, size_t N>
+XMLFieldTable(const std::array<XMLField<Result>, N>&) -> XMLFieldTable<Result, N>;
+
+#endif
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <s3cpp/arena.h>
+#include <string>
+#include <vector>
+
+TEST(ARENA, Store) {
+    StringArena arena(64);
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 100; i++)
+        views.push_back(arena.store(std::to_string(i)));
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(views[i], std::to_string(i));
+    EXPECT_EQ(arena.store(""), "");
+}
+
+TEST(ARENA, LargeValues) {
+    StringArena arena(64);
+    const std::string_view before = arena.store("small");
+    const std::string large(1000, 'x');
+    EXPECT_EQ(arena.store(large), large);
+    // The block in use is kept for the small values that follow
+    const std::string_view after = arena.store("tail");
+    EXPECT_EQ(after.data(), before.data() + before.size());
+    EXPECT_EQ(arena.capacity(), 64 + 1000);
+}
+
+TEST(ARENA, Intern) {
+    StringArena arena;
+    std::string storageClass = "STANDARD";
+    const std::string_view first = arena.intern(storageClass);
+    storageClass = "GLACIER";
+    const std::string_view other = arena.intern(storageClass);
+    EXPECT_EQ(arena.intern("STANDARD").data(), first.data());
+    EXPECT_EQ(first, "STANDARD");
+    EXPECT_EQ(other, "GLACIER");
+    EXPECT_NE(arena.store("STANDARD").data(), first.data());
+}
+
+TEST(ARENA, Move) {
+    StringArena arena;
+    const std::string_view value = arena.store("ListBucketResult");
+    StringArena moved = std::move(arena);
+    EXPECT_EQ(value, "ListBucketResult");
+    EXPECT_EQ(moved.intern("ListBucketResult"), "ListBucketResult");
+    // Whatever the moved-from arena stores goes in blocks of its own
+    EXPECT_EQ(arena.capacity(), 0);
+    EXPECT_EQ(arena.store("other"), "other");
+    EXPECT_EQ(value, "ListBucketResult");
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <s3cpp/checksum.h>
+#include <string>
+
+namespace {
+
+// Bit-at-a-time definitions to check the fast paths against
+uint32_t referenceCrc32c(const std::string& data) {
+    uint32_t crc = ~0u;
+    for (unsigned char c : data) {
+        crc ^= c;
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+    }
+    return ~crc;
+}
+
+uint64_t referenceCrc64nvme(const std::string& data) {
+    uint64_t crc = ~0ull;
+    for (unsigned char c : data) {
+        crc ^= c;
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x9A6C9329AC4BC9B5ull : 0);
+    }
+    return ~crc;
+}
+
+std::string pattern(size_t size) {
+    std::string data(size, '\0');
+    uint32_t state = 2463534242u;
+    for (char& c : data) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        c = static_cast<char>(state);
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(CHECKSUM, CheckValues) {
+    // The "check" values of both CRC catalog entries
+    EXPECT_EQ(crc32c(0, "123456789", 9), 0xE3069283u);
+    EXPECT_EQ(crc64nvme(0, "123456789", 9), 0xAE8B14860A799888ull);
+    EXPECT_EQ(crc32c(0, "", 0), 0u);
+    EXPECT_EQ(crc64nvme(0, "", 0), 0u);
+}
+
+TEST(CHECKSUM, Base64) {
+    Checksum crc32(ChecksumAlgorithm::CRC32C);
+    crc32.update("123456789");
+    EXPECT_EQ(crc32.base64(), "4waSgw==");
+
+    Checksum crc64(ChecksumAlgorithm::CRC64NVME);
+    crc64.update("123456789");
+    EXPECT_EQ(crc64.base64(), "rosUhgp5mIg=");
+
+    crc64.reset();
+    EXPECT_EQ(crc64.base64(), "AAAAAAAAAAA=");
+}
+
+TEST(CHECKSUM, MatchesReference) {
+    // Covers the tails and the block loops of the hardware paths, at every alignment
+    const std::string data = pattern(2048 + 16);
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t size : { 0, 1, 7, 8, 15, 16, 31, 32, 33, 63, 64, 127, 128, 129, 255, 300, 1024, 2048 }) {
+            const std::string piece = data.substr(offset, size);
+            EXPECT_EQ(crc32c(0, piece.data(), piece.size()), referenceCrc32c(piece)) << offset << " " << size;
+            EXPECT_EQ(crc64nvme(0, piece.data(), piece.size()), referenceCrc64nvme(piece)) << offset << " " << size;
+        }
+    }
+}
+
+TEST(CHECKSUM, Incremental) {
+    const std::string data = pattern(100000);
+    const uint32_t whole32 = crc32c(0, data.data(), data.size());
+    const uint64_t whole64 = crc64nvme(0, data.data(), data.size());
+
+    for (size_t piece : { 1, 13, 64, 4097, 65536 }) {
+        Checksum crc32(ChecksumAlgorithm::CRC32C);
+        Checksum crc64(ChecksumAlgorithm::CRC64NVME);
+        for (size_t offset = 0; offset < data.size(); offset += piece) {
+            crc32.update(std::string_view(data).substr(offset, piece));
+            crc64.update(std::string_view(data).substr(offset, piece));
+        }
+        EXPECT_EQ(crc32.value(), whole32) << piece;
+        EXPECT_EQ(crc64.value(), whole64) << piece;
+    }
+}
+
+TEST(CHECKSUM, Names) {
+    EXPECT_EQ(checksumAlgorithmFromName("CRC32C"), ChecksumAlgorithm::CRC32C);
+    EXPECT_EQ(checksumAlgorithmFromName("CRC64NVME"), ChecksumAlgorithm::CRC64NVME);
+    EXPECT_EQ(checksumAlgorithmFromName("SHA256"), std::nullopt);
+    EXPECT_EQ(checksumHeader(ChecksumAlgorithm::CRC64NVME), "x-amz-checksum-crc64nvme");
+    EXPECT_EQ(checksumAlgorithmFromHeader("X-Amz-Checksum-CRC32C"), ChecksumAlgorithm::CRC32C);
+    EXPECT_EQ(checksumAlgorithmFromHeader("x-amz-checksum-crc32"), std::nullopt);
+}
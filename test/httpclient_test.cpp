@@ -3,12 +3,19 @@
 #include <curl/easy.h>
 #include <exception>
 #include <format>
+#include <future>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <netinet/in.h>
 #include <s3cpp/httpclient.h>
 #include <stdexcept>
 #include <string>
+#include <sys/socket.h>
+#include <thread>
 #include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 TEST(HTTP, AllStatusCodes) {
     HttpClient client {};
@@ -42,6 +49,128 @@ TEST(HTTP, HTTPClientMoveOwnership) {
     EXPECT_EQ(client2.get(URL).execute().status(), 200);
 }
 
+TEST(HTTP, HTTPClientInvalidPoolOptions) {
+    EXPECT_THROW(HttpClient(HttpClientOptions { .max_connections = 0 }), std::invalid_argument);
+    EXPECT_THROW(HttpClient(HttpClientOptions { .max_connections_per_host = 0 }), std::invalid_argument);
+}
+
+TEST(HTTP, HTTPClientConcurrentRequests) {
+    // A single client is shared by all the threads, each request checks out
+    // its own handle from the pool
+    HttpClient client(HttpClientOptions { .max_connections = 4, .max_connections_per_host = 2 });
+
+    std::vector<int> statuses(8, 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < statuses.size(); i++) {
+        workers.emplace_back([&client, &statuses, i] {
+            // an exception escaping the thread would take the whole binary down
+            try {
+                statuses[i] = client.get("https://postman-echo.com/status/200").timeout(10).execute().status();
+            } catch (const std::runtime_error&) {
+                statuses[i] = -1;
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    for (int status : statuses)
+        EXPECT_EQ(status, 200);
+
+    // All handles are back in the pool, at most `max_connections_per_host`
+    // were ever created for a single host
+    EXPECT_EQ(client.pool().in_use(), 0);
+    EXPECT_LE(client.pool().idle(), 2);
+}
+
+TEST(HTTP, HTTPAsyncFuture) {
+    HttpClient client {};
+    std::vector<std::future<HttpResponse>> futures;
+    for (auto i : { 200, 404, 500 })
+        futures.push_back(client.get(std::format("https://postman-echo.com/status/{}", i)).timeout(10).execute_async());
+
+    EXPECT_EQ(futures[0].get().status(), 200);
+    EXPECT_EQ(futures[1].get().status(), 404);
+    EXPECT_EQ(futures[2].get().status(), 500);
+}
+
+TEST(HTTP, HTTPAsyncCallback) {
+    HttpClient client {};
+    std::promise<std::expected<HttpResponse, std::string>> done;
+    client.post("https://postman-echo.com/post")
+        .body("async body")
+        .timeout(10)
+        .execute_async([&done](std::expected<HttpResponse, std::string> result) {
+            done.set_value(std::move(result));
+        });
+
+    auto result = done.get_future().get();
+    ASSERT_TRUE(result.has_value()) << result.error();
+    EXPECT_TRUE(result->is_ok());
+    EXPECT_THAT(result->body(), testing::HasSubstr("async body"));
+}
+
+TEST(HTTP, HTTPAsyncTransportError) {
+    HttpClient client {};
+    // Transport errors surface from the future, as `execute()` would throw
+    auto future = client.get("http://127.0.0.1:1/").execute_async();
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+namespace {
+
+// A local listener that never answers, transfers to it stay in flight
+struct SilentServer {
+    int listener = -1;
+    std::string url;
+
+    SilentServer() {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(listener, 16);
+        socklen_t length = sizeof(address);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+        url = std::format("http://127.0.0.1:{}/", ntohs(address.sin_port));
+    }
+    ~SilentServer() { close(listener); }
+};
+
+} // namespace
+
+TEST(HTTP, HTTPAsyncClientDestroyedInFlight) {
+    SilentServer server;
+    std::vector<std::future<HttpResponse>> futures;
+    {
+        HttpClient client(std::unordered_map<std::string, std::string> { { "X-Client", "client header" } });
+        // Still being sent when the client goes away, along with the client
+        // headers the transfers point to
+        for (int i = 0; i < 64; i++)
+            futures.push_back(client.get(server.url).header("X-Request", std::to_string(i)).timeout(10).execute_async());
+    }
+    for (auto& future : futures)
+        EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(HTTP, HTTPAsyncThrowingCallbackCancelled) {
+    SilentServer server;
+    std::future<HttpResponse> future;
+    {
+        HttpClient client {};
+        // Cancelled when the client goes away, the exception is swallowed
+        for (int i = 0; i < 4; i++) {
+            client.get(server.url).timeout(10).execute_async([](std::expected<HttpResponse, std::string>) {
+                throw std::runtime_error("callback failure");
+            });
+        }
+        future = client.get(server.url).timeout(10).execute_async();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
 TEST(HTTP, HTTPBodyNonEmpty) {
     HttpClient client {};
     HttpResponse request = client.get("https://postman-echo.com/get?foo=bar").execute();
@@ -177,6 +306,55 @@ TEST(HTTP, HTTPHeaderOrder) {
     }
 }
 
+TEST(HTTP, HTTPHeaders) {
+    HttpHeaders headers {
+        { "x-amz-date", "20130524T000000Z" },
+        { "Host", "examplebucket.s3.amazonaws.com" },
+        { "Content-Type", "text/plain" },
+    };
+    headers.set("HOST", "localhost:9000");
+
+    // Sorted ignoring case, a replaced header keeps the spelling of its name
+    std::vector<std::string> names;
+    for (const auto& [name, value] : headers)
+        names.emplace_back(name);
+    EXPECT_EQ(names, (std::vector<std::string> { "Content-Type", "Host", "x-amz-date" }));
+    EXPECT_EQ(headers.at("host"), "localhost:9000");
+    EXPECT_EQ(headers.find("X-AMZ-DATE")->second, "20130524T000000Z");
+    EXPECT_FALSE(headers.contains("Authorization"));
+    EXPECT_THROW(headers.at("Authorization"), std::out_of_range);
+
+    // The fields are kept as the lines sent to cURL
+    auto it = headers.find("Host");
+    EXPECT_EQ(it.line(), "Host: localhost:9000");
+    EXPECT_EQ(it.line().data()[it.line().size()], '\0');
+
+    // Setting a header from a view of the same headers
+    headers.set("x-amz-copy", headers.at("x-amz-date"));
+    EXPECT_EQ(headers.at("x-amz-copy"), "20130524T000000Z");
+
+    HttpHeaders copy = headers;
+    EXPECT_EQ(copy, headers);
+    copy.set("Content-Type", "application/xml");
+    EXPECT_NE(copy, headers);
+}
+
+TEST(HTTP, HTTPHedgingDelay) {
+    HttpHedging hedging({ .percentile = 90, .initial_delay = std::chrono::milliseconds(40), .min_samples = 10, .min_delay = std::chrono::milliseconds(2) });
+    EXPECT_EQ(hedging.delay(), std::chrono::milliseconds(40));
+
+    // 1ms to 10ms, the 90th percentile is 9ms
+    for (int i = 10; i >= 1; i--)
+        hedging.record(std::chrono::milliseconds(i));
+    EXPECT_EQ(hedging.delay(), std::chrono::milliseconds(9));
+
+    // Never below `min_delay`
+    for (int i = 0; i < 256; i++)
+        hedging.record(std::chrono::microseconds(100));
+    EXPECT_EQ(hedging.delay(), std::chrono::milliseconds(2));
+    EXPECT_EQ(hedging.stats().requests, 0);
+}
+
 TEST(HTTP, HTTPPost) {
     HttpClient client {};
     std::string data = "This is expected to be sent back as part of response body";
@@ -213,6 +391,24 @@ TEST(HTTP, HTTPPut) {
     EXPECT_THAT(resp.body(), testing::HasSubstr(data));
 }
 
+TEST(HTTP, HTTPPostStreamedBody) {
+    HttpClient client {};
+    std::string data = "This is expected to be sent back as part of response body";
+    size_t offset = 0;
+    HttpBodyRequest req = client.post("https://postman-echo.com/post").body([&](char* buffer, size_t size) -> std::ptrdiff_t {
+        // hand it over a few bytes at a time
+        size_t n = std::min({ size, data.size() - offset, size_t(7) });
+        std::copy_n(data.data() + offset, n, buffer);
+        offset += n;
+        return n;
+    },
+        data.size());
+    EXPECT_TRUE(req.getBody().empty());
+    HttpResponse resp = req.execute();
+    EXPECT_EQ(resp.status(), 200);
+    EXPECT_THAT(resp.body(), testing::HasSubstr(data));
+}
+
 // TEST(HTTP, HTTPDeleteQueryParamStr) {
 //     HttpClient client {};
 //     std::string query = "deletethis";
@@ -0,0 +1,199 @@
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <format>
+#include <gtest/gtest.h>
+#include <s3cpp/limiter.h>
+#include <s3cpp/s3.h>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(LIMITER, AdditiveIncrease) {
+    ConcurrencyLimiter limiter({ .InitialLimit = 4, .MaxLimit = 6 });
+    std::deque<ConcurrencyPermit> permits;
+    // Keep the window full, a limit's worth of healthy responses adds one
+    for (int i = 0; i < 100; i++) {
+        while (permits.size() < limiter.limit())
+            permits.push_back(limiter.acquire());
+        permits.front().release(ConcurrencySignal::Healthy);
+        permits.pop_front();
+    }
+    EXPECT_EQ(limiter.limit(), 6);
+    EXPECT_EQ(limiter.decreases(), 0);
+}
+
+TEST(LIMITER, NoIncreaseWhileUnused) {
+    ConcurrencyLimiter limiter({ .InitialLimit = 4 });
+    for (int i = 0; i < 100; i++)
+        limiter.acquire().release(ConcurrencySignal::Healthy);
+    EXPECT_EQ(limiter.limit(), 4);
+}
+
+TEST(LIMITER, MultiplicativeDecrease) {
+    ConcurrencyLimiter limiter({ .InitialLimit = 10, .Backoff = 0.7 });
+    std::deque<ConcurrencyPermit> permits;
+    for (int i = 0; i < 10; i++)
+        permits.push_back(limiter.acquire());
+
+    // A burst of 503s to requests of the same window counts once
+    for (int i = 0; i < 5; i++) {
+        permits.front().release(ConcurrencySignal::Congested);
+        permits.pop_front();
+    }
+    EXPECT_EQ(limiter.limit(), 7);
+    EXPECT_EQ(limiter.throttled(), 5);
+    EXPECT_EQ(limiter.decreases(), 1);
+
+    // The rest of the window still in flight, no slot is free
+    EXPECT_EQ(limiter.inFlight(), 5);
+    permits.clear();
+    limiter.acquire().release(ConcurrencySignal::Congested);
+    EXPECT_EQ(limiter.limit(), 4);
+    EXPECT_EQ(limiter.decreases(), 2);
+
+    for (int i = 0; i < 10; i++)
+        limiter.acquire().release(ConcurrencySignal::Congested);
+    EXPECT_EQ(limiter.limit(), 1);
+}
+
+TEST(LIMITER, RisingLatency) {
+    ConcurrencyLimiter limiter({ .InitialLimit = 10, .Backoff = 0.5, .LatencyTolerance = 2 });
+    for (int i = 0; i < 30; i++) {
+        ConcurrencyPermit permit = limiter.acquire();
+        std::this_thread::sleep_for(1ms);
+        permit.release(ConcurrencySignal::Healthy);
+    }
+    EXPECT_EQ(limiter.decreases(), 0);
+    for (int i = 0; i < 10 && limiter.decreases() == 0; i++) {
+        ConcurrencyPermit permit = limiter.acquire();
+        std::this_thread::sleep_for(20ms);
+        permit.release(ConcurrencySignal::Healthy);
+    }
+    EXPECT_EQ(limiter.decreases(), 1);
+    EXPECT_EQ(limiter.limit(), 5);
+}
+
+TEST(LIMITER, WaitsForSlot) {
+    ConcurrencyLimiter limiter({ .InitialLimit = 1 });
+    ConcurrencyPermit permit = limiter.acquire();
+    std::atomic<bool> acquired = false;
+    std::thread waiter([&] {
+        limiter.acquire();
+        acquired = true;
+    });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(acquired);
+    // Dropping the permit gives the slot back
+    { ConcurrencyPermit released = std::move(permit); }
+    waiter.join();
+    EXPECT_TRUE(acquired);
+    EXPECT_EQ(limiter.inFlight(), 0);
+}
+
+TEST(LIMITER, Partitions) {
+    AdaptiveConcurrency concurrency({ .PrefixDepth = 1 });
+    EXPECT_EQ(concurrency.partition("bucket", "path/to/file.txt"), "bucket/path/");
+    EXPECT_EQ(concurrency.partition("bucket", "file.txt"), "bucket");
+    EXPECT_EQ(concurrency.partition("bucket", ""), "bucket");
+
+    AdaptiveConcurrency deeper({ .PrefixDepth = 2 });
+    EXPECT_EQ(deeper.partition("bucket", "path/to/file.txt"), "bucket/path/to/");
+    EXPECT_EQ(deeper.partition("bucket", "path/file.txt"), "bucket/path/");
+    EXPECT_EQ(deeper.limiter("bucket/path/"), deeper.limiter("bucket/path/"));
+}
+
+TEST(LIMITER, IdlePartitionsEvicted) {
+    AdaptiveConcurrency concurrency({ .IdleTimeout = 0s });
+    std::shared_ptr<ConcurrencyLimiter> held = concurrency.limiter("bucket/held/");
+    for (int i = 0; i < 100; i++)
+        concurrency.limiter(std::format("bucket/{}/", i));
+
+    // Only the one still held and the last one are left
+    const std::vector<ConcurrencyLimit> limits = concurrency.limits();
+    ASSERT_EQ(limits.size(), 2);
+    EXPECT_EQ(limits[0].Partition, "bucket/99/");
+    EXPECT_EQ(limits[1].Partition, "bucket/held/");
+    EXPECT_EQ(concurrency.limiter("bucket/held/"), held);
+}
+
+TEST(LIMITER, S3ClientPartitions) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    EXPECT_TRUE(client.ConcurrencyLimits().empty());
+    client.SetAdaptiveConcurrency({ .InitialLimit = 4 });
+    client.HeadBucket("my-bucket");
+    client.GetObject("my-bucket", "path/to/file_1.txt");
+    client.GetObject("my-bucket", "path/to/file_2.txt");
+
+    const std::vector<ConcurrencyLimit> limits = client.ConcurrencyLimits();
+    ASSERT_EQ(limits.size(), 2);
+    EXPECT_EQ(limits[0].Partition, "my-bucket");
+    EXPECT_EQ(limits[1].Partition, "my-bucket/path/");
+    for (const ConcurrencyLimit& limit : limits) {
+        EXPECT_EQ(limit.Limit, 4);
+        EXPECT_EQ(limit.InFlight, 0);
+    }
+}
+
+TEST(LIMITER, RateLimiterDebt) {
+    RateLimiter limiter(100, 10);
+    // The burst is there right away, going over it puts the bucket in debt
+    EXPECT_EQ(limiter.reserve(10), 0ns);
+    EXPECT_EQ(limiter.reserve(20), 0ns);
+    EXPECT_GT(limiter.waitTime(), 150ms);
+    // Later callers wait for the debt, not for what they take
+    const std::chrono::nanoseconds wait = limiter.reserve(1);
+    EXPECT_GT(wait, 150ms);
+    EXPECT_LE(wait, 200ms);
+    EXPECT_THROW(RateLimiter(0), std::invalid_argument);
+}
+
+TEST(LIMITER, RateLimiterRate) {
+    RateLimiter limiter(200, 1);
+    const auto start = std::chrono::steady_clock::now();
+    // The burst, and the call that puts the bucket in debt, go through right
+    // away. The 20 others wait for a token, at 200 a second
+    for (int i = 0; i < 22; i++)
+        limiter.acquire();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 95ms);
+}
+
+TEST(LIMITER, S3ClientRateLimits) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    client.SetRateLimits({ .Get = std::make_shared<RateLimiter>(50, 1), .Upload = std::make_shared<RateLimiter>(512 * 1024, 16 * 1024) });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 7; i++)
+        EXPECT_TRUE(client.HeadObject("my-bucket", "path/to/file_1.txt"));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 95ms);
+
+    // In-memory bodies are limited as well
+    const std::string body(256 * 1024, 'x');
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(client.PutObject("my-bucket", "limiter/body.txt", body));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 250ms);
+    auto object = client.GetObject("my-bucket", "limiter/body.txt");
+    ASSERT_TRUE(object);
+    EXPECT_EQ(*object, body);
+}
+
+TEST(LIMITER, S3ClientAsyncRateLimits) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    client.SetRateLimits({ .Get = std::make_shared<RateLimiter>(50, 1) });
+
+    // Issued right away, the event loop holds them back
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<std::expected<HeadObjectResult, Error>>> futures;
+    for (int i = 0; i < 7; i++)
+        futures.push_back(client.HeadObjectAsync("my-bucket", "path/to/file_1.txt"));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 50ms);
+    for (auto& future : futures)
+        EXPECT_TRUE(future.get());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 95ms);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; i++)
+        EXPECT_TRUE(sync_wait(client.HeadObjectTask("my-bucket", "path/to/file_1.txt")));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 55ms);
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <gtest/gtest.h>
+#include <s3cpp/retry.h>
+#include <s3cpp/s3.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(RETRY, Causes) {
+    EXPECT_EQ(retryCause(503, "SlowDown", true), RetryCause::Throttling);
+    EXPECT_EQ(retryCause(503, "SlowDown", false), RetryCause::Throttling);
+    EXPECT_EQ(retryCause(429, "", false), RetryCause::Throttling);
+    EXPECT_EQ(retryCause(500, "InternalError", true), RetryCause::ServerError);
+    EXPECT_EQ(retryCause(500, "InternalError", false), RetryCause::None);
+    EXPECT_EQ(retryCause(400, "RequestTimeout", true), RetryCause::Timeout);
+    EXPECT_EQ(retryCause(404, "NoSuchKey", true), RetryCause::None);
+    EXPECT_EQ(retryCause(403, "AccessDenied", true), RetryCause::None);
+
+    // Only failures before anything was sent are safe for non idempotent requests
+    EXPECT_EQ(retryCause(CURLE_COULDNT_CONNECT, false), RetryCause::Transport);
+    EXPECT_EQ(retryCause(CURLE_RECV_ERROR, true), RetryCause::Transport);
+    EXPECT_EQ(retryCause(CURLE_RECV_ERROR, false), RetryCause::None);
+    EXPECT_EQ(retryCause(CURLE_OPERATION_TIMEDOUT, true), RetryCause::Timeout);
+    EXPECT_EQ(retryCause(CURLE_WRITE_ERROR, true), RetryCause::None);
+}
+
+TEST(RETRY, Budget) {
+    RetryBudget budget(12);
+    EXPECT_TRUE(budget.acquire(5));
+    EXPECT_TRUE(budget.acquire(5));
+    EXPECT_FALSE(budget.acquire(5));
+    EXPECT_EQ(budget.available(), 2);
+    budget.release(5);
+    EXPECT_TRUE(budget.acquire(5));
+    budget.release(100);
+    EXPECT_EQ(budget.available(), budget.capacity());
+}
+
+TEST(RETRY, BudgetConcurrent) {
+    RetryBudget budget(1000);
+    std::vector<std::thread> threads;
+    std::atomic<int> acquired = 0;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 100; j++)
+                acquired += budget.acquire(5);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(acquired, 200);
+    EXPECT_EQ(budget.available(), 0);
+}
+
+TEST(RETRY, Backoff) {
+    RetryBackoff backoff(10ms, 1000ms);
+    std::chrono::milliseconds previous = 10ms;
+    for (int i = 0; i < 100; i++) {
+        const std::chrono::milliseconds delay = backoff.next();
+        EXPECT_GE(delay, 10ms);
+        EXPECT_LE(delay, std::min(1000ms, previous * 3));
+        previous = delay;
+    }
+}
+
+TEST(RETRY, TransportErrorsRetried) {
+    // Nothing listens there, connections are refused right away
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:1", S3AddressingStyle::PathStyle);
+    client.SetRetryOptions(RetryOptions { .MaxAttempts = 3, .BaseDelay = 20ms, .MaxDelay = 20ms });
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(client.HeadBucket("bucket"), std::runtime_error);
+    // Two retries, 20ms apart
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 40ms);
+
+    // An empty budget leaves the failure as it is
+    client.SetRetryOptions(RetryOptions { .MaxAttempts = 3, .BaseDelay = 1000ms, .MaxDelay = 1000ms, .RetryBudget = 0 });
+    start = std::chrono::steady_clock::now();
+    EXPECT_THROW(client.HeadBucket("bucket"), HttpTransportError);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1000ms);
+}
@@ -1,6 +1,10 @@
 #include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
 #include <s3cpp/s3.h>
+#include <sstream>
 #include <string>
+#include <vector>
 
 class S3 : public ::testing::Test {
     // Setup a MinIO bucket with some contents already
@@ -98,6 +102,63 @@ TEST_F(S3, ListObjectsCheckFields) {
     EXPECT_EQ(res->Contents[1].StorageClass, "STANDARD");
 }
 
+TEST_F(S3, ListObjectsCompact) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    auto res = client.ListObjectsCompact("my-bucket", { .MaxKeys = 100, .Prefix = "path/to/" });
+    auto full = client.ListObjects("my-bucket", { .MaxKeys = 100, .Prefix = "path/to/" });
+    if (!res || !full)
+        GTEST_FAIL();
+
+    EXPECT_EQ(res->Name, "my-bucket");
+    EXPECT_EQ(res->Prefix, "path/to/");
+    EXPECT_TRUE(res->IsTruncated);
+    EXPECT_EQ(res->NextContinuationToken, full->NextContinuationToken);
+    ASSERT_EQ(res->size(), full->Contents.size());
+    for (size_t i = 0; i < res->size(); i++) {
+        EXPECT_EQ(res->Keys[i], full->Contents[i].Key);
+        EXPECT_EQ(res->ETags[i], full->Contents[i].ETag);
+        EXPECT_EQ(res->Sizes[i], full->Contents[i].Size);
+        EXPECT_EQ(res->attributes(i).StorageClass, full->Contents[i].StorageClass);
+    }
+    // Every object shares the same attributes
+    EXPECT_EQ(res->Attributes.size(), 1);
+}
+
+TEST_F(S3, DeserializeCompactListObjectsResult) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    auto res = client.deserializeCompactListObjectsResult(
+        "<ListBucketResult><Name>b</Name><KeyCount>3</KeyCount><IsTruncated>false</IsTruncated>"
+        "<Contents><Key>a&amp;b</Key><LastModified>2009-10-12T17:50:30.000Z</LastModified><Size>434234</Size>"
+        "<StorageClass>STANDARD</StorageClass><Owner><ID>o1</ID></Owner></Contents>"
+        "<Contents><Key>c</Key><LastModified>1970-01-01T00:00:01.5Z</LastModified><Size>0</Size>"
+        "<StorageClass>GLACIER</StorageClass><Owner><ID>o1</ID></Owner></Contents>"
+        "<Contents><Key>d</Key><LastModified>2024-02-29T23:59:59Z</LastModified><Size>1</Size>"
+        "<StorageClass>STANDARD</StorageClass><Owner><ID>o1</ID></Owner></Contents>"
+        "<CommonPrefixes><Prefix>logs/</Prefix></CommonPrefixes></ListBucketResult>",
+        1000);
+    if (!res)
+        GTEST_FAIL();
+
+    using namespace std::chrono;
+    EXPECT_EQ(res->Name, "b");
+    EXPECT_EQ(res->KeyCount, 3);
+    ASSERT_EQ(res->size(), 3);
+    EXPECT_EQ(res->Keys[0], "a&b");
+    EXPECT_EQ(res->Sizes[0], 434234);
+    EXPECT_EQ(res->LastModified[0], sys_days(2009y / 10 / 12) + 17h + 50min + 30s);
+    EXPECT_EQ(res->LastModified[1], sys_time<milliseconds>(1500ms));
+    EXPECT_EQ(res->LastModified[2], sys_days(2024y / 2 / 29) + 23h + 59min + 59s);
+    ASSERT_EQ(res->Attributes.size(), 2);
+    EXPECT_EQ(res->AttributeIndexes, (std::vector<uint32_t> { 0, 1, 0 }));
+    EXPECT_EQ(res->attributes(1).StorageClass, "GLACIER");
+    EXPECT_EQ(res->attributes(2).OwnerID, "o1");
+    EXPECT_EQ(res->attributes(0).OwnerID.data(), res->attributes(1).OwnerID.data());
+    EXPECT_EQ(res->CommonPrefixes, (std::vector<std::string_view> { "logs/" }));
+
+    EXPECT_ANY_THROW(client.deserializeCompactListObjectsResult(
+        "<ListBucketResult><Contents><LastModified>2009-13-12T17:50:30.000Z</LastModified></Contents></ListBucketResult>", 1000));
+}
+
 TEST_F(S3, ListObjectsCheckLenKeys) {
     S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
     // has 1001 objects - limit is 1000 keys
@@ -134,6 +195,79 @@ TEST_F(S3, ListObjectsPaginator) {
     EXPECT_EQ(pageCount, 11);
 }
 
+TEST_F(S3, PrefetchingListObjectsPaginator) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    ListObjectsPaginator reference(client, "my-bucket", "path/to/", 100);
+    std::vector<std::string> expected;
+    while (reference.HasMorePages()) {
+        auto page = reference.NextPage();
+        if (!page)
+            GTEST_FAIL();
+        for (const auto& object : page->Contents)
+            expected.push_back(object.Key);
+    }
+
+    for (size_t depth : { 1, 3 }) {
+        PrefetchingListObjectsPaginator paginator(client, "my-bucket", "path/to/", 100, depth);
+        std::vector<std::string> keys;
+        int pageCount = 0;
+        while (paginator.HasMorePages()) {
+            auto page = paginator.NextPage();
+            if (!page)
+                GTEST_FAIL();
+            pageCount++;
+            for (const auto& object : page->Contents)
+                keys.push_back(object.Key);
+        }
+        EXPECT_EQ(pageCount, 11);
+        EXPECT_EQ(keys, expected);
+
+        auto past = paginator.NextPage();
+        ASSERT_FALSE(past);
+        EXPECT_EQ(past.error().Code, "NoMorePages");
+    }
+}
+
+TEST_F(S3, PrefetchingListObjectsPaginatorStopsEarly) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    // Destroyed with pages still to come
+    PrefetchingListObjectsPaginator paginator(client, "my-bucket", "path/to/", 10, 2);
+    auto page = paginator.NextPage();
+    if (!page)
+        GTEST_FAIL();
+    EXPECT_EQ(page->Contents.size(), 10);
+    EXPECT_TRUE(paginator.HasMorePages());
+}
+
+TEST_F(S3, PrefetchingListObjectsPaginatorBucketNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    PrefetchingListObjectsPaginator paginator(client, "does-not-exist", "", 100, 2);
+    ASSERT_TRUE(paginator.HasMorePages());
+    auto page = paginator.NextPage();
+    EXPECT_FALSE(page);
+    EXPECT_FALSE(paginator.HasMorePages());
+}
+
+TEST_F(S3, ListAll) {
+    static_assert(std::ranges::input_range<ListObjectsRange>);
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    size_t count = 0;
+    for (const Contents_& object : client.ListAll("my-bucket", "path/to/")) {
+        EXPECT_TRUE(object.Key.starts_with("path/to/"));
+        count++;
+    }
+    EXPECT_EQ(count, 1001);
+
+    // Nothing under the prefix
+    auto empty = client.ListAll("my-bucket", "nothing/here/");
+    EXPECT_TRUE(empty.begin() == empty.end());
+
+    EXPECT_THROW(
+        for (const auto& object : client.ListAll("does-not-exist")) { (void)object; },
+        std::runtime_error);
+}
+
 TEST_F(S3, GetObjectExists) {
     S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
     auto response = client.GetObject("my-bucket", "path/to/file_1.txt");
@@ -142,6 +276,24 @@ TEST_F(S3, GetObjectExists) {
     }
 }
 
+TEST_F(S3, GetObjectHedged) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    // Hedge every request right away, the loser is cancelled
+    client.SetHedging({ .initial_delay = std::chrono::milliseconds(0), .min_delay = std::chrono::milliseconds(0), .max_ratio = 1, .burst = 100 });
+    for (int i = 1; i <= 20; i++) {
+        auto response = client.GetObject("my-bucket", std::format("path/to/file_{}.txt", i));
+        ASSERT_TRUE(response);
+        EXPECT_EQ(*response, std::format("This is test file number {}", i));
+    }
+    EXPECT_TRUE(client.HeadObject("my-bucket", "path/to/file_1.txt"));
+    EXPECT_FALSE(client.HeadObject("my-bucket", "does/not/exists.txt"));
+
+    const HttpHedgingStats stats = client.HedgingStats();
+    EXPECT_EQ(stats.requests, 22);
+    EXPECT_GT(stats.hedged, 0);
+    EXPECT_LE(stats.won, stats.hedged);
+}
+
 TEST_F(S3, GetObjectNotExists) {
     S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
     auto response = client.GetObject("my-bucket", "does/not/exists.txt");
@@ -455,3 +607,507 @@ TEST_F(S3, ListBuckets) {
         FAIL() << std::format("ListBuckets request failed. Code={}, Message={}", res.error().Code, res.error().Message);
     }
 }
+
+TEST_F(S3, GetObjectAsync) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // Keep many requests in flight on the event loop at once
+    std::vector<std::future<std::expected<std::string, Error>>> futures;
+    for (int i = 1; i <= 100; i++)
+        futures.push_back(client.GetObjectAsync("my-bucket", std::format("path/to/file_{}.txt", i)));
+
+    for (int i = 1; i <= 100; i++) {
+        auto res = futures[i - 1].get();
+        if (!res)
+            FAIL() << std::format("GetObjectAsync request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+        EXPECT_EQ(res.value(), std::format("This is test file number {}", i));
+    }
+}
+
+TEST_F(S3, HeadObjectAsyncNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto res = client.HeadObjectAsync("my-bucket", "does/not/exist/file.txt").get();
+    if (res.has_value())
+        FAIL() << "HeadObjectAsync request succeeded when it should have failed for non-existent object";
+
+    EXPECT_EQ(res.error().Code, "NoSuchKey");
+}
+
+TEST_F(S3, PutDeleteObjectAsync) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto putRes = client.PutObjectAsync("my-bucket", "async/file.txt", "hello, from the event loop").get();
+    if (!putRes)
+        FAIL() << std::format("PutObjectAsync request failed: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+    EXPECT_EQ(client.GetObject("my-bucket", "async/file.txt").value_or(""), "hello, from the event loop");
+
+    auto delRes = client.DeleteObjectAsync("my-bucket", "async/file.txt").get();
+    if (!delRes)
+        FAIL() << std::format("DeleteObjectAsync request failed: Code={}, Message={}", delRes.error().Code, delRes.error().Message);
+}
+
+TEST_F(S3, CoroutineGetHeadObject) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto sizes = [](S3Client& client) -> Task<int64_t> {
+        int64_t total = 0;
+        for (int i = 1; i <= 10; i++) {
+            const std::string key = std::format("path/to/file_{}.txt", i);
+            auto head = co_await client.HeadObjectTask("my-bucket", key);
+            auto body = co_await client.GetObjectTask("my-bucket", key);
+            if (!head || !body || head->ContentLength != static_cast<int64_t>(body->size()))
+                co_return -1;
+            total += head->ContentLength;
+        }
+        co_return total;
+    };
+
+    // "This is test file number 1" is 26 bytes, 27 from file_10.txt onwards
+    EXPECT_EQ(sync_wait(sizes(client)), 9 * 26 + 27);
+}
+
+TEST_F(S3, CoroutineCustomExecutor) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    client.SetExecutor(std::make_shared<InlineExecutor>());
+
+    auto res = sync_wait(client.GetObjectTask("my-bucket", "does/not/exists.txt"));
+    if (res)
+        FAIL() << "GetObjectTask request succeeded when it should have failed for non-existent object";
+    EXPECT_EQ(res.error().Code, "NoSuchKey");
+}
+
+TEST_F(S3, GetObjectStreamToSink) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    std::string body;
+    size_t chunks = 0;
+    auto res = client.GetObject("my-bucket", "path/to/file_1.txt", [&](std::string_view chunk) {
+        body.append(chunk);
+        chunks++;
+        return true;
+    });
+    if (!res)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+
+    EXPECT_EQ(body, "This is test file number 1");
+    EXPECT_GE(chunks, 1);
+    EXPECT_EQ(res->ContentLength, 26);
+    EXPECT_FALSE(res->ETag.empty());
+}
+
+TEST_F(S3, GetObjectStreamToOstream) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    std::ostringstream out;
+    auto res = client.GetObject("my-bucket", "path/to/file_2.txt", out, { .Range = "bytes=0-3" });
+    if (!res)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_EQ(out.str(), "This");
+}
+
+TEST_F(S3, GetObjectStreamNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // Error bodies never reach the sink
+    bool called = false;
+    auto res = client.GetObject("my-bucket", "does/not/exists.txt", [&](std::string_view) {
+        called = true;
+        return true;
+    });
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "NoSuchKey");
+    EXPECT_FALSE(called);
+}
+
+TEST_F(S3, GetObjectStreamSinkStops) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto res = client.GetObject("my-bucket", "path/to/file_1.txt", [](std::string_view) { return false; });
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "SinkStopped");
+}
+
+TEST_F(S3, GetObjectInto) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    std::vector<std::byte> buffer(64);
+    auto res = client.GetObjectInto("my-bucket", "path/to/file_1.txt", buffer);
+    if (!res)
+        FAIL() << std::format("GetObjectInto request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+
+    EXPECT_EQ(res->ContentLength, 26);
+    EXPECT_EQ(std::string_view(reinterpret_cast<const char*>(buffer.data()), res->ContentLength), "This is test file number 1");
+}
+
+TEST_F(S3, GetObjectIntoBufferTooSmall) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    std::vector<std::byte> buffer(8);
+    auto res = client.GetObjectInto("my-bucket", "path/to/file_1.txt", buffer);
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "BufferTooSmall");
+}
+
+TEST_F(S3, PutObjectFromFile) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // Large enough for cURL to go through `Expect: 100-continue`
+    std::string body(3 * 1024 * 1024 + 17, '\0');
+    for (size_t i = 0; i < body.size(); i++)
+        body[i] = static_cast<char>('a' + i % 26);
+    std::string path = std::format("{}/s3cpp_put_from_file.bin", testing::TempDir());
+    std::ofstream(path, std::ios::binary) << body;
+
+    auto putRes = client.PutObjectFromFile("my-bucket", "stream/file.bin", path, { .ContentType = "application/octet-stream" });
+    std::remove(path.c_str());
+    if (!putRes)
+        FAIL() << std::format("PutObjectFromFile request failed: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "stream/file.bin");
+    if (!getRes)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", getRes.error().Code, getRes.error().Message);
+    EXPECT_EQ(getRes->size(), body.size());
+    EXPECT_TRUE(*getRes == body);
+
+    auto delRes = client.DeleteObject("my-bucket", "stream/file.bin");
+    if (!delRes)
+        FAIL() << std::format("DeleteObject request failed: Code={}, Message={}", delRes.error().Code, delRes.error().Message);
+}
+
+TEST_F(S3, PutObjectFromFileNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto res = client.PutObjectFromFile("my-bucket", "stream/missing.bin", "/does/not/exist.bin");
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "InvalidFile");
+}
+
+TEST_F(S3, PutObjectFromReader) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    const std::string body = "hello, from a read callback";
+    size_t offset = 0;
+    auto putRes = client.PutObject("my-bucket", "stream/reader.txt", [&](char* buffer, size_t size) -> std::ptrdiff_t {
+        size_t n = std::min(size, body.size() - offset);
+        std::copy_n(body.data() + offset, n, buffer);
+        offset += n;
+        return n;
+    },
+        body.size());
+    if (!putRes)
+        FAIL() << std::format("PutObject request failed: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "stream/reader.txt");
+    if (!getRes)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", getRes.error().Code, getRes.error().Message);
+    EXPECT_EQ(*getRes, body);
+
+    auto delRes = client.DeleteObject("my-bucket", "stream/reader.txt");
+    if (!delRes)
+        FAIL() << std::format("DeleteObject request failed: Code={}, Message={}", delRes.error().Code, delRes.error().Message);
+}
+
+TEST_F(S3, PutObjectStreamingSignature) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+    client.SetPayloadSigning(PayloadSigning::Streaming);
+
+    // A few aws-chunked chunks and a shorter last one
+    std::string body(3 * AWSSigV4Signer::StreamingChunkSize + 123, '\0');
+    for (size_t i = 0; i < body.size(); i++)
+        body[i] = static_cast<char>(i % 251);
+    const std::string path = std::format("{}/s3cpp_put_chunked.bin", testing::TempDir());
+    std::ofstream(path, std::ios::binary) << body;
+
+    auto putRes = client.PutObjectFromFile("my-bucket", "stream/chunked.bin", path);
+    std::remove(path.c_str());
+    if (!putRes)
+        FAIL() << std::format("PutObject request failed: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "stream/chunked.bin");
+    if (!getRes)
+        GTEST_FAIL();
+    EXPECT_TRUE(*getRes == body);
+
+    client.DeleteObject("my-bucket", "stream/chunked.bin");
+}
+
+TEST_F(S3, PutObjectChecksum) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // In memory, computed upfront and sent as a header
+    auto putRes = client.PutObject("my-bucket", "checksum/inline.txt", "123456789", { .SDKChecksumAlgorithm = "CRC32C" });
+    if (!putRes)
+        FAIL() << std::format("PutObject request failed: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+    EXPECT_EQ(putRes->ChecksumCRC32C, "4waSgw==");
+
+    auto getRes = client.GetObject("my-bucket", "checksum/inline.txt", { .CheckSumMode = "ENABLED" });
+    if (!getRes)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", getRes.error().Code, getRes.error().Message);
+    EXPECT_EQ(*getRes, "123456789");
+
+    // Streamed, computed while sending and sent as a trailer
+    std::string body(2 * AWSSigV4Signer::StreamingChunkSize + 7, '\0');
+    for (size_t i = 0; i < body.size(); i++)
+        body[i] = static_cast<char>(i % 251);
+    const std::string path = std::format("{}/s3cpp_put_checksum.bin", testing::TempDir());
+    std::ofstream(path, std::ios::binary) << body;
+
+    for (PayloadSigning mode : { PayloadSigning::Signed, PayloadSigning::Streaming }) {
+        client.SetPayloadSigning(mode);
+        putRes = client.PutObjectFromFile("my-bucket", "checksum/streamed.bin", path, { .SDKChecksumAlgorithm = "CRC64NVME" });
+        if (!putRes)
+            FAIL() << std::format("PutObject request failed: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+        Checksum expected(ChecksumAlgorithm::CRC64NVME);
+        expected.update(body);
+        EXPECT_EQ(putRes->ChecksumCRC64NVME, expected.base64());
+
+        std::string downloaded;
+        auto streamRes = client.GetObject("my-bucket", "checksum/streamed.bin", [&downloaded](std::string_view chunk) {
+            downloaded += chunk;
+            return true;
+        },
+            { .CheckSumMode = "ENABLED" });
+        if (!streamRes)
+            FAIL() << std::format("GetObject request failed: Code={}, Message={}", streamRes.error().Code, streamRes.error().Message);
+        EXPECT_EQ(streamRes->ChecksumCRC64NVME, expected.base64());
+        EXPECT_TRUE(downloaded == body);
+    }
+    std::remove(path.c_str());
+
+    // Only CRC32C and CRC64NVME are computed by the client
+    putRes = client.PutObject("my-bucket", "checksum/inline.txt", "123456789", { .SDKChecksumAlgorithm = "SHA1" });
+    ASSERT_FALSE(putRes);
+    EXPECT_EQ(putRes.error().Code, "InvalidArgument");
+
+    client.DeleteObject("my-bucket", "checksum/inline.txt");
+    client.DeleteObject("my-bucket", "checksum/streamed.bin");
+}
+
+TEST_F(S3, PresignGetObject) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto putRes = client.PutObject("my-bucket", "presign/hello.txt", "shared through a link");
+    if (!putRes)
+        GTEST_FAIL();
+
+    auto url = client.PresignGetObject("my-bucket", "presign/hello.txt", std::chrono::minutes(5), { .response_content_type = "text/plain" });
+    if (!url)
+        FAIL() << std::format("PresignGetObject failed: Code={}, Message={}", url.error().Code, url.error().Message);
+    EXPECT_TRUE(url->starts_with("http://127.0.0.1:9000/my-bucket/presign/hello.txt?"));
+    EXPECT_TRUE(url->contains("response-content-type=text%2Fplain"));
+    EXPECT_TRUE(url->contains("X-Amz-Expires=300"));
+    EXPECT_TRUE(url->contains("&X-Amz-Signature="));
+
+    // Anyone with the link, no credentials
+    HttpClient http {};
+    HttpResponse res = http.get(*url).execute();
+    EXPECT_EQ(res.status(), 200);
+    EXPECT_EQ(res.body(), "shared through a link");
+
+    client.DeleteObject("my-bucket", "presign/hello.txt");
+}
+
+TEST_F(S3, PresignGetObjects) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    const std::vector<std::string> keys = { "presign/a.txt", "presign/with space.txt" };
+    auto urls = client.PresignGetObjects("my-bucket", keys, std::chrono::hours(1));
+    if (!urls)
+        GTEST_FAIL();
+    ASSERT_EQ(urls->size(), 2);
+    EXPECT_TRUE((*urls)[0].starts_with("http://127.0.0.1:9000/my-bucket/presign/a.txt?"));
+    EXPECT_TRUE((*urls)[1].starts_with("http://127.0.0.1:9000/my-bucket/presign/with%20space.txt?"));
+
+    auto tooLong = client.PresignPutObject("my-bucket", "presign/a.txt", std::chrono::days(8));
+    if (tooLong)
+        GTEST_FAIL();
+    EXPECT_EQ(tooLong.error().Code, "InvalidArgument");
+}
+
+TEST_F(S3, MultipartUpload) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto created = client.CreateMultipartUpload("my-bucket", "multipart/parts.txt", { .ContentType = "text/plain" });
+    if (!created)
+        FAIL() << std::format("CreateMultipartUpload request failed: Code={}, Message={}", created.error().Code, created.error().Message);
+    EXPECT_EQ(created->Key, "multipart/parts.txt");
+    EXPECT_FALSE(created->UploadId.empty());
+
+    // S3 wants every part but the last one to be at least 5 MiB
+    const std::vector<std::string> bodies = { std::string(5 * 1024 * 1024, 'a'), "part 2;" };
+
+    // Uploaded out of order on purpose
+    std::vector<CompletedPart> parts;
+    for (int partNumber : { 2, 1 }) {
+        auto part = client.UploadPart("my-bucket", "multipart/parts.txt", created->UploadId, partNumber, bodies[partNumber - 1]);
+        if (!part)
+            FAIL() << std::format("UploadPart request failed: Code={}, Message={}", part.error().Code, part.error().Message);
+        EXPECT_FALSE(part->ETag.empty());
+        parts.insert(parts.begin(), CompletedPart { .PartNumber = partNumber, .ETag = part->ETag });
+    }
+
+    auto completed = client.CompleteMultipartUpload("my-bucket", "multipart/parts.txt", created->UploadId, parts);
+    if (!completed)
+        FAIL() << std::format("CompleteMultipartUpload request failed: Code={}, Message={}", completed.error().Code, completed.error().Message);
+    EXPECT_EQ(completed->Key, "multipart/parts.txt");
+
+    auto getRes = client.GetObject("my-bucket", "multipart/parts.txt");
+    if (!getRes)
+        GTEST_FAIL();
+    EXPECT_EQ(getRes->size(), bodies[0].size() + bodies[1].size());
+    EXPECT_TRUE(*getRes == bodies[0] + bodies[1]);
+
+    client.DeleteObject("my-bucket", "multipart/parts.txt");
+}
+
+TEST_F(S3, CopyObject) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto putRes = client.PutObject("my-bucket", "copy/source.txt", "copied server-side");
+    if (!putRes)
+        GTEST_FAIL();
+
+    auto res = client.CopyObject("my-bucket", "copy/source.txt", "my-bucket", "copy/destination.txt");
+    if (!res)
+        FAIL() << std::format("CopyObject request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_EQ(res->ETag, putRes->ETag);
+    EXPECT_FALSE(res->LastModified.empty());
+
+    auto getRes = client.GetObject("my-bucket", "copy/destination.txt");
+    if (!getRes)
+        GTEST_FAIL();
+    EXPECT_EQ(*getRes, "copied server-side");
+
+    client.DeleteObject("my-bucket", "copy/source.txt");
+    client.DeleteObject("my-bucket", "copy/destination.txt");
+}
+
+TEST_F(S3, UploadPartCopy) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // A 5 MiB part, the smallest S3 takes for any but the last one, and a short tail
+    const std::string body = "0123456789" + std::string(5 * 1024 * 1024, 'x');
+    auto putRes = client.PutObject("my-bucket", "copy/parts-source.txt", body);
+    if (!putRes)
+        GTEST_FAIL();
+
+    auto created = client.CreateMultipartUpload("my-bucket", "copy/parts.txt");
+    if (!created)
+        GTEST_FAIL();
+
+    // The tail of the source moved to the front
+    const std::string head = std::format("bytes=10-{}", body.size() - 1);
+    std::vector<CompletedPart> parts;
+    for (auto [partNumber, range] : { std::pair<int, std::string> { 1, head }, std::pair<int, std::string> { 2, "bytes=0-9" } }) {
+        auto part = client.UploadPartCopy("my-bucket", "copy/parts.txt", created->UploadId, partNumber, "my-bucket", "copy/parts-source.txt", { .CopySourceRange = range });
+        if (!part)
+            FAIL() << std::format("UploadPartCopy request failed: Code={}, Message={}", part.error().Code, part.error().Message);
+        EXPECT_FALSE(part->ETag.empty());
+        parts.push_back(CompletedPart { .PartNumber = partNumber, .ETag = part->ETag });
+    }
+
+    auto completed = client.CompleteMultipartUpload("my-bucket", "copy/parts.txt", created->UploadId, parts);
+    if (!completed)
+        GTEST_FAIL();
+
+    auto getRes = client.GetObject("my-bucket", "copy/parts.txt");
+    if (!getRes)
+        GTEST_FAIL();
+    EXPECT_EQ(getRes->size(), body.size());
+    EXPECT_TRUE(*getRes == body.substr(10) + body.substr(0, 10));
+
+    client.DeleteObject("my-bucket", "copy/parts-source.txt");
+    client.DeleteObject("my-bucket", "copy/parts.txt");
+}
+
+TEST_F(S3, AbortMultipartUpload) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto created = client.CreateMultipartUpload("my-bucket", "multipart/aborted.txt");
+    if (!created)
+        GTEST_FAIL();
+    auto part = client.UploadPart("my-bucket", "multipart/aborted.txt", created->UploadId, 1, "never completed");
+    if (!part)
+        GTEST_FAIL();
+
+    auto res = client.AbortMultipartUpload("my-bucket", "multipart/aborted.txt", created->UploadId);
+    if (!res)
+        FAIL() << std::format("AbortMultipartUpload request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+}
+
+TEST_F(S3, DeleteObjects) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    const std::vector<std::string> keys = { "batch/a.txt", "batch/b.txt", "batch/c.txt" };
+    for (const auto& key : keys) {
+        auto putRes = client.PutObject("my-bucket", key, "Body contents");
+        if (!putRes)
+            FAIL() << std::format("Unable to put object: Code={}, Message={}", putRes.error().Code, putRes.error().Message);
+    }
+
+    auto res = client.DeleteObjects("my-bucket", keys);
+    if (!res)
+        FAIL() << std::format("DeleteObjects request failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_TRUE(res->Errors.empty());
+    ASSERT_EQ(res->Deleted.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+        EXPECT_EQ(res->Deleted[i].Key, keys[i]);
+
+    auto listRes = client.ListObjects("my-bucket", { .Prefix = "batch/" });
+    if (!listRes)
+        GTEST_FAIL();
+    EXPECT_TRUE(listRes->Contents.empty());
+}
+
+TEST_F(S3, DeleteObjectsTooManyKeys) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    std::vector<std::string> keys(1001, "batch/key");
+    auto res = client.DeleteObjects("my-bucket", keys);
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "InvalidArgument");
+}
+
+TEST_F(S3, DeserializeDeleteObjectsResult) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    auto res = client.deserializeDeleteObjectsResult(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<DeleteResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+        "<Deleted><Key>a</Key><DeleteMarker>true</DeleteMarker></Deleted>"
+        "<Error><Key>b</Key><Code>AccessDenied</Code><Message>Access Denied</Message></Error>"
+        "<Deleted><Key>c</Key><NewerField>ignored</NewerField></Deleted>"
+        "</DeleteResult>");
+    if (!res)
+        GTEST_FAIL();
+    ASSERT_EQ(res->Deleted.size(), 2);
+    EXPECT_EQ(res->Deleted[0].Key, "a");
+    EXPECT_TRUE(res->Deleted[0].DeleteMarker);
+    EXPECT_EQ(res->Deleted[1].Key, "c");
+    EXPECT_FALSE(res->Deleted[1].DeleteMarker);
+    ASSERT_EQ(res->Errors.size(), 1);
+    EXPECT_EQ(res->Errors[0].Key, "b");
+    EXPECT_EQ(res->Errors[0].Code, "AccessDenied");
+}
+
+TEST_F(S3, DeserializeErrorInSuccessfulResponse) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // CompleteMultipartUpload can fail after a 200 has been sent
+    auto res = client.deserializeCompleteMultipartUploadResult(
+        "<Error><Code>InternalError</Code><Message>We encountered an internal error.</Message><RequestId>7</RequestId></Error>");
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "InternalError");
+    EXPECT_EQ(res.error().Message, "We encountered an internal error.");
+    EXPECT_EQ(res.error().RequestId, 7);
+
+    Error error = client.deserializeError("<Error><Code>NoSuchKey</Code><Resource>/my-bucket/k</Resource></Error>");
+    EXPECT_EQ(error.Code, "NoSuchKey");
+    EXPECT_EQ(error.Resource, "/my-bucket/k");
+}
@@ -0,0 +1,74 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include <s3cpp/task.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Hands the coroutine over to another thread, as the HttpClient event loop would
+struct ResumeOn {
+    Executor& executor;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { executor.schedule(handle); }
+    void await_resume() const noexcept { }
+};
+
+Task<int> answer() {
+    co_return 42;
+}
+
+Task<std::string> nested() {
+    int a = co_await answer();
+    int b = co_await answer();
+    co_return std::to_string(a + b);
+}
+
+TEST(TASK, SyncWaitValue) {
+    EXPECT_EQ(sync_wait(answer()), 42);
+    EXPECT_EQ(sync_wait(nested()), "84");
+}
+
+TEST(TASK, TaskIsLazy) {
+    bool started = false;
+    auto task = [](bool& started) -> Task<void> {
+        started = true;
+        co_return;
+    }(started);
+    EXPECT_FALSE(started);
+    sync_wait(std::move(task));
+    EXPECT_TRUE(started);
+}
+
+TEST(TASK, ExceptionPropagates) {
+    auto failing = []() -> Task<int> {
+        throw std::runtime_error("libcurl error: Couldn't connect to server");
+        co_return 0;
+    };
+    EXPECT_THROW(sync_wait(failing()), std::runtime_error);
+}
+
+TEST(TASK, ResumeOnThreadPool) {
+    ThreadPoolExecutor executor(2);
+    auto caller = std::this_thread::get_id();
+    auto task = [](Executor& executor) -> Task<std::thread::id> {
+        co_await ResumeOn { executor };
+        co_return std::this_thread::get_id();
+    }(executor);
+    EXPECT_NE(sync_wait(std::move(task)), caller);
+}
+
+TEST(TASK, ManyTasksOnFewThreads) {
+    ThreadPoolExecutor executor(2);
+    std::atomic<int> completed = 0;
+    auto worker = [](Executor& executor, std::atomic<int>& completed) -> Task<void> {
+        for (int i = 0; i < 10; i++)
+            co_await ResumeOn { executor };
+        completed++;
+    };
+    auto all = [&]() -> Task<void> {
+        for (int i = 0; i < 1000; i++)
+            co_await worker(executor, completed);
+    };
+    sync_wait(all());
+    EXPECT_EQ(completed, 1000);
+}
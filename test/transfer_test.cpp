@@ -0,0 +1,349 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <netinet/in.h>
+#include <s3cpp/transfer.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+class TRANSFER : public ::testing::Test {
+protected:
+    static void SetUpTestCase() {
+        S3Client client = S3Client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+        // Skip if already created
+        client.CreateBucket("my-bucket");
+    }
+
+    // Deterministic body that makes misplaced parts show up
+    static std::string makeBody(size_t size) {
+        std::string body(size, '\0');
+        for (size_t i = 0; i < size; i++)
+            body[i] = static_cast<char>((i * 31 + i / 4096) % 251);
+        return body;
+    }
+};
+
+TEST_F(TRANSFER, MultipartUploadFile) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // 3 parts of 5 MiB and a smaller last one
+    const std::string body = makeBody(15 * 1024 * 1024 + 1234);
+    const std::string path = std::format("{}/s3cpp_multipart_upload.bin", testing::TempDir());
+    std::ofstream(path, std::ios::binary) << body;
+
+    MultipartUploader uploader(client, { .PartSize = 5 * 1024 * 1024, .Concurrency = 4 });
+    auto res = uploader.UploadFile("my-bucket", "multipart/file.bin", path);
+    std::remove(path.c_str());
+    if (!res)
+        FAIL() << std::format("UploadFile failed: Code={}, Message={}", res.error().Code, res.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "multipart/file.bin");
+    if (!getRes)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", getRes.error().Code, getRes.error().Message);
+    EXPECT_EQ(getRes->size(), body.size());
+    EXPECT_TRUE(*getRes == body);
+
+    client.DeleteObject("my-bucket", "multipart/file.bin");
+}
+
+TEST_F(TRANSFER, MultipartUploadFromSource) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // Exactly two parts, the reader has to notice the end on a part boundary
+    const std::string body = makeBody(2 * 5 * 1024 * 1024);
+    size_t offset = 0;
+    auto source = [&](char* buffer, size_t size) -> std::ptrdiff_t {
+        size_t n = std::min({ size, body.size() - offset, size_t(64 * 1024) });
+        std::copy_n(body.data() + offset, n, buffer);
+        offset += n;
+        return n;
+    };
+
+    MultipartUploader uploader(client, { .PartSize = 5 * 1024 * 1024, .Concurrency = 2 });
+    auto res = uploader.Upload("my-bucket", "multipart/source.bin", source);
+    if (!res)
+        FAIL() << std::format("Upload failed: Code={}, Message={}", res.error().Code, res.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "multipart/source.bin");
+    if (!getRes)
+        FAIL() << std::format("GetObject request failed: Code={}, Message={}", getRes.error().Code, getRes.error().Message);
+    EXPECT_TRUE(*getRes == body);
+
+    client.DeleteObject("my-bucket", "multipart/source.bin");
+}
+
+TEST_F(TRANSFER, MultipartUploadEmptySource) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    MultipartUploader uploader(client);
+    auto res = uploader.Upload("my-bucket", "multipart/empty.bin", [](char*, size_t) -> std::ptrdiff_t { return 0; });
+    if (!res)
+        FAIL() << std::format("Upload failed: Code={}, Message={}", res.error().Code, res.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "multipart/empty.bin");
+    if (!getRes)
+        GTEST_FAIL();
+    EXPECT_TRUE(getRes->empty());
+
+    client.DeleteObject("my-bucket", "multipart/empty.bin");
+}
+
+TEST_F(TRANSFER, MultipartUploadSourceFails) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    MultipartUploader uploader(client);
+    auto res = uploader.Upload("my-bucket", "multipart/failed.bin", [](char*, size_t) -> std::ptrdiff_t { return -1; });
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "InvalidInput");
+
+    // Aborted, nothing was created
+    auto getRes = client.GetObject("my-bucket", "multipart/failed.bin");
+    EXPECT_FALSE(getRes.has_value());
+}
+
+TEST_F(TRANSFER, MultipartUploadFileNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    MultipartUploader uploader(client);
+    auto res = uploader.UploadFile("my-bucket", "multipart/missing.bin", "/does/not/exist.bin");
+    if (res)
+        GTEST_FAIL();
+    EXPECT_EQ(res.error().Code, "InvalidFile");
+}
+
+TEST_F(TRANSFER, ParallelDownloadFile) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    const std::string body = makeBody(3 * 1024 * 1024 + 77);
+    auto putRes = client.PutObject("my-bucket", "download/file.bin", body);
+    if (!putRes)
+        GTEST_FAIL();
+
+    const std::string path = std::format("{}/s3cpp_parallel_download.bin", testing::TempDir());
+    ParallelDownloader downloader(client, { .PartSize = 256 * 1024, .Concurrency = 4 });
+    auto res = downloader.DownloadFile("my-bucket", "download/file.bin", path);
+    if (!res)
+        FAIL() << std::format("DownloadFile failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_EQ(res->ContentLength, body.size());
+
+    std::ifstream in(path, std::ios::binary);
+    std::string downloaded((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    EXPECT_EQ(downloaded.size(), body.size());
+    EXPECT_TRUE(downloaded == body);
+
+    client.DeleteObject("my-bucket", "download/file.bin");
+}
+
+TEST_F(TRANSFER, ParallelDownloadInto) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // Not a multiple of the part size
+    const std::string body = makeBody(100 * 1000 + 3);
+    auto putRes = client.PutObject("my-bucket", "download/buffer.bin", body);
+    if (!putRes)
+        GTEST_FAIL();
+
+    std::vector<std::byte> buffer(body.size());
+    ParallelDownloader downloader(client, { .PartSize = 8 * 1024, .Concurrency = 3 });
+    auto res = downloader.DownloadInto("my-bucket", "download/buffer.bin", buffer);
+    if (!res)
+        FAIL() << std::format("DownloadInto failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_TRUE(std::string_view(reinterpret_cast<const char*>(buffer.data()), buffer.size()) == body);
+
+    std::vector<std::byte> small(body.size() - 1);
+    auto tooSmall = downloader.DownloadInto("my-bucket", "download/buffer.bin", small);
+    if (tooSmall)
+        GTEST_FAIL();
+    EXPECT_EQ(tooSmall.error().Code, "BufferTooSmall");
+
+    client.DeleteObject("my-bucket", "download/buffer.bin");
+}
+
+TEST_F(TRANSFER, ParallelDownloadNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    std::vector<std::byte> buffer(16);
+    ParallelDownloader downloader(client);
+    auto res = downloader.DownloadInto("my-bucket", "download/missing.bin", buffer);
+    EXPECT_FALSE(res.has_value());
+}
+
+namespace {
+
+// Serves `body` as an object, one connection at a time. The first `cuts`
+// ranged GETs get half of their range and then the connection is closed
+struct CuttingServer {
+    std::string body;
+    std::atomic<int> cuts;
+    int listener = -1;
+    std::string endpoint;
+    std::thread thread;
+
+    CuttingServer(std::string body, int cuts)
+        : body(std::move(body))
+        , cuts(cuts) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(listener, 16);
+        socklen_t length = sizeof(address);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+        endpoint = std::format("127.0.0.1:{}", ntohs(address.sin_port));
+        thread = std::thread([this] { serve(); });
+    }
+    ~CuttingServer() {
+        // wakes up accept()
+        shutdown(listener, SHUT_RDWR);
+        thread.join();
+        close(listener);
+    }
+
+    void serve() {
+        while (true) {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0)
+                return;
+            std::string request;
+            char buffer[4096];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                ssize_t n = read(connection, buffer, sizeof(buffer));
+                if (n <= 0)
+                    break;
+                request.append(buffer, n);
+            }
+
+            std::string response;
+            if (request.starts_with("HEAD")) {
+                response = std::format("HTTP/1.1 200 OK\r\nContent-Length: {}\r\nETag: \"etag\"\r\nConnection: close\r\n\r\n", body.size());
+            } else {
+                size_t first = 0, last = 0;
+                std::sscanf(request.c_str() + request.find("Range: bytes="), "Range: bytes=%zu-%zu", &first, &last);
+                std::string_view range = std::string_view(body).substr(first, last - first + 1);
+                response = std::format("HTTP/1.1 206 Partial Content\r\nContent-Length: {}\r\nContent-Range: bytes {}-{}/{}\r\nConnection: close\r\n\r\n", range.size(), first, last, body.size());
+                response += cuts-- > 0 ? range.substr(0, range.size() / 2) : range;
+            }
+            write(connection, response.data(), response.size());
+            close(connection);
+        }
+    }
+};
+
+} // namespace
+
+TEST_F(TRANSFER, ParallelDownloadRestartsCutRanges) {
+    const std::string body = makeBody(64 * 1024);
+    // The client does not retry a body it already handed over, the range is
+    // fetched again by the downloader
+    CuttingServer server(body, 2);
+    S3Client client("minio_access", "minio_secret", server.endpoint, S3AddressingStyle::PathStyle);
+
+    std::vector<std::byte> buffer(body.size());
+    ParallelDownloader downloader(client, { .PartSize = 16 * 1024, .Concurrency = 1 });
+    auto res = downloader.DownloadInto("my-bucket", "download/cut.bin", buffer);
+    if (!res)
+        FAIL() << std::format("DownloadInto failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_TRUE(std::equal(body.begin(), body.end(), reinterpret_cast<const char*>(buffer.data())));
+
+    // Out of attempts, the transport error comes through
+    server.cuts = 1;
+    ParallelDownloader once(client, { .PartSize = 16 * 1024, .Concurrency = 1, .MaxAttempts = 1 });
+    EXPECT_THROW(once.DownloadInto("my-bucket", "download/cut.bin", buffer), HttpTransportError);
+}
+
+TEST_F(TRANSFER, MultipartCopy) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // 2 parts of 5 MiB, the smallest S3 takes, and a smaller last one
+    const std::string body = makeBody(10 * 1024 * 1024 + 1234);
+    auto putRes = client.PutObject("my-bucket", "copy/large.bin", body);
+    if (!putRes)
+        GTEST_FAIL();
+
+    // Small enough to go multipart, with a part size that does not divide the object
+    MultipartCopier copier(client, { .MultipartThreshold = 5 * 1024 * 1024, .PartSize = 5 * 1024 * 1024, .Concurrency = 3 });
+    auto res = copier.Copy("my-bucket", "copy/large.bin", "my-bucket", "copy/large-copy.bin");
+    if (!res)
+        FAIL() << std::format("Copy failed: Code={}, Message={}", res.error().Code, res.error().Message);
+
+    auto getRes = client.GetObject("my-bucket", "copy/large-copy.bin");
+    if (!getRes)
+        GTEST_FAIL();
+    EXPECT_EQ(getRes->size(), body.size());
+    EXPECT_TRUE(*getRes == body);
+
+    // Below the threshold a single CopyObject is used
+    MultipartCopier single(client);
+    auto singleRes = single.Copy("my-bucket", "copy/large.bin", "my-bucket", "copy/single-copy.bin");
+    if (!singleRes)
+        FAIL() << std::format("Copy failed: Code={}, Message={}", singleRes.error().Code, singleRes.error().Message);
+    EXPECT_EQ(singleRes->ETag, putRes->ETag);
+
+    client.DeleteObject("my-bucket", "copy/large.bin");
+    client.DeleteObject("my-bucket", "copy/large-copy.bin");
+    client.DeleteObject("my-bucket", "copy/single-copy.bin");
+}
+
+TEST_F(TRANSFER, MultipartCopyNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    MultipartCopier copier(client);
+    auto res = copier.Copy("my-bucket", "copy/missing.bin", "my-bucket", "copy/missing-copy.bin");
+    if (res)
+        GTEST_FAIL();
+}
+
+TEST_F(TRANSFER, BatchDeletePrefix) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    for (int i = 0; i < 25; i++) {
+        auto putRes = client.PutObject("my-bucket", std::format("batch-delete/file_{}.txt", i), "Body contents");
+        if (!putRes)
+            GTEST_FAIL();
+    }
+
+    BatchDeleter deleter(client);
+    auto res = deleter.DeletePrefix("my-bucket", "batch-delete/");
+    if (!res)
+        FAIL() << std::format("DeletePrefix failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_EQ(res->Deleted, 25);
+    EXPECT_TRUE(res->Errors.empty());
+
+    auto listRes = client.ListObjects("my-bucket", { .Prefix = "batch-delete/" });
+    if (!listRes)
+        GTEST_FAIL();
+    EXPECT_TRUE(listRes->Contents.empty());
+}
+
+TEST_F(TRANSFER, BatchDeleteManyKeys) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    // Deleting keys that do not exist succeeds, 3 batches
+    std::vector<std::string> keys;
+    for (int i = 0; i < 2500; i++)
+        keys.push_back(std::format("batch-delete/missing_{}.txt", i));
+
+    BatchDeleter deleter(client, { .Concurrency = 3 });
+    auto res = deleter.Delete("my-bucket", keys);
+    if (!res)
+        FAIL() << std::format("Delete failed: Code={}, Message={}", res.error().Code, res.error().Message);
+    EXPECT_EQ(res->Deleted, keys.size());
+}
+
+TEST_F(TRANSFER, BatchDeleteBucketNotExists) {
+    S3Client client("minio_access", "minio_secret", "127.0.0.1:9000", S3AddressingStyle::PathStyle);
+
+    BatchDeleter deleter(client);
+    auto res = deleter.DeletePrefix("does-not-exist-bucket", "");
+    EXPECT_FALSE(res.has_value());
+}
@@ -169,3 +169,199 @@ TEST(XML, XMLTrailingSpaces) {
     EXPECT_EQ(XMLValues.size(), 1);
     EXPECT_EQ(XMLValues[0], (XMLNode { .tag = "Bucket", .value = "Name" }));
 }
+
+namespace {
+
+// Records the events as "<name", "=text" and ">name"
+struct EventRecorder {
+    XMLEventParser<EventRecorder>* parser = nullptr;
+    std::vector<std::string> events;
+    std::vector<std::string> paths;
+    std::vector<const char*> textData;
+
+    void startElement(std::string_view name) { events.push_back(std::format("<{}", name)); }
+    void text(std::string_view value) {
+        events.push_back(std::format("={}", value));
+        paths.emplace_back(parser->path());
+        textData.push_back(value.data());
+    }
+    void endElement(std::string_view name) { events.push_back(std::format(">{}", name)); }
+};
+
+const std::string ListPage = R"(<?xml version="1.0" encoding="UTF-8"?>
+<ListBucketResult xmlns="http://s3.amazonaws.com/doc/2006-03-01/"><Name>my-bucket</Name><Contents><Key>a &amp; b &#x1F600;</Key><Size>10</Size></Contents><Contents><Key>c</Key><Owner/></Contents></ListBucketResult>)";
+
+} // namespace
+
+TEST(XML, XMLEvents) {
+    EventRecorder recorder;
+    XMLEventParser<EventRecorder> parser(recorder);
+    recorder.parser = &parser;
+    parser.feed(ListPage);
+    parser.finish();
+
+    const std::vector<std::string> expected = {
+        "<ListBucketResult",
+        "<Name", "=my-bucket", ">Name",
+        "<Contents", "<Key", "=a & b \xF0\x9F\x98\x80", ">Key", "<Size", "=10", ">Size", ">Contents",
+        "<Contents", "<Key", "=c", ">Key", "<Owner", ">Owner", ">Contents",
+        ">ListBucketResult"
+    };
+    EXPECT_EQ(recorder.events, expected);
+    EXPECT_EQ(recorder.paths, (std::vector<std::string> { "ListBucketResult.Name", "ListBucketResult.Contents.Key", "ListBucketResult.Contents.Size", "ListBucketResult.Contents.Key" }));
+    EXPECT_EQ(parser.depth(), 0);
+}
+
+TEST(XML, XMLEventsZeroCopyText) {
+    // Text with no entities that sits whole in a chunk is handed out in place
+    EventRecorder recorder;
+    XMLEventParser<EventRecorder> parser(recorder);
+    recorder.parser = &parser;
+    const std::string xml = "<Bucket><Name>my-bucket</Name></Bucket>";
+    parser.feed(xml);
+    parser.finish();
+    ASSERT_EQ(recorder.textData.size(), 1);
+    EXPECT_EQ(recorder.textData[0], xml.data() + xml.find("my-bucket"));
+}
+
+TEST(XML, XMLEventsIncremental) {
+    EventRecorder whole;
+    XMLEventParser<EventRecorder> wholeParser(whole);
+    whole.parser = &wholeParser;
+    wholeParser.feed(ListPage);
+    wholeParser.finish();
+
+    // Same events whatever the chunk boundaries, splitting names, texts and entities
+    for (size_t chunkSize : { 1, 2, 3, 7, 64 }) {
+        EventRecorder recorder;
+        XMLEventParser<EventRecorder> parser(recorder);
+        recorder.parser = &parser;
+        for (size_t i = 0; i < ListPage.size(); i += chunkSize)
+            parser.feed(std::string_view(ListPage).substr(i, chunkSize));
+        parser.finish();
+        EXPECT_EQ(recorder.events, whole.events) << chunkSize;
+        EXPECT_EQ(recorder.paths, whole.paths) << chunkSize;
+    }
+}
+
+TEST(XML, XMLEventsAttributes) {
+    EventRecorder recorder;
+    XMLEventParser<EventRecorder> parser(recorder);
+    recorder.parser = &parser;
+    parser.feed(R"(<Root a="x > y" b='/'><Leaf  c="1"  >v</Leaf ></Root>)");
+    parser.finish();
+    EXPECT_EQ(recorder.events, (std::vector<std::string> { "<Root", "<Leaf", "=v", ">Leaf", ">Root" }));
+}
+
+TEST(XML, XMLEventsIncomplete) {
+    EventRecorder recorder;
+    XMLEventParser<EventRecorder> parser(recorder);
+    recorder.parser = &parser;
+    parser.feed("<Session><Bucket>Na");
+    EXPECT_ANY_THROW(parser.finish());
+
+    parser.reset();
+    EXPECT_ANY_THROW(parser.feed("<Session></Bucket>"));
+}
+
+namespace {
+
+struct Part {
+    int PartNumber = 0;
+    std::string ETag;
+};
+
+struct Upload {
+    std::string Key;
+    bool IsTruncated = false;
+    struct Owner_ {
+        std::string ID;
+    } Owner;
+    std::vector<Part> Parts;
+};
+
+constexpr XMLFieldTable UploadFields { std::array {
+    xmlField<&Upload::Key>("Upload.Key"),
+    xmlField<&Upload::IsTruncated>("Upload.IsTruncated"),
+    xmlField<&Upload::Owner, &Upload::Owner_::ID>("Upload.Owner.ID"),
+    xmlRecord<&Upload::Parts>("Upload.Part"),
+    xmlRecordField<&Upload::Parts, &Part::PartNumber>("Upload.Part.PartNumber"),
+    xmlRecordField<&Upload::Parts, &Part::ETag>("Upload.Part.ETag"),
+} };
+
+struct UploadHandler {
+    XMLEventParser<UploadHandler>* parser = nullptr;
+    Upload result;
+    const XMLField<Upload>* field = nullptr;
+
+    void startElement(std::string_view) {
+        field = UploadFields.find(parser->path());
+        if (field && field->start)
+            field->start(result);
+    }
+    void text(std::string_view value) {
+        if (field && field->text)
+            field->text(result, value);
+    }
+    void endElement(std::string_view) { }
+};
+
+} // namespace
+
+TEST(XML, XMLFieldTableFind) {
+    ASSERT_NE(UploadFields.find("Upload.Owner.ID"), nullptr);
+    EXPECT_EQ(UploadFields.find("Upload.Owner.ID")->path, "Upload.Owner.ID");
+    EXPECT_NE(UploadFields.find("Upload.Part")->start, nullptr);
+    EXPECT_EQ(UploadFields.find("Upload.Part")->text, nullptr);
+    EXPECT_EQ(UploadFields.find("Upload.Owner"), nullptr);
+    EXPECT_EQ(UploadFields.find("Upload.Key.Extra"), nullptr);
+    EXPECT_EQ(UploadFields.find(""), nullptr);
+}
+
+TEST(XML, XMLFieldTableDispatch) {
+    UploadHandler handler;
+    XMLEventParser<UploadHandler> parser(handler);
+    handler.parser = &parser;
+    parser.feed("<Upload><Key>a&amp;b</Key><IsTruncated>true</IsTruncated><Owner><ID>42</ID></Owner>"
+                "<Part><PartNumber>1</PartNumber><ETag>x</ETag></Part><Unknown>?</Unknown>"
+                "<Part><PartNumber>2</PartNumber></Part></Upload>");
+    parser.finish();
+
+    EXPECT_EQ(handler.result.Key, "a&b");
+    EXPECT_TRUE(handler.result.IsTruncated);
+    EXPECT_EQ(handler.result.Owner.ID, "42");
+    ASSERT_EQ(handler.result.Parts.size(), 2);
+    EXPECT_EQ(handler.result.Parts[0].PartNumber, 1);
+    EXPECT_EQ(handler.result.Parts[0].ETag, "x");
+    EXPECT_EQ(handler.result.Parts[1].PartNumber, 2);
+    EXPECT_EQ(handler.result.Parts[1].ETag, "");
+}
+
+TEST(XML, XMLScanMatchesScalar) {
+    using Scan = XMLScan<'<', '&'>;
+    // Delimiters at every position of the vector blocks and their tails
+    std::string data(100, 'a');
+    for (size_t at = 0; at < data.size(); at++) {
+        for (char delimiter : { '<', '&' }) {
+            std::string text = data;
+            text[at] = delimiter;
+            for (size_t from = 0; from <= at; from += 7) {
+                const char* first = text.data() + from;
+                const char* last = text.data() + text.size();
+                EXPECT_EQ(Scan::find(first, last), text.data() + at) << at << " " << from;
+                EXPECT_EQ(Scan::findScalar(first, last), text.data() + at) << at << " " << from;
+            }
+            EXPECT_EQ(Scan::find(text.data(), text.data() + at), text.data() + at);
+        }
+    }
+    using ScanEnd = XMLScan<'>'>;
+    EXPECT_EQ(ScanEnd::find(data.data(), data.data() + data.size()), data.data() + data.size());
+}
+
+TEST(XML, XMLEventsClosingTagMismatch) {
+    EventRecorder recorder;
+    XMLEventParser<EventRecorder> parser(recorder);
+    recorder.parser = &parser;
+    parser.feed("<Session><Bucket>x</Buck");
+    EXPECT_ANY_THROW(parser.feed("ed>"));
+}